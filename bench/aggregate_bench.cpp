@@ -0,0 +1,76 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "lib/db.h"
+
+namespace {
+
+template<typename Function>
+double Best(Function function) {
+    double best = 0;
+    for (int i = 0; i < 3; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        if (i == 0 || elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+    return best;
+}
+
+}
+
+int main(int argc, char** argv) {
+    int rows = argc > 1 ? std::stoi(argv[1]) : 10000000;
+    DataBase data_base("Bench");
+    data_base.CreateTable("CREATE TABLE orders (order_id INT NOT NULL, supplier_id INT, status VARCHAR(10), price DOUBLE);");
+    std::vector<std::string> statuses = {"new", "paid", "shipped", "done"};
+    const int kBatch = 1000000;
+    for (int begin = 0; begin < rows; begin += kBatch) {
+        std::vector<std::vector<Parameter>> batch;
+        for (int i = begin; i < std::min(rows, begin + kBatch); ++i) {
+            batch.push_back({Parameter(i), Parameter(i % 100000), Parameter(statuses[i % 4]), Parameter(i % 100 * 0.5)});
+        }
+        data_base.BulkInsert("orders", std::move(batch));
+    }
+    data_base.CreateTable("CREATE TABLE suppliers (supplier_id INT NOT NULL, region VARCHAR(10));");
+    std::vector<std::string> regions = {"north", "south", "east", "west", "center"};
+    std::vector<std::vector<Parameter>> suppliers;
+    for (int i = 0; i < 100000; ++i) {
+        suppliers.push_back({Parameter(i), Parameter(regions[i % 5])});
+    }
+    data_base.BulkInsert("suppliers", std::move(suppliers));
+    std::cout << rows << " rows, " << data_base.Parallelism() << " threads\n";
+
+    double client = Best([&]() {
+        std::unordered_map<std::string, std::pair<size_t, double>> groups;
+        ResultSet result = data_base.SelectRequest("SELECT status, price FROM orders;");
+        while (result.Next()) {
+            auto& group = groups[std::string(result.Get<std::string_view>(0))];
+            ++group.first;
+            group.second += result.Get<double>(1);
+        }
+    });
+    std::cout << "  client-side GROUP BY status:  " << client * 1000 << " ms\n";
+
+    auto run = [&](const char* name, const std::string& request) {
+        double seconds = Best([&]() {
+            ResultSet result = data_base.SelectRequest(request);
+            while (result.Next()) {
+            }
+        });
+        std::cout << "  " << name << seconds * 1000 << " ms\n";
+    };
+    run("COUNT/SUM/AVG, no groups:     ", "SELECT COUNT(*), SUM(price), AVG(price), MAX(order_id) FROM orders;");
+    run("GROUP BY status (4 groups):   ", "SELECT status, COUNT(*), SUM(price) FROM orders GROUP BY status;");
+    run("GROUP BY supplier (100K):     ", "SELECT supplier_id, COUNT(*), AVG(price) FROM orders GROUP BY supplier_id;");
+    run("filtered GROUP BY status:     ",
+        "SELECT status, COUNT(*), SUM(price) FROM orders WHERE price < 10.0 GROUP BY status;");
+    run("joined GROUP BY region:       ", "SELECT region, COUNT(*), SUM(price) FROM orders JOIN suppliers "
+                                          "ON orders.supplier_id = suppliers.supplier_id GROUP BY region;");
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lib/db.h"
+
+namespace {
+
+const int kSuppliers = 100000;
+
+// Every thread runs point selects against a shared table and, once in `write_every` operations, an insert
+// into its own table, so readers share a lock and writers only contend with readers of the same table.
+double OperationsPerSecond(DataBase& data_base, size_t threads, size_t write_every,
+                           std::chrono::duration<double> duration) {
+    std::atomic<bool> stop = false;
+    std::atomic<size_t> operations = 0;
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < threads; ++i) {
+        std::string table = "orders_" + std::to_string(threads) + "_" + std::to_string(write_every) + "_"
+                            + std::to_string(i);
+        data_base.CreateTable("CREATE TABLE " + table + " (order_id INT PRIMARY KEY NOT NULL, supplier_id INT);");
+        workers.emplace_back([&data_base, &stop, &operations, table, i, write_every]() {
+            PreparedStatement select = data_base.Prepare("SELECT * FROM suppliers WHERE supplier_id = ?;");
+            PreparedStatement insert = data_base.Prepare("INSERT INTO " + table + " VALUES (?, ?);");
+            size_t done = 0;
+            int key = static_cast<int>(i * 7919);
+            while (!stop.load(std::memory_order_relaxed)) {
+                key = (key * 31 + 17) % kSuppliers;
+                if (write_every != 0 && done % write_every == 0) {
+                    insert.Bind(0, static_cast<int>(done));
+                    insert.Bind(1, key);
+                    insert.Execute();
+                } else {
+                    select.Bind(0, key);
+                    ResultSet result = select.Execute();
+                    while (result.Next()) {
+                    }
+                }
+                ++done;
+            }
+            operations += done;
+        });
+    }
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (auto& i: workers) {
+        i.join();
+    }
+    return static_cast<double>(operations) / duration.count();
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::chrono::duration<double> duration(argc > 1 ? std::stod(argv[1]) : 1.0);
+    DataBase data_base("Bench");
+    data_base.CreateTable("CREATE TABLE suppliers (supplier_id INT PRIMARY KEY NOT NULL, supplier_name VARCHAR(20));");
+    std::vector<std::vector<Parameter>> rows;
+    for (int i = 0; i < kSuppliers; ++i) {
+        rows.push_back({Parameter(i), Parameter(std::string("supplier"))});
+    }
+    data_base.BulkInsert("suppliers", std::move(rows));
+
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t write_every: {0, 10}) {
+        std::cout << (write_every == 0 ? "read only" : "10% writes") << '\n';
+        for (size_t threads = 1; threads <= cores; threads *= 2) {
+            std::cout << "  " << threads << " threads: "
+                      << OperationsPerSecond(data_base, threads, write_every, duration) << " ops/s\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "lib/db.h"
+
+namespace {
+
+const char* kCreate = "(order_id INT PRIMARY KEY NOT NULL, supplier_id INT, price DOUBLE, paid BOOL, comment VARCHAR(40));";
+
+void Fill(DataBase& data_base, size_t rows) {
+    data_base.CreateTable(std::string("CREATE TABLE orders ") + kCreate);
+    constexpr size_t kBatch = 100'000;
+    for (size_t begin = 0; begin < rows; begin += kBatch) {
+        std::vector<std::vector<Parameter>> batch;
+        for (size_t i = begin; i < std::min(rows, begin + kBatch); ++i) {
+            batch.push_back({Parameter(static_cast<int>(i)), Parameter(static_cast<int>(i % 1000)),
+                             Parameter(static_cast<double>(i) / 8), Parameter(i % 2 == 0),
+                             Parameter("comment, order " + std::to_string(i))});
+        }
+        data_base.BulkInsert("orders", std::move(batch));
+    }
+}
+
+template<typename Function>
+double Seconds(Function function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+}
+
+int main(int argc, char** argv) {
+    size_t rows = argc > 1 ? std::stoul(argv[1]) : 5'000'000;
+    std::string path = (std::filesystem::temp_directory_path() / "copy_bench.csv").string();
+    DataBase data_base("Bench");
+    Fill(data_base, rows);
+
+    double export_time = Seconds([&] { data_base.Copy("COPY orders TO '" + path + "';"); });
+    double megabytes = static_cast<double>(std::filesystem::file_size(path)) / (1 << 20);
+    data_base.CreateTable(std::string("CREATE TABLE copy ") + kCreate);
+    double import_time = Seconds([&] { data_base.Copy("COPY copy FROM '" + path + "';"); });
+    std::remove(path.c_str());
+
+    std::cout << rows << " rows, " << megabytes << " MB\n";
+    std::cout << "COPY TO:   " << export_time << " s, " << megabytes / export_time << " MB/s\n";
+    std::cout << "COPY FROM: " << import_time << " s, " << megabytes / import_time << " MB/s\n";
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lib/db.h"
+
+namespace {
+
+template<typename Function>
+double Measure(Function function) {
+    auto begin = std::chrono::steady_clock::now();
+    function();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+    return elapsed.count();
+}
+
+size_t Count(DataBase& data_base, const std::string& request) {
+    ResultSet result = data_base.SelectRequest(request);
+    size_t rows = 0;
+    while (result.Next()) {
+        ++rows;
+    }
+    return rows;
+}
+
+}
+
+int main(int argc, char** argv) {
+    int rows = argc > 1 ? std::stoi(argv[1]) : 10000000;
+    DataBase data_base("Bench");
+    data_base.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, supplier_id INT, price DOUBLE);");
+    const int kBatch = 1000000;
+    for (int begin = 0; begin < rows; begin += kBatch) {
+        std::vector<std::vector<Parameter>> batch;
+        for (int i = begin; i < std::min(rows, begin + kBatch); ++i) {
+            batch.push_back({Parameter(i), Parameter(i % 10), Parameter(i % 100 * 0.5)});
+        }
+        data_base.BulkInsert("orders", std::move(batch));
+    }
+    data_base.CreateIndex("CREATE INDEX orders_price ON orders (price);");
+
+    std::cout << "purging 30% of " << rows << " rows with a primary key and an ordered index\n";
+    double erase = Measure([&]() {
+        data_base.DeleteRequest("DELETE FROM orders WHERE supplier_id < 3;");
+    });
+    std::cout << "  delete (tombstones):  " << erase * 1000 << " ms\n";
+    double collect = Measure([&]() {
+        data_base.CollectGarbage();
+    });
+    std::cout << "  compaction:           " << collect * 1000 << " ms\n";
+    size_t left = 0;
+    double select = Measure([&]() {
+        left = Count(data_base, "SELECT order_id FROM orders WHERE price = 22.5;");
+    });
+    std::cout << "  index lookup after:   " << select * 1000 << " ms, " << left << " rows\n";
+    return 0;
+}
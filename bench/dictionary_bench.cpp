@@ -0,0 +1,106 @@
+#include <bit>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lib/db.h"
+
+namespace {
+
+const int kRows = 5000000;
+const int kRepeats = 5;
+
+template<typename Function>
+double Measure(Function function) {
+    double best = 0;
+    for (int i = 0; i < kRepeats; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        if (i == 0 || elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+    return best;
+}
+
+size_t Count(DataBase& data_base, const std::string& request) {
+    ResultSet result = data_base.SelectRequest(request);
+    size_t rows = 0;
+    while (result.Next()) {
+        ++rows;
+    }
+    return rows;
+}
+
+}
+
+int main() {
+    DataBase data_base("Bench");
+    data_base.CreateTable("CREATE TABLE orders (order_id INT NOT NULL, status VARCHAR(10), order_date VARCHAR(20));");
+    data_base.CreateTable("CREATE TABLE statuses (name VARCHAR(10), rank INT);");
+    std::vector<std::string> statuses = {"new", "paid", "packed", "shipped", "delivered", "returned"};
+    size_t raw_bytes = 0;
+    const int kBatch = 500000;
+    for (int begin = 0; begin < kRows; begin += kBatch) {
+        std::vector<std::vector<Parameter>> rows;
+        for (int i = begin; i < begin + kBatch; ++i) {
+            std::string date = std::to_string(i % 28 + 1) + "." + std::to_string(i / 28 % 12 + 1) + "." +
+                               std::to_string(2000 + i / 336 % 20);
+            raw_bytes += statuses[i % 6].size() + date.size();
+            rows.push_back({Parameter(i), Parameter(statuses[i % 6]), Parameter(date)});
+        }
+        data_base.BulkInsert("orders", std::move(rows));
+    }
+    for (size_t i = 0; i < statuses.size(); ++i) {
+        data_base.Insert("INSERT INTO statuses VALUES (\"" + statuses[i] + "\", " + std::to_string(i) + ");");
+    }
+
+    TableSnapshot snapshot = data_base.GetTables()["orders"].Read();
+    size_t used = 0;
+    for (size_t i: {1, 2}) {
+        const Column& column = snapshot.GetColumn(i);
+        used += column.Entries() * sizeof(size_t) + column.Bytes() + kRows * sizeof(uint32_t);
+        std::cout << "column " << i << ": " << column.Entries() << " entries, " << column.Bytes() << " bytes\n";
+    }
+    // Before the dictionary every row kept an 8 byte offset and its own copy of the string.
+    size_t plain = raw_bytes + 2 * kRows * sizeof(size_t);
+    std::cout << kRows << " rows, two VARCHAR columns: " << plain / (1024.0 * 1024.0) << " MiB as plain strings, "
+              << used / (1024.0 * 1024.0) << " MiB encoded\n";
+
+    // Per row string comparisons are what every scan did before the predicate was encoded.
+    auto statement = std::get<SelectStatement>(
+            Parser("SELECT * FROM orders WHERE status = \"shipped\" OR order_date = \"1.1.2000\";").Parse());
+    Predicate predicate(*statement.where, {{"orders", &data_base.GetTables()["orders"]}});
+    predicate.Attach({&snapshot});
+    size_t expected = 0;
+    double strings = Measure([&]() {
+        expected = 0;
+        for (size_t i = 0; i < snapshot.Size(); ++i) {
+            expected += predicate(i);
+        }
+    });
+    predicate.Encode();
+    size_t matches = 0;
+    std::vector<uint64_t> bits;
+    double codes = Measure([&]() {
+        matches = 0;
+        predicate.Select(0, snapshot.Size(), bits);
+        for (auto i: bits) {
+            matches += std::popcount(i);
+        }
+    });
+    std::cout << "equality filter: " << strings * 1000 << " ms comparing strings, " << codes * 1000
+              << " ms comparing codes" << (matches == expected ? "" : ", WRONG RESULT") << "\n";
+
+    double query = Measure([&]() {
+        matches = Count(data_base, "SELECT order_id FROM orders WHERE status IN (\"new\", \"returned\");");
+    });
+    std::cout << "IN query: " << query * 1000 << " ms, " << matches << " rows\n";
+    double join = Measure([&]() {
+        matches = Count(data_base, "SELECT order_id, rank FROM orders JOIN statuses ON orders.status = statuses.name;");
+    });
+    std::cout << "hash join on codes: " << join * 1000 << " ms, " << matches << " rows\n";
+    return 0;
+}
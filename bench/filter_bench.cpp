@@ -0,0 +1,88 @@
+#include <bit>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lib/db.h"
+#include "lib/filter.h"
+
+namespace {
+
+const int kRows = 10000000;
+const int kRepeats = 5;
+
+// Best time of `kRepeats` runs of `scan`, which returns the number of matching rows.
+template<typename Function>
+double Measure(Function scan, size_t& matches) {
+    double best = 0;
+    for (int i = 0; i < kRepeats; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        matches = scan();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        if (i == 0 || elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+    return best;
+}
+
+void Run(Table& table, const std::string& where) {
+    auto statement = std::get<SelectStatement>(Parser("SELECT * FROM orders WHERE " + where + ";").Parse());
+    Predicate predicate(*statement.where, {{"orders", &table}});
+    TableSnapshot rows = table.Read();
+    predicate.Attach({&rows});
+
+    std::cout << "WHERE " << where << "\n";
+    size_t expected = 0;
+    double per_row = Measure([&]() {
+        size_t matches = 0;
+        for (size_t i = 0; i < rows.Size(); ++i) {
+            matches += predicate(i);
+        }
+        return matches;
+    }, expected);
+    std::cout << "  per row: " << per_row * 1000 << " ms, " << expected << " rows\n";
+
+    for (auto set: {InstructionSet::SCALAR, InstructionSet::SSE2, InstructionSet::AVX2}) {
+        if (set > BestInstructionSet()) {
+            continue;
+        }
+        UseInstructionSet(set);
+        size_t matches = 0;
+        std::vector<uint64_t> bits;
+        double seconds = Measure([&]() {
+            size_t count = 0;
+            predicate.Select(0, rows.Size(), bits);
+            for (auto i: bits) {
+                count += std::popcount(i);
+            }
+            return count;
+        }, matches);
+        std::cout << "  " << InstructionSetName(set) << " kernels: " << seconds * 1000 << " ms, speedup "
+                  << per_row / seconds << (matches == expected ? "" : ", WRONG RESULT") << "\n";
+    }
+    UseInstructionSet(BestInstructionSet());
+}
+
+}
+
+int main() {
+    DataBase data_base("Bench");
+    data_base.CreateTable("CREATE TABLE orders (order_id INT NOT NULL, supplier_id INT, price DOUBLE, "
+                          "weight FLOAT, paid BOOL);");
+    std::vector<std::vector<Parameter>> rows;
+    for (int i = 0; i < kRows; ++i) {
+        rows.push_back({Parameter(i), Parameter(i % 100), Parameter(i % 1000 * 0.5), Parameter(float(i % 37)),
+                        Parameter(i % 3 == 0)});
+    }
+    data_base.BulkInsert("orders", std::move(rows));
+    Table& table = data_base.GetTables()["orders"];
+
+    std::cout << "filter kernels, " << kRows << " rows\n";
+    Run(table, "supplier_id = 42");
+    Run(table, "price < 100.0");
+    Run(table, "weight >= 10.0 AND paid = TRUE");
+    Run(table, "supplier_id < order_id OR price > 450.0");
+    return 0;
+}
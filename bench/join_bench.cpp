@@ -0,0 +1,64 @@
+#include <chrono>
+#include <iostream>
+
+#include "lib/db.h"
+
+namespace {
+
+void Fill(DataBase& data_base, size_t orders, size_t suppliers) {
+    data_base.CreateTable("CREATE TABLE suppliers (supplier_id INT PRIMARY KEY NOT NULL, supplier_name VARCHAR(20));");
+    data_base.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, supplier_id INT NOT NULL);");
+    PreparedStatement insert_supplier = data_base.Prepare("INSERT INTO suppliers VALUES (?, ?);");
+    for (size_t i = 0; i < suppliers; ++i) {
+        insert_supplier.Bind(0, static_cast<int>(i));
+        insert_supplier.Bind(1, "supplier_" + std::to_string(i));
+        insert_supplier.Execute();
+    }
+    PreparedStatement insert_order = data_base.Prepare("INSERT INTO orders VALUES (?, ?);");
+    for (size_t i = 0; i < orders; ++i) {
+        insert_order.Bind(0, static_cast<int>(i));
+        insert_order.Bind(1, static_cast<int>((i * 7919) % (suppliers + suppliers / 10)));
+        insert_order.Execute();
+    }
+}
+
+double Seconds(JoinCursor& cursor, size_t& rows) {
+    rows = 0;
+    size_t left;
+    size_t right;
+    auto start = std::chrono::steady_clock::now();
+    while (cursor.Next(left, right)) {
+        ++rows;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+void Run(size_t orders, size_t suppliers, bool nested_loop) {
+    DataBase data_base("Bench");
+    Fill(data_base, orders, suppliers);
+    TableSnapshot left = data_base.GetTables()["orders"].Read();
+    TableSnapshot right = data_base.GetTables()["suppliers"].Read();
+
+    std::cout << orders << " orders x " << suppliers << " suppliers (LEFT JOIN ON =)\n";
+    size_t rows;
+    double hash = Seconds(*MakeHashJoin(left, 1, right, 0, JoinType::LEFT), rows);
+    std::cout << "  hash join:   " << hash * 1000 << " ms, " << rows << " rows\n";
+    if (nested_loop) {
+        NestedLoopJoin nested_loop(left, 1, right, 0, CompareOperator::EQUAL, JoinType::LEFT);
+        double loop = Seconds(nested_loop, rows);
+        std::cout << "  nested loop: " << loop * 1000 << " ms, " << rows << " rows\n";
+        std::cout << "  speedup:     " << loop / hash << "x\n";
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    size_t orders = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    size_t suppliers = argc > 2 ? std::stoul(argv[2]) : 100000;
+
+    Run(orders / 50, suppliers / 50, true);
+    Run(orders, suppliers, false);
+    return 0;
+}
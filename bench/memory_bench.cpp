@@ -0,0 +1,105 @@
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <unordered_map>
+
+#include "lib/db.h"
+
+namespace {
+
+size_t live_bytes = 0;
+
+constexpr size_t kHeader = alignof(std::max_align_t);
+
+// The per-row layout of Element before rows shared the table schema.
+struct LegacyElement {
+    std::string primary_parameter_;
+    std::unordered_map<std::string, Parameter> parameters_;
+    std::unordered_map<std::string, TYPE> parameter_list_;
+    std::vector<std::string> order_;
+};
+
+template<typename Function>
+size_t MeasureBytes(Function function) {
+    size_t before = live_bytes;
+    function();
+    return live_bytes - before;
+}
+
+void Report(const char* name, size_t bytes, size_t rows) {
+    double per_million = static_cast<double>(bytes) / static_cast<double>(rows) * 1000000.0;
+    std::cout << name << per_million / (1024.0 * 1024.0) << " MiB per 1M rows ("
+              << static_cast<double>(bytes) / static_cast<double>(rows) << " bytes/row)\n";
+}
+
+}
+
+void* operator new(size_t size) {
+    auto* memory = static_cast<char*>(std::malloc(size + kHeader));
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    *reinterpret_cast<size_t*>(memory) = size;
+    live_bytes += size;
+    return memory + kHeader;
+}
+
+void operator delete(void* pointer) noexcept {
+    if (pointer == nullptr) {
+        return;
+    }
+    char* memory = static_cast<char*>(pointer) - kHeader;
+    live_bytes -= *reinterpret_cast<size_t*>(memory);
+    std::free(memory);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    operator delete(pointer);
+}
+
+int main(int argc, char** argv) {
+    size_t rows = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+    DataBase data_base("Bench");
+    data_base.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, supplier_id INT NOT NULL, "
+                          "order_date VARCHAR(20));");
+    data_base.GetTables()["orders"].Reserve(rows);
+
+    std::vector<LegacyElement> legacy;
+    legacy.reserve(rows);
+
+    size_t legacy_bytes = MeasureBytes([&]() {
+        std::unordered_map<std::string, TYPE> parameter_list{
+                {"order_id", TYPE::INT}, {"supplier_id", TYPE::INT}, {"order_date", TYPE::STRING}};
+        std::vector<std::string> order{"order_id", "supplier_id", "order_date"};
+        for (size_t i = 0; i < rows; ++i) {
+            LegacyElement element;
+            element.parameter_list_ = parameter_list;
+            element.order_ = order;
+            element.parameters_["order_id"] = static_cast<int>(i);
+            element.parameters_["supplier_id"] = static_cast<int>(i % 100);
+            element.parameters_["order_date"] = std::string("05.05.2015");
+            legacy.push_back(std::move(element));
+        }
+    });
+    legacy_bytes += legacy.capacity() * sizeof(LegacyElement);
+    legacy.clear();
+    legacy.shrink_to_fit();
+
+    PreparedStatement insert = data_base.Prepare("INSERT INTO orders VALUES (?, ?, ?);");
+    size_t columnar_bytes = MeasureBytes([&]() {
+        for (size_t i = 0; i < rows; ++i) {
+            insert.Bind(0, static_cast<int>(i));
+            insert.Bind(1, static_cast<int>(i % 100));
+            insert.Bind(2, "05.05.2015");
+            insert.Execute();
+        }
+    });
+
+    Report("per-row hash maps:  ", legacy_bytes, rows);
+    Report("columnar storage:   ", columnar_bytes, rows);
+    std::cout << "reduction:          " << static_cast<double>(legacy_bytes) / static_cast<double>(columnar_bytes)
+              << "x\n";
+    return 0;
+}
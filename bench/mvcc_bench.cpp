@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lib/db.h"
+
+namespace {
+
+const int kRows = 1000000;
+const int kInserts = 20000;
+
+// Inserts and updates rows one at a time while `scanners` threads keep reading the whole table, and
+// reports how long the writer waited per statement.
+void Run(DataBase& data_base, size_t scanners) {
+    std::atomic<bool> stop = false;
+    std::atomic<size_t> scans = 0;
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < scanners; ++i) {
+        workers.emplace_back([&data_base, &stop, &scans]() {
+            while (!stop.load(std::memory_order_relaxed)) {
+                ResultSet result = data_base.SelectRequest("SELECT * FROM orders WHERE price > 0.5;");
+                while (result.Next()) {
+                }
+                ++scans;
+            }
+        });
+    }
+
+    static int next = kRows;
+    PreparedStatement insert = data_base.Prepare("INSERT INTO orders VALUES (?, ?, 1.0);");
+    PreparedStatement update = data_base.Prepare("UPDATE orders SET price = 2.0 WHERE order_id = ?;");
+    std::vector<double> latencies;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kInserts; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        insert.Bind(0, next);
+        insert.Bind(1, next % 100);
+        insert.Execute();
+        update.Bind(0, next++ - kRows / 2);
+        update.Execute();
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - begin;
+        latencies.push_back(elapsed.count());
+    }
+    std::chrono::duration<double> total = std::chrono::steady_clock::now() - start;
+    stop = true;
+    for (auto& i: workers) {
+        i.join();
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << "  " << scanners << " scanners: " << 2 * kInserts / total.count() << " writes/s, p50 "
+              << latencies[latencies.size() / 2] << " us, p99 " << latencies[latencies.size() * 99 / 100]
+              << " us, max " << latencies.back() << " us, " << scans << " full scans\n";
+}
+
+}
+
+int main() {
+    DataBase data_base("Bench");
+    data_base.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, supplier_id INT, price DOUBLE);");
+    std::vector<std::vector<Parameter>> rows;
+    for (int i = 0; i < kRows; ++i) {
+        rows.push_back({Parameter(i), Parameter(i % 100), Parameter(i % 7 * 0.25)});
+    }
+    data_base.BulkInsert("orders", std::move(rows));
+
+    std::cout << "insert + update latency, " << kRows << " rows\n";
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t scanners = 0; scanners <= cores; scanners = scanners == 0 ? 1 : scanners * 2) {
+        Run(data_base, scanners);
+    }
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lib/db.h"
+
+namespace {
+
+template<typename Function>
+double Best(Function function) {
+    double best = 0;
+    for (int i = 0; i < 3; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        if (i == 0 || elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+    return best;
+}
+
+}
+
+int main(int argc, char** argv) {
+    int rows = argc > 1 ? std::stoi(argv[1]) : 10000000;
+    DataBase data_base("Bench");
+    data_base.CreateTable("CREATE TABLE orders (order_id INT NOT NULL, supplier_id INT, status VARCHAR(10), price DOUBLE);");
+    std::vector<std::string> statuses = {"new", "paid", "shipped", "done"};
+    const int kBatch = 1000000;
+    for (int begin = 0; begin < rows; begin += kBatch) {
+        std::vector<std::vector<Parameter>> batch;
+        for (int i = begin; i < std::min(rows, begin + kBatch); ++i) {
+            batch.push_back({Parameter(i), Parameter(i % 100000), Parameter(statuses[i % 4]),
+                             Parameter(static_cast<double>(static_cast<uint32_t>(i * 2654435761U) % 1000000) / 100)});
+        }
+        data_base.BulkInsert("orders", std::move(batch));
+    }
+    std::cout << rows << " rows, " << data_base.Parallelism() << " threads\n";
+
+    double client = Best([&]() {
+        std::vector<std::pair<double, int>> values;
+        ResultSet result = data_base.SelectRequest("SELECT order_id, price FROM orders;");
+        while (result.Next()) {
+            values.emplace_back(result.Get<double>(1), result.Get<int>(0));
+        }
+        std::partial_sort(values.begin(), values.begin() + 10, values.end());
+    });
+    std::cout << "  client-side top 10 by price:  " << client * 1000 << " ms\n";
+    double client_sort = Best([&]() {
+        std::vector<std::pair<double, int>> values;
+        ResultSet result = data_base.SelectRequest("SELECT order_id, price FROM orders;");
+        while (result.Next()) {
+            values.emplace_back(result.Get<double>(1), result.Get<int>(0));
+        }
+        std::stable_sort(values.begin(), values.end(), [](const auto& first, const auto& second) {
+            return first.first < second.first;
+        });
+    });
+    std::cout << "  client-side sort by price:    " << client_sort * 1000 << " ms\n";
+
+    auto run = [&](const char* name, const std::string& request) {
+        double seconds = Best([&]() {
+            ResultSet result = data_base.SelectRequest(request);
+            while (result.Next()) {
+            }
+        });
+        std::cout << "  " << name << seconds * 1000 << " ms\n";
+    };
+    run("ORDER BY price LIMIT 10:      ", "SELECT order_id, price FROM orders ORDER BY price LIMIT 10;");
+    run("ORDER BY status, price DESC:  ",
+        "SELECT order_id, price FROM orders ORDER BY status, price DESC LIMIT 100 OFFSET 100;");
+    run("ORDER BY price, all rows:     ", "SELECT order_id, price FROM orders ORDER BY price;");
+    run("WHERE ... LIMIT 10, no order: ", "SELECT order_id FROM orders WHERE status = \"done\" LIMIT 10;");
+    data_base.CreateIndex("CREATE INDEX orders_price ON orders (price);");
+    run("indexed ORDER BY LIMIT 10:    ", "SELECT order_id, price FROM orders ORDER BY price LIMIT 10;");
+    return 0;
+}
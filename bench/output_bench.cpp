@@ -0,0 +1,70 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "lib/db.h"
+#include "lib/formatter.h"
+
+namespace {
+
+void Fill(DataBase& data_base, size_t rows) {
+    data_base.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, price DOUBLE, comment VARCHAR(20));");
+    PreparedStatement insert = data_base.Prepare("INSERT INTO orders VALUES (?, ?, ?);");
+    for (size_t i = 0; i < rows; ++i) {
+        insert.Bind(0, static_cast<int>(i));
+        insert.Bind(1, static_cast<double>(i) / 8);
+        insert.Bind(2, "order_" + std::to_string(i % 1000));
+        insert.Execute();
+    }
+}
+
+void Legacy(ResultSet& result) {
+    while (result.Next()) {
+        for (size_t i = 0; i < result.GetColumns().size(); ++i) {
+            if (result.IsNull(i)) {
+                std::cout << "NULL";
+            } else {
+                result.GetParameter(i).Print();
+            }
+            std::cout << " ";
+        }
+        std::cout << "\n";
+    }
+}
+
+template<typename Function>
+double Seconds(Function function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    std::cout.flush();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+}
+
+int main(int argc, char** argv) {
+    size_t rows = argc > 1 ? std::stoul(argv[1]) : 10'000'000;
+    DataBase data_base("Bench");
+    Fill(data_base, rows);
+
+    std::ofstream null("/dev/null");
+    std::streambuf* console = std::cout.rdbuf(null.rdbuf());
+    ResultSet legacy_result = data_base.SelectRequest("SELECT * FROM orders;");
+    double legacy = Seconds([&legacy_result] { Legacy(legacy_result); });
+    double results[3];
+    Format formats[] = {Format::TEXT, Format::CSV, Format::BINARY};
+    for (size_t i = 0; i < 3; ++i) {
+        ResultSet result = data_base.SelectRequest("SELECT * FROM orders;");
+        results[i] = Seconds([&result, &formats, i] { Write(result, std::cout, formats[i]); });
+    }
+    std::cout.rdbuf(console);
+
+    std::cout << rows << " rows\n";
+    std::cout << "legacy iostream: " << legacy << " s\n";
+    std::cout << "buffered text:   " << results[0] << " s (" << legacy / results[0] << "x)\n";
+    std::cout << "buffered csv:    " << results[1] << " s\n";
+    std::cout << "buffered binary: " << results[2] << " s\n";
+    return 0;
+}
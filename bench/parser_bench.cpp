@@ -0,0 +1,107 @@
+#include <chrono>
+#include <iostream>
+#include <regex>
+
+#include "lib/Parser.h"
+
+namespace {
+
+const std::vector<std::string> requests{
+        "INSERT INTO orders VALUES (125, 0, \"05.05.2015\");",
+        "INSERT INTO orders (order_id, supplier_id) VALUES (126, 1);",
+        "SELECT * FROM orders WHERE order_id = 126 OR order_id = 127;",
+        "SELECT suppliers.supplier_id, orders.order_date FROM suppliers LEFT JOIN orders ON suppliers.supplier_id = orders.supplier_id;",
+        "UPDATE orders SET order_id = 228 WHERE supplier_id = 0;",
+        "DELETE FROM orders WHERE order_id = 125;",
+};
+
+void LegacySplitString(const std::string& input, std::vector<std::string>& result) {
+    std::regex split_element(R"(\s*,\s*)");
+    std::sregex_token_iterator iter(input.begin(), input.end(), split_element, -1);
+    std::sregex_token_iterator end;
+    while (iter != end) {
+        result.push_back(*iter);
+        ++iter;
+    }
+}
+
+std::vector<std::string> LegacyTokenize(const std::string& string) {
+    std::regex regex(R"((\b\w+\b)|([()])|(>=|<=|<|>|=)|(\"([^\"]*)\")|(OR|AND))");
+    std::smatch match;
+    std::vector<std::string> elements;
+    std::string tmp = string;
+    while (std::regex_search(tmp, match, regex)) {
+        elements.push_back(match.str(0));
+        tmp = match.suffix();
+    }
+    return elements;
+}
+
+// The regex matching the entry points of DataBase performed before the hand-written parser.
+size_t LegacyParse(const std::string& request) {
+    std::smatch match;
+    std::vector<std::string> parts;
+    std::regex insert(R"(\bINSERT\s+INTO\s+(\w+)\s*(\(([\w\s,]+)\))?\s+VALUES\s*\(([^;]+)\);)");
+    if (std::regex_match(request, match, insert)) {
+        LegacySplitString(match[3].str(), parts);
+        LegacySplitString(match[4].str(), parts);
+        std::regex quotes(R"(["'])");
+        for (auto& i: parts) {
+            i = std::regex_replace(i, quotes, "");
+        }
+        return parts.size();
+    }
+    std::regex select1(R"(SELECT\s+(.*?)\s+FROM\s+(.*?);)");
+    std::regex select2(R"(SELECT\s+(.*?)\s+FROM\s+(.*?)\s*(LEFT|RIGHT|INNER)?\s+JOIN\s+(.*?)\s+ON\s+(.*?);)");
+    std::regex select3(R"(SELECT\s+(.*?)\s+FROM\s+(.*?)\s+WHERE\s+(.*?);)");
+    std::regex select4(
+            R"(SELECT\s+(.*?)\s+FROM\s+(.*?)\s*(LEFT|RIGHT|INNER)?\s+JOIN\s+(.*?)\s+ON\s+(.*?)\s+WHERE\s+(.*?);)");
+    if (std::regex_match(request, match, select4) || std::regex_match(request, match, select3)) {
+        LegacySplitString(match[1].str(), parts);
+        return parts.size() + LegacyTokenize(match[match.size() - 1].str()).size();
+    }
+    if (std::regex_match(request, match, select2) || std::regex_match(request, match, select1)) {
+        LegacySplitString(match[1].str(), parts);
+        return parts.size();
+    }
+    std::regex update(R"(\s*UPDATE\s+(\w+)\s+SET\s+(.*)\s+WHERE\s+(.*);)");
+    if (std::regex_match(request, match, update)) {
+        LegacySplitString(match[2].str(), parts);
+        return parts.size() + LegacyTokenize(match[3].str()).size();
+    }
+    std::regex remove(R"(DELETE\s+FROM\s+(\w+)\s+WHERE\s+(.*);)");
+    if (std::regex_match(request, match, remove)) {
+        return LegacyTokenize(match[2].str()).size();
+    }
+    return 0;
+}
+
+template<typename Function>
+double StatementsPerSecond(size_t iterations, Function function) {
+    size_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        checksum += function(requests[i % requests.size()]);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (checksum == 0) {
+        std::cerr << "unexpected empty parse\n";
+    }
+    return static_cast<double>(iterations) / elapsed.count();
+}
+
+}
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::stoul(argv[1]) : 200000;
+
+    double before = StatementsPerSecond(iterations / 20, LegacyParse);
+    double after = StatementsPerSecond(iterations, [](const std::string& request) {
+        return Parser(request).Parse().index() + 1;
+    });
+
+    std::cout << "regex matching:     " << before << " statements/s\n";
+    std::cout << "recursive descent:  " << after << " statements/s\n";
+    std::cout << "speedup:            " << after / before << "x\n";
+    return 0;
+}
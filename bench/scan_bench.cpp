@@ -0,0 +1,58 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lib/db.h"
+
+namespace {
+
+// Runs a filtered scan that keeps about one row in seven and reports its time at `parallelism` threads.
+double Run(DataBase& data_base, size_t parallelism, int repeats) {
+    data_base.SetParallelism(parallelism);
+    double best = 0;
+    for (int i = 0; i < repeats; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        ResultSet result = data_base.SelectRequest("SELECT order_id FROM orders WHERE supplier_id = 3 AND price < 40.0;");
+        size_t rows = 0;
+        while (result.Next()) {
+            ++rows;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        if (i == 0 || elapsed.count() < best) {
+            best = elapsed.count();
+        }
+        if (rows == 0) {
+            std::cerr << "empty result\n";
+        }
+    }
+    return best;
+}
+
+}
+
+int main(int argc, char** argv) {
+    int rows = argc > 1 ? std::stoi(argv[1]) : 10000000;
+    DataBase data_base("Bench");
+    data_base.CreateTable("CREATE TABLE orders (order_id INT NOT NULL, supplier_id INT, price DOUBLE);");
+    const int kBatch = 1000000;
+    for (int begin = 0; begin < rows; begin += kBatch) {
+        std::vector<std::vector<Parameter>> batch;
+        for (int i = begin; i < std::min(rows, begin + kBatch); ++i) {
+            batch.push_back({Parameter(i), Parameter(i % 7), Parameter(i % 100 * 0.5)});
+        }
+        data_base.BulkInsert("orders", std::move(batch));
+    }
+
+    std::cout << "filtered scan, " << rows << " rows\n";
+    double serial = 0;
+    for (size_t parallelism = 1; parallelism <= HardwareParallelism(); parallelism *= 2) {
+        double seconds = Run(data_base, parallelism, 3);
+        if (parallelism == 1) {
+            serial = seconds;
+        }
+        std::cout << "  " << parallelism << " threads: " << seconds * 1000 << " ms, " << rows / seconds / 1e6
+                  << " M rows/s, speedup " << serial / seconds << "\n";
+    }
+    return 0;
+}
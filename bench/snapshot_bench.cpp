@@ -0,0 +1,54 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "lib/db.h"
+
+namespace {
+
+void Fill(DataBase& data_base, size_t rows) {
+    data_base.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, supplier_id INT, price DOUBLE, "
+                          "paid BOOL, comment VARCHAR(40));");
+    constexpr size_t kBatch = 100'000;
+    for (size_t begin = 0; begin < rows; begin += kBatch) {
+        std::vector<std::vector<Parameter>> batch;
+        for (size_t i = begin; i < std::min(rows, begin + kBatch); ++i) {
+            batch.push_back({Parameter(static_cast<int>(i)), Parameter(static_cast<int>(i % 1000)),
+                             Parameter(static_cast<double>(i) / 8), Parameter(i % 2 == 0),
+                             Parameter("comment " + std::to_string(i))});
+        }
+        data_base.BulkInsert("orders", std::move(batch));
+    }
+}
+
+template<typename Function>
+double Seconds(Function function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+}
+
+int main(int argc, char** argv) {
+    size_t rows = argc > 1 ? std::stoul(argv[1]) : 10'000'000;
+    std::string path = (std::filesystem::temp_directory_path() / "snapshot_bench.db").string();
+    double save_time;
+    {
+        DataBase data_base("Bench");
+        Fill(data_base, rows);
+        save_time = Seconds([&] { data_base.Save(path); });
+    }
+    double megabytes = static_cast<double>(std::filesystem::file_size(path)) / (1 << 20);
+    DataBase data_base;
+    double load_time = Seconds([&] { data_base.Load(path); });
+    std::remove(path.c_str());
+
+    std::cout << rows << " rows, " << megabytes << " MB\n";
+    std::cout << "Save: " << save_time << " s, " << megabytes / save_time << " MB/s\n";
+    std::cout << "Load: " << load_time << " s, " << megabytes / load_time << " MB/s\n";
+    return 0;
+}
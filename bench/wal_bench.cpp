@@ -0,0 +1,53 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include "lib/db.h"
+
+namespace {
+
+double CommitsPerSecond(const std::string& path, WalOptions options, std::chrono::duration<double> duration) {
+    std::remove(path.c_str());
+    DataBase data_base("Bench");
+    data_base.OpenLog(path, options);
+    data_base.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, supplier_id INT, comment VARCHAR(20));");
+    PreparedStatement insert = data_base.Prepare("INSERT INTO orders VALUES (?, ?, ?);");
+    size_t commits = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed{};
+    while (elapsed < duration) {
+        for (size_t i = 0; i < 64; ++i, ++commits) {
+            insert.Bind(0, static_cast<int>(commits));
+            insert.Bind(1, static_cast<int>(commits % 100));
+            insert.Bind(2, "order");
+            insert.Execute();
+        }
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    data_base.CloseLog();
+    elapsed = std::chrono::steady_clock::now() - start;
+    std::remove(path.c_str());
+    return static_cast<double>(commits) / elapsed.count();
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::chrono::duration<double> duration(argc > 1 ? std::stod(argv[1]) : 2.0);
+    std::string path = (std::filesystem::temp_directory_path() / "wal_bench.log").string();
+
+    std::cout << "none:              " << CommitsPerSecond(path, {SyncPolicy::NONE}, duration) << " commits/s\n";
+    std::cout << "fsync per commit:  " << CommitsPerSecond(path, {SyncPolicy::STATEMENT}, duration) << " commits/s\n";
+    for (size_t records: {16, 256}) {
+        std::cout << "every " << records << " records: "
+                  << CommitsPerSecond(path, {SyncPolicy::RECORDS, records}, duration) << " commits/s\n";
+    }
+    for (int interval: {1, 10}) {
+        std::cout << "every " << interval << " ms:       "
+                  << CommitsPerSecond(path, {SyncPolicy::INTERVAL, 0, std::chrono::milliseconds(interval)}, duration)
+                  << " commits/s\n";
+    }
+    return 0;
+}
@@ -1,5 +1,4 @@
 #include <iostream>
-#include <windows.h>
 #include "lib/db.h"
 
 int main() {
@@ -24,6 +23,6 @@ int main() {
     d.Insert(input);
 //    std::string sqlQuery = "SELECT suppliers.supplier_id, suppliers.supplier_name, orders.order_date FROM suppliers LEFT JOIN orders ON suppliers.supplier_id = orders.supplier_id;";
     std::string sql_request = "SELECT * FROM orders WHERE order_id = 126 OR order_id = 127;";
-    d.SelectRequest(sql_request);
+    d.SelectRequest(sql_request).Print();
     return 0;
 }
@@ -1 +1,580 @@
+#include "Parser.h"
 
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <stdexcept>
+
+namespace {
+
+bool IsIdentifierStart(char symbol) {
+    return (symbol >= 'a' && symbol <= 'z') || (symbol >= 'A' && symbol <= 'Z') || symbol == '_';
+}
+
+bool IsDigitSymbol(char symbol) {
+    return symbol >= '0' && symbol <= '9';
+}
+
+bool IsIdentifierSymbol(char symbol) {
+    return IsIdentifierStart(symbol) || IsDigitSymbol(symbol);
+}
+
+bool EqualsIgnoreCase(std::string_view first, std::string_view second) {
+    if (first.size() != second.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < first.size(); ++i) {
+        char a = first[i];
+        char b = second[i];
+        if (a >= 'a' && a <= 'z') {
+            a = static_cast<char>(a - 'a' + 'A');
+        }
+        if (b >= 'a' && b <= 'z') {
+            b = static_cast<char>(b - 'a' + 'A');
+        }
+        if (a != b) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+Token Lexer::Next() {
+    while (position_ < input_.size() && std::isspace(static_cast<unsigned char>(input_[position_]))) {
+        ++position_;
+    }
+    if (position_ == input_.size()) {
+        return {TokenType::END, {}};
+    }
+
+    size_t start = position_;
+    char symbol = input_[position_];
+
+    if (IsIdentifierStart(symbol)) {
+        while (position_ < input_.size() && IsIdentifierSymbol(input_[position_])) {
+            ++position_;
+        }
+        return {TokenType::IDENTIFIER, input_.substr(start, position_ - start)};
+    }
+
+    if (IsDigitSymbol(symbol) ||
+        (symbol == '-' && position_ + 1 < input_.size() && IsDigitSymbol(input_[position_ + 1]))) {
+        ++position_;
+        while (position_ < input_.size() && IsDigitSymbol(input_[position_])) {
+            ++position_;
+        }
+        if (position_ + 1 < input_.size() && input_[position_] == '.' && IsDigitSymbol(input_[position_ + 1])) {
+            ++position_;
+            while (position_ < input_.size() && IsDigitSymbol(input_[position_])) {
+                ++position_;
+            }
+        }
+        return {TokenType::NUMBER, input_.substr(start, position_ - start)};
+    }
+
+    if (symbol == '"' || symbol == '\'') {
+        size_t end = input_.find(symbol, position_ + 1);
+        if (end == std::string_view::npos) {
+            throw std::runtime_error("Syntax error");
+        }
+        position_ = end + 1;
+        return {TokenType::STRING, input_.substr(start + 1, end - start - 1)};
+    }
+
+    if (position_ + 1 < input_.size()) {
+        std::string_view pair = input_.substr(position_, 2);
+        if (pair == "<=" || pair == ">=" || pair == "!=" || pair == "<>") {
+            position_ += 2;
+            return {TokenType::SYMBOL, pair};
+        }
+    }
+
+    switch (symbol) {
+        case '(':
+        case ')':
+        case ',':
+        case ';':
+        case '.':
+        case '*':
+        case '=':
+        case '<':
+        case '>':
+        case '?':
+            ++position_;
+            return {TokenType::SYMBOL, input_.substr(start, 1)};
+        default:
+            throw std::runtime_error("Syntax error");
+    }
+}
+
+Parser::Parser(std::string_view request) : lexer_(request) {
+    Advance();
+}
+
+void Parser::Advance() {
+    current_ = lexer_.Next();
+}
+
+bool Parser::IsKeyword(std::string_view keyword) const {
+    return current_.type == TokenType::IDENTIFIER && EqualsIgnoreCase(current_.text, keyword);
+}
+
+bool Parser::IsSymbol(std::string_view symbol) const {
+    return current_.type == TokenType::SYMBOL && current_.text == symbol;
+}
+
+bool Parser::AcceptKeyword(std::string_view keyword) {
+    if (IsKeyword(keyword)) {
+        Advance();
+        return true;
+    }
+    return false;
+}
+
+bool Parser::AcceptSymbol(std::string_view symbol) {
+    if (IsSymbol(symbol)) {
+        Advance();
+        return true;
+    }
+    return false;
+}
+
+void Parser::ExpectKeyword(std::string_view keyword) {
+    if (!AcceptKeyword(keyword)) {
+        throw std::runtime_error("Syntax error");
+    }
+}
+
+void Parser::ExpectSymbol(std::string_view symbol) {
+    if (!AcceptSymbol(symbol)) {
+        throw std::runtime_error("Syntax error");
+    }
+}
+
+std::string Parser::ExpectIdentifier() {
+    if (current_.type != TokenType::IDENTIFIER) {
+        throw std::runtime_error("Syntax error");
+    }
+    std::string identifier(current_.text);
+    Advance();
+    return identifier;
+}
+
+void Parser::ExpectEnd() {
+    AcceptSymbol(";");
+    if (current_.type != TokenType::END) {
+        throw std::runtime_error("Syntax error");
+    }
+}
+
+Literal Parser::ParseLiteral() {
+    Literal literal;
+    if (current_.type == TokenType::NUMBER) {
+        const char* first = current_.text.data();
+        const char* last = first + current_.text.size();
+        if (current_.text.find('.') == std::string_view::npos) {
+            int number;
+            auto result = std::from_chars(first, last, number);
+            if (result.ec == std::errc() && result.ptr == last) {
+                literal.value = number;
+                Advance();
+                return literal;
+            }
+        }
+        double number;
+        auto result = std::from_chars(first, last, number);
+        if (result.ec != std::errc() || result.ptr != last) {
+            throw std::logic_error("Bad cast");
+        }
+        literal.value = number;
+    } else if (current_.type == TokenType::STRING) {
+        literal.value = std::string(current_.text);
+    } else if (IsKeyword("true") || IsKeyword("false")) {
+        literal.value = IsKeyword("true");
+    } else if (IsSymbol("?")) {
+        literal.is_placeholder = true;
+        literal.index = placeholders_++;
+    } else if (!IsKeyword("NULL")) {
+        throw std::runtime_error("Syntax error");
+    }
+    Advance();
+    return literal;
+}
+
+ColumnReference Parser::ParseColumnReference() {
+    ColumnReference reference;
+    reference.column = ExpectIdentifier();
+    if (AcceptSymbol(".")) {
+        reference.table = std::move(reference.column);
+        reference.column = ExpectIdentifier();
+    }
+    return reference;
+}
+
+Operand Parser::ParseOperand() {
+    Operand operand;
+    if (current_.type == TokenType::IDENTIFIER && !IsKeyword("true") && !IsKeyword("false") && !IsKeyword("NULL")) {
+        operand.is_column = true;
+        operand.column = ParseColumnReference();
+    } else {
+        operand.literal = ParseLiteral();
+    }
+    return operand;
+}
+
+CompareOperator Parser::ParseCompareOperator() {
+    CompareOperator sign;
+    if (IsSymbol("=")) {
+        sign = CompareOperator::EQUAL;
+    } else if (IsSymbol("!=") || IsSymbol("<>")) {
+        sign = CompareOperator::NOT_EQUAL;
+    } else if (IsSymbol("<")) {
+        sign = CompareOperator::LESS;
+    } else if (IsSymbol(">")) {
+        sign = CompareOperator::GREATER;
+    } else if (IsSymbol("<=")) {
+        sign = CompareOperator::LESS_EQUAL;
+    } else if (IsSymbol(">=")) {
+        sign = CompareOperator::GREATER_EQUAL;
+    } else {
+        throw std::runtime_error("Syntax error");
+    }
+    Advance();
+    return sign;
+}
+
+Condition Parser::ParseOr() {
+    Condition first = ParseAnd();
+    if (!IsKeyword("OR")) {
+        return first;
+    }
+    Condition condition;
+    condition.kind = Condition::Kind::OR;
+    condition.children.push_back(std::move(first));
+    while (AcceptKeyword("OR")) {
+        condition.children.push_back(ParseAnd());
+    }
+    return condition;
+}
+
+Condition Parser::ParseAnd() {
+    Condition first = ParsePrimary();
+    if (!IsKeyword("AND")) {
+        return first;
+    }
+    Condition condition;
+    condition.kind = Condition::Kind::AND;
+    condition.children.push_back(std::move(first));
+    while (AcceptKeyword("AND")) {
+        condition.children.push_back(ParsePrimary());
+    }
+    return condition;
+}
+
+Condition Parser::ParsePrimary() {
+    if (AcceptSymbol("(")) {
+        Condition condition = ParseOr();
+        ExpectSymbol(")");
+        return condition;
+    }
+    Condition condition;
+    condition.left = ParseOperand();
+    if (AcceptKeyword("IS")) {
+        condition.kind = AcceptKeyword("NOT") ? Condition::Kind::IS_NOT_NULL : Condition::Kind::IS_NULL;
+        ExpectKeyword("NULL");
+        return condition;
+    }
+    if (AcceptKeyword("IN")) {
+        // `x IN (a, b)` is `x = a OR x = b`.
+        ExpectSymbol("(");
+        Condition list;
+        list.kind = Condition::Kind::OR;
+        do {
+            condition.right = ParseOperand();
+            list.children.push_back(condition);
+        } while (AcceptSymbol(","));
+        ExpectSymbol(")");
+        return list.children.size() == 1 ? std::move(list.children[0]) : list;
+    }
+    condition.sign = ParseCompareOperator();
+    condition.right = ParseOperand();
+    return condition;
+}
+
+ColumnDefinition Parser::ParseColumnDefinition() {
+    ColumnDefinition column;
+    column.name = ExpectIdentifier();
+    if (AcceptKeyword("INT")) {
+        column.type = TYPE::INT;
+    } else if (AcceptKeyword("BOOL")) {
+        column.type = TYPE::BOOL;
+    } else if (AcceptKeyword("FLOAT")) {
+        column.type = TYPE::FLOAT;
+    } else if (AcceptKeyword("DOUBLE")) {
+        column.type = TYPE::DOUBLE;
+    } else if (AcceptKeyword("VARCHAR")) {
+        column.type = TYPE::STRING;
+        if (AcceptSymbol("(")) {
+            if (current_.type != TokenType::NUMBER) {
+                throw std::runtime_error("Syntax error");
+            }
+            Advance();
+            ExpectSymbol(")");
+        }
+    } else {
+        throw std::runtime_error("Syntax error");
+    }
+
+    while (true) {
+        if (AcceptKeyword("PRIMARY")) {
+            ExpectKeyword("KEY");
+            column.is_primary = true;
+        } else if (AcceptKeyword("NOT")) {
+            ExpectKeyword("NULL");
+            column.is_not_null = true;
+        } else if (IsKeyword("FOREIGN") || IsKeyword("REFERENCES")) {
+            if (AcceptKeyword("FOREIGN")) {
+                ExpectKeyword("KEY");
+            }
+            ExpectKeyword("REFERENCES");
+            if (AcceptSymbol("(")) {
+                column.foreign_table = ExpectIdentifier();
+                ExpectSymbol(")");
+            } else {
+                column.foreign_table = ExpectIdentifier();
+                if (AcceptSymbol("(")) {
+                    column.foreign_column = ExpectIdentifier();
+                    ExpectSymbol(")");
+                }
+            }
+        } else {
+            return column;
+        }
+    }
+}
+
+CreateTableStatement Parser::ParseCreateTable() {
+    CreateTableStatement statement;
+    ExpectKeyword("TABLE");
+    statement.table = ExpectIdentifier();
+    ExpectSymbol("(");
+    do {
+        statement.columns.push_back(ParseColumnDefinition());
+    } while (AcceptSymbol(","));
+    ExpectSymbol(")");
+    ExpectEnd();
+    return statement;
+}
+
+DropTableStatement Parser::ParseDropTable() {
+    DropTableStatement statement;
+    ExpectKeyword("TABLE");
+    statement.table = ExpectIdentifier();
+    ExpectEnd();
+    return statement;
+}
+
+CreateIndexStatement Parser::ParseCreateIndex() {
+    CreateIndexStatement statement;
+    statement.name = ExpectIdentifier();
+    ExpectKeyword("ON");
+    statement.table = ExpectIdentifier();
+    ExpectSymbol("(");
+    statement.column = ExpectIdentifier();
+    ExpectSymbol(")");
+    ExpectEnd();
+    return statement;
+}
+
+DropIndexStatement Parser::ParseDropIndex() {
+    DropIndexStatement statement;
+    statement.name = ExpectIdentifier();
+    ExpectEnd();
+    return statement;
+}
+
+InsertStatement Parser::ParseInsert() {
+    InsertStatement statement;
+    ExpectKeyword("INTO");
+    statement.table = ExpectIdentifier();
+    if (AcceptSymbol("(")) {
+        do {
+            statement.columns.push_back(ExpectIdentifier());
+        } while (AcceptSymbol(","));
+        ExpectSymbol(")");
+    }
+    ExpectKeyword("VALUES");
+    do {
+        ExpectSymbol("(");
+        auto& row = statement.values.emplace_back();
+        do {
+            row.push_back(ParseLiteral());
+        } while (AcceptSymbol(","));
+        ExpectSymbol(")");
+    } while (AcceptSymbol(","));
+    ExpectEnd();
+    return statement;
+}
+
+CopyStatement Parser::ParseCopy() {
+    CopyStatement statement;
+    statement.table = ExpectIdentifier();
+    if (AcceptKeyword("TO")) {
+        statement.is_export = true;
+    } else {
+        ExpectKeyword("FROM");
+    }
+    if (current_.type != TokenType::STRING) {
+        throw std::runtime_error("Syntax error");
+    }
+    statement.path = current_.text;
+    Advance();
+    ExpectEnd();
+    return statement;
+}
+
+AggregateFunction Parser::ParseSelectColumn(ColumnReference& column) {
+    if (AcceptSymbol("*")) {
+        column = {"", "*"};
+        return AggregateFunction::NONE;
+    }
+    column = ParseColumnReference();
+    if (!column.table.empty() || !AcceptSymbol("(")) {
+        return AggregateFunction::NONE;
+    }
+    static const std::pair<std::string_view, AggregateFunction> kFunctions[] = {
+            {"COUNT", AggregateFunction::COUNT}, {"SUM", AggregateFunction::SUM}, {"MIN", AggregateFunction::MIN},
+            {"MAX", AggregateFunction::MAX}, {"AVG", AggregateFunction::AVG}};
+    auto function = std::find_if(std::begin(kFunctions), std::end(kFunctions), [&](const auto& i) {
+        return EqualsIgnoreCase(column.column, i.first);
+    });
+    if (function == std::end(kFunctions)) {
+        throw std::runtime_error("Syntax error");
+    }
+    if (function->second == AggregateFunction::COUNT && AcceptSymbol("*")) {
+        column = {"", "*"};
+    } else {
+        column = ParseColumnReference();
+    }
+    ExpectSymbol(")");
+    return function->second;
+}
+
+SelectStatement Parser::ParseSelect() {
+    SelectStatement statement;
+    do {
+        statement.columns.emplace_back();
+        statement.functions.push_back(ParseSelectColumn(statement.columns.back()));
+    } while (AcceptSymbol(","));
+    ExpectKeyword("FROM");
+    statement.table = ExpectIdentifier();
+
+    if (IsKeyword("INNER") || IsKeyword("LEFT") || IsKeyword("RIGHT") || IsKeyword("JOIN")) {
+        JoinClause join;
+        if (AcceptKeyword("LEFT")) {
+            join.type = JoinType::LEFT;
+        } else if (AcceptKeyword("RIGHT")) {
+            join.type = JoinType::RIGHT;
+        } else {
+            AcceptKeyword("INNER");
+        }
+        ExpectKeyword("JOIN");
+        join.table = ExpectIdentifier();
+        ExpectKeyword("ON");
+        join.left = ParseColumnReference();
+        join.sign = ParseCompareOperator();
+        join.right = ParseColumnReference();
+        statement.join = std::move(join);
+    }
+
+    if (AcceptKeyword("WHERE")) {
+        statement.where = ParseOr();
+    }
+    if (AcceptKeyword("GROUP")) {
+        ExpectKeyword("BY");
+        do {
+            statement.group_by.push_back(ParseColumnReference());
+        } while (AcceptSymbol(","));
+    }
+    if (AcceptKeyword("ORDER")) {
+        ExpectKeyword("BY");
+        do {
+            OrderKey key;
+            key.function = ParseSelectColumn(key.column);
+            if (key.function == AggregateFunction::NONE && key.column.column == "*") {
+                throw std::runtime_error("Syntax error");
+            }
+            if (AcceptKeyword("DESC")) {
+                key.is_descending = true;
+            } else {
+                AcceptKeyword("ASC");
+            }
+            statement.order_by.push_back(std::move(key));
+        } while (AcceptSymbol(","));
+    }
+    if (AcceptKeyword("LIMIT")) {
+        statement.limit = ParseLiteral();
+    }
+    if (AcceptKeyword("OFFSET")) {
+        statement.offset = ParseLiteral();
+    }
+    ExpectEnd();
+    return statement;
+}
+
+UpdateStatement Parser::ParseUpdate() {
+    UpdateStatement statement;
+    statement.table = ExpectIdentifier();
+    ExpectKeyword("SET");
+    do {
+        Assignment assignment;
+        assignment.column = ExpectIdentifier();
+        ExpectSymbol("=");
+        assignment.value = ParseLiteral();
+        statement.assignments.push_back(std::move(assignment));
+    } while (AcceptSymbol(","));
+    if (AcceptKeyword("WHERE")) {
+        statement.where = ParseOr();
+    }
+    ExpectEnd();
+    return statement;
+}
+
+DeleteStatement Parser::ParseDelete() {
+    DeleteStatement statement;
+    ExpectKeyword("FROM");
+    statement.table = ExpectIdentifier();
+    if (AcceptKeyword("WHERE")) {
+        statement.where = ParseOr();
+    }
+    ExpectEnd();
+    return statement;
+}
+
+Statement Parser::Parse() {
+    if (AcceptKeyword("CREATE")) {
+        if (AcceptKeyword("INDEX")) {
+            return ParseCreateIndex();
+        }
+        return ParseCreateTable();
+    } else if (AcceptKeyword("DROP")) {
+        if (AcceptKeyword("INDEX")) {
+            return ParseDropIndex();
+        }
+        return ParseDropTable();
+    } else if (AcceptKeyword("INSERT")) {
+        return ParseInsert();
+    } else if (AcceptKeyword("COPY")) {
+        return ParseCopy();
+    } else if (AcceptKeyword("SELECT")) {
+        return ParseSelect();
+    } else if (AcceptKeyword("UPDATE")) {
+        return ParseUpdate();
+    } else if (AcceptKeyword("DELETE")) {
+        return ParseDelete();
+    } else {
+        throw std::runtime_error("Syntax error");
+    }
+}
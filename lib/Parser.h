@@ -1,4 +1,245 @@
-#include <iostream>
-#include <regex>
+#pragma once
 
+#include "parameter.h"
 
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+enum class TokenType {
+    IDENTIFIER,
+    NUMBER,
+    STRING,
+    SYMBOL,
+    END
+};
+
+struct Token {
+    TokenType type = TokenType::END;
+    std::string_view text;
+};
+
+class Lexer {
+private:
+    std::string_view input_;
+    size_t position_ = 0;
+public:
+    explicit Lexer(std::string_view input) : input_(input) {}
+
+    Token Next();
+};
+
+enum class CompareOperator {
+    EQUAL,
+    NOT_EQUAL,
+    LESS,
+    GREATER,
+    LESS_EQUAL,
+    GREATER_EQUAL
+};
+
+enum class JoinType {
+    INNER,
+    LEFT,
+    RIGHT
+};
+
+struct ColumnReference {
+    std::string table;
+    std::string column;
+};
+
+enum class AggregateFunction {
+    NONE,
+    COUNT,
+    SUM,
+    MIN,
+    MAX,
+    AVG
+};
+
+struct Literal {
+    Parameter value;
+    bool is_placeholder = false;
+    size_t index = 0;
+};
+
+struct Operand {
+    bool is_column = false;
+    ColumnReference column;
+    Literal literal;
+};
+
+struct Condition {
+    enum class Kind {
+        AND,
+        OR,
+        COMPARISON,
+        IS_NULL,
+        IS_NOT_NULL
+    };
+
+    Kind kind = Kind::COMPARISON;
+    std::vector<Condition> children;
+    Operand left;
+    CompareOperator sign = CompareOperator::EQUAL;
+    Operand right;
+};
+
+struct ColumnDefinition {
+    std::string name;
+    TYPE type = TYPE::NONE;
+    bool is_primary = false;
+    bool is_not_null = false;
+    std::string foreign_table;
+    std::string foreign_column;
+};
+
+struct CreateTableStatement {
+    std::string table;
+    std::vector<ColumnDefinition> columns;
+};
+
+struct DropTableStatement {
+    std::string table;
+};
+
+struct CreateIndexStatement {
+    std::string name;
+    std::string table;
+    std::string column;
+};
+
+struct DropIndexStatement {
+    std::string name;
+};
+
+struct CopyStatement {
+    std::string table;
+    std::string path;
+    bool is_export = false;
+};
+
+struct InsertStatement {
+    std::string table;
+    std::vector<std::string> columns;
+    std::vector<std::vector<Literal>> values;
+};
+
+struct JoinClause {
+    JoinType type = JoinType::INNER;
+    std::string table;
+    ColumnReference left;
+    CompareOperator sign = CompareOperator::EQUAL;
+    ColumnReference right;
+};
+
+struct OrderKey {
+    ColumnReference column;
+    AggregateFunction function = AggregateFunction::NONE;
+    bool is_descending = false;
+};
+
+struct SelectStatement {
+    std::vector<ColumnReference> columns;
+    // The aggregate applied to every column, if any; COUNT(*) counts the column "*".
+    std::vector<AggregateFunction> functions;
+    std::string table;
+    std::optional<JoinClause> join;
+    std::optional<Condition> where;
+    std::vector<ColumnReference> group_by;
+    std::vector<OrderKey> order_by;
+    std::optional<Literal> limit;
+    std::optional<Literal> offset;
+};
+
+struct Assignment {
+    std::string column;
+    Literal value;
+};
+
+struct UpdateStatement {
+    std::string table;
+    std::vector<Assignment> assignments;
+    std::optional<Condition> where;
+};
+
+struct DeleteStatement {
+    std::string table;
+    std::optional<Condition> where;
+};
+
+using Statement = std::variant<CreateTableStatement, DropTableStatement, InsertStatement, SelectStatement,
+        UpdateStatement, DeleteStatement, CreateIndexStatement, DropIndexStatement, CopyStatement>;
+
+class Parser {
+private:
+    Lexer lexer_;
+    Token current_;
+    size_t placeholders_ = 0;
+
+    void Advance();
+
+    bool IsKeyword(std::string_view keyword) const;
+
+    bool IsSymbol(std::string_view symbol) const;
+
+    bool AcceptKeyword(std::string_view keyword);
+
+    bool AcceptSymbol(std::string_view symbol);
+
+    void ExpectKeyword(std::string_view keyword);
+
+    void ExpectSymbol(std::string_view symbol);
+
+    std::string ExpectIdentifier();
+
+    Literal ParseLiteral();
+
+    ColumnReference ParseColumnReference();
+
+    AggregateFunction ParseSelectColumn(ColumnReference& column);
+
+    Operand ParseOperand();
+
+    CompareOperator ParseCompareOperator();
+
+    Condition ParseOr();
+
+    Condition ParseAnd();
+
+    Condition ParsePrimary();
+
+    ColumnDefinition ParseColumnDefinition();
+
+    CreateTableStatement ParseCreateTable();
+
+    DropTableStatement ParseDropTable();
+
+    CreateIndexStatement ParseCreateIndex();
+
+    DropIndexStatement ParseDropIndex();
+
+    InsertStatement ParseInsert();
+
+    CopyStatement ParseCopy();
+
+    SelectStatement ParseSelect();
+
+    UpdateStatement ParseUpdate();
+
+    DeleteStatement ParseDelete();
+
+    void ExpectEnd();
+
+public:
+    explicit Parser(std::string_view request);
+
+    Statement Parse();
+
+    [[nodiscard]] size_t Placeholders() const noexcept {
+        return placeholders_;
+    }
+};
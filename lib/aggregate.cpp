@@ -0,0 +1,368 @@
+#include "aggregate.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+uint64_t Mix(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+uint64_t Hash(const uint64_t* key, size_t size) {
+    uint64_t hash = 0;
+    for (size_t i = 0; i < size; ++i) {
+        hash = Mix(hash ^ (key[i] + 0x9e3779b97f4a7c15ULL + (hash << 6)));
+    }
+    return hash;
+}
+
+// Key word of a value; equal values get equal words, so zeros lose their sign and NaNs their payload.
+template<typename T>
+uint64_t Word(const Column& column, size_t row) {
+    T value = column.Value<T>(row);
+    if constexpr (std::is_floating_point_v<T>) {
+        if (value == 0) {
+            value = 0;
+        } else if (std::isnan(value)) {
+            value = std::numeric_limits<T>::quiet_NaN();
+        }
+        if constexpr (sizeof(T) == sizeof(uint32_t)) {
+            return std::bit_cast<uint32_t>(value);
+        } else {
+            return std::bit_cast<uint64_t>(value);
+        }
+    } else {
+        return static_cast<uint32_t>(value);
+    }
+}
+
+template<>
+uint64_t Word<std::string_view>(const Column& column, size_t row) {
+    return column.Code(row);
+}
+
+}
+
+TYPE Aggregate::Type() const {
+    switch (function) {
+        case AggregateFunction::COUNT:
+            return TYPE::INT;
+        case AggregateFunction::AVG:
+            return TYPE::DOUBLE;
+        case AggregateFunction::SUM:
+            return argument.type == TYPE::INT ? TYPE::INT : TYPE::DOUBLE;
+        default:
+            return argument.type;
+    }
+}
+
+const char* AggregateName(AggregateFunction function) {
+    switch (function) {
+        case AggregateFunction::COUNT:
+            return "COUNT";
+        case AggregateFunction::SUM:
+            return "SUM";
+        case AggregateFunction::MIN:
+            return "MIN";
+        case AggregateFunction::MAX:
+            return "MAX";
+        case AggregateFunction::AVG:
+            return "AVG";
+        default:
+            return "";
+    }
+}
+
+HashAggregate::HashAggregate(const std::vector<SourceColumn>& keys, const std::vector<Aggregate>& aggregates,
+                             std::vector<const TableSnapshot*> snapshots) :
+        keys_(keys), aggregates_(aggregates), snapshots_(std::move(snapshots)), stride_(keys.size() + 1) {
+    if (keys_.empty()) {
+        uint64_t key = 0;
+        Insert(&key, Hash(&key, 1));
+    }
+}
+
+template<typename T>
+void HashAggregate::FillKeys(size_t key, const size_t* rows, size_t count) {
+    const Column& column = GetColumn(keys_[key]);
+    for (size_t i = 0; i < count; ++i) {
+        size_t row = rows[i];
+        if (row == Column::kNullRow || column.IsNull(row)) {
+            batch_[i * stride_ + keys_.size()] |= uint64_t(1) << key;
+        } else {
+            batch_[i * stride_ + key] = Word<T>(column, row);
+        }
+    }
+}
+
+std::pair<uint32_t, bool> HashAggregate::Insert(const uint64_t* key, uint64_t hash) {
+    constexpr uint64_t kTag = ~uint64_t(0) << 32;
+    size_t mask = slots_.size() - 1;
+    for (size_t slot = hash & mask; !slots_.empty() && slots_[slot] != 0; slot = (slot + 1) & mask) {
+        uint32_t group = static_cast<uint32_t>(slots_[slot]) - 1;
+        if ((slots_[slot] & kTag) == (hash & kTag) &&
+            std::equal(key, key + stride_, words_.data() + group * stride_)) {
+            return {group, false};
+        }
+    }
+
+    auto group = static_cast<uint32_t>(Groups());
+    words_.insert(words_.end(), key, key + stride_);
+    hashes_.push_back(hash);
+    rows_.resize(rows_.size() + snapshots_.size(), Column::kNullRow);
+    accumulators_.resize(accumulators_.size() + aggregates_.size());
+    uint32_t first = group;
+    if (Groups() * 2 > slots_.size()) {
+        slots_.assign(std::max<size_t>(16, slots_.size() * 2), 0);
+        first = 0;
+    }
+    mask = slots_.size() - 1;
+    for (uint32_t i = first; i < Groups(); ++i) {
+        size_t slot = hashes_[i] & mask;
+        while (slots_[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        slots_[slot] = (hashes_[i] & kTag) | (i + 1);
+    }
+    return {group, true};
+}
+
+template<typename T>
+void HashAggregate::Fold(size_t index, const size_t* rows, size_t count) {
+    const Aggregate& aggregate = aggregates_[index];
+    const Column& column = GetColumn(aggregate.argument);
+    const uint32_t* groups = keys_.empty() ? nullptr : groups_.data();
+    for (size_t i = 0; i < count; ++i) {
+        size_t row = rows[i];
+        if (row == Column::kNullRow || column.IsNull(row)) {
+            continue;
+        }
+        Accumulator& accumulator = accumulators_[(groups == nullptr ? 0 : groups[i]) * aggregates_.size() + index];
+        ++accumulator.count;
+        switch (aggregate.function) {
+            case AggregateFunction::SUM:
+            case AggregateFunction::AVG:
+                if constexpr (std::is_integral_v<T>) {
+                    accumulator.integer += column.Value<T>(row);
+                } else if constexpr (std::is_floating_point_v<T>) {
+                    accumulator.real += column.Value<T>(row);
+                }
+                break;
+            case AggregateFunction::MIN:
+                if (accumulator.row == Column::kNullRow || Less<T>(column, row, accumulator.row)) {
+                    accumulator.row = row;
+                }
+                break;
+            case AggregateFunction::MAX:
+                if (accumulator.row == Column::kNullRow || Less<T>(column, accumulator.row, row)) {
+                    accumulator.row = row;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+template<typename T>
+bool HashAggregate::Less(const Column& column, size_t first, size_t second) const {
+    return column.Value<T>(first) < column.Value<T>(second);
+}
+
+void HashAggregate::Add(const size_t* const* rows, size_t count) {
+    if (!keys_.empty()) {
+        batch_.assign(count * stride_, 0);
+        for (size_t i = 0; i < keys_.size(); ++i) {
+            const size_t* key_rows = rows[keys_[i].source];
+            switch (keys_[i].type) {
+                case TYPE::INT:
+                    FillKeys<int>(i, key_rows, count);
+                    break;
+                case TYPE::FLOAT:
+                    FillKeys<float>(i, key_rows, count);
+                    break;
+                case TYPE::DOUBLE:
+                    FillKeys<double>(i, key_rows, count);
+                    break;
+                case TYPE::BOOL:
+                    FillKeys<bool>(i, key_rows, count);
+                    break;
+                default:
+                    FillKeys<std::string_view>(i, key_rows, count);
+                    break;
+            }
+        }
+        // Hashing the whole batch first lets the slots of the rows ahead be prefetched.
+        constexpr size_t kPrefetch = 16;
+        batch_hashes_.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            batch_hashes_[i] = Hash(batch_.data() + i * stride_, stride_);
+        }
+        groups_.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            if (i + kPrefetch < count && !slots_.empty()) {
+                __builtin_prefetch(slots_.data() + (batch_hashes_[i + kPrefetch] & (slots_.size() - 1)));
+            }
+            auto [group, inserted] = Insert(batch_.data() + i * stride_, batch_hashes_[i]);
+            size_t* first = rows_.data() + group * snapshots_.size();
+            if (inserted || rows[0][i] < first[0]) {
+                for (size_t j = 0; j < snapshots_.size(); ++j) {
+                    first[j] = rows[j][i];
+                }
+            }
+            groups_[i] = group;
+        }
+    }
+
+    for (size_t i = 0; i < aggregates_.size(); ++i) {
+        const Aggregate& aggregate = aggregates_[i];
+        if (!aggregate.has_argument) {
+            for (size_t j = 0; j < count; ++j) {
+                ++accumulators_[(keys_.empty() ? 0 : groups_[j]) * aggregates_.size() + i].count;
+            }
+            continue;
+        }
+        const size_t* argument_rows = rows[aggregate.argument.source];
+        switch (aggregate.argument.type) {
+            case TYPE::INT:
+                Fold<int>(i, argument_rows, count);
+                break;
+            case TYPE::FLOAT:
+                Fold<float>(i, argument_rows, count);
+                break;
+            case TYPE::DOUBLE:
+                Fold<double>(i, argument_rows, count);
+                break;
+            case TYPE::BOOL:
+                Fold<bool>(i, argument_rows, count);
+                break;
+            default:
+                Fold<std::string_view>(i, argument_rows, count);
+                break;
+        }
+    }
+}
+
+void HashAggregate::Combine(size_t index, Accumulator& into, const Accumulator& from) const {
+    const Aggregate& aggregate = aggregates_[index];
+    into.count += from.count;
+    into.integer += from.integer;
+    into.real += from.real;
+    if (from.row == Column::kNullRow) {
+        return;
+    }
+    if (into.row == Column::kNullRow) {
+        into.row = from.row;
+        return;
+    }
+    if (aggregate.function != AggregateFunction::MIN && aggregate.function != AggregateFunction::MAX) {
+        return;
+    }
+    const Column& column = GetColumn(aggregate.argument);
+    size_t first = aggregate.function == AggregateFunction::MIN ? from.row : into.row;
+    size_t second = aggregate.function == AggregateFunction::MIN ? into.row : from.row;
+    bool is_better;
+    switch (aggregate.argument.type) {
+        case TYPE::INT:
+            is_better = Less<int>(column, first, second);
+            break;
+        case TYPE::FLOAT:
+            is_better = Less<float>(column, first, second);
+            break;
+        case TYPE::DOUBLE:
+            is_better = Less<double>(column, first, second);
+            break;
+        case TYPE::BOOL:
+            is_better = Less<bool>(column, first, second);
+            break;
+        default:
+            is_better = Less<std::string_view>(column, first, second);
+            break;
+    }
+    if (is_better) {
+        into.row = from.row;
+    }
+}
+
+void HashAggregate::Merge(const HashAggregate& other) {
+    for (uint32_t i = 0; i < other.Groups(); ++i) {
+        auto [group, inserted] = Insert(other.words_.data() + i * stride_, other.hashes_[i]);
+        size_t* first = rows_.data() + group * snapshots_.size();
+        const size_t* other_first = other.rows_.data() + i * snapshots_.size();
+        if (inserted || other_first[0] < first[0]) {
+            std::copy(other_first, other_first + snapshots_.size(), first);
+        }
+        for (size_t j = 0; j < aggregates_.size(); ++j) {
+            Combine(j, accumulators_[group * aggregates_.size() + j], other.accumulators_[i * aggregates_.size() + j]);
+        }
+    }
+}
+
+Column HashAggregate::Output(bool is_key, size_t index, const std::vector<uint32_t>& order) const {
+    if (is_key) {
+        const Column& source = GetColumn(keys_[index]);
+        Column column(source.Type());
+        column.Reserve(order.size());
+        for (auto i: order) {
+            size_t row = rows_[i * snapshots_.size() + keys_[index].source];
+            if (row == Column::kNullRow) {
+                column.Append(Parameter());
+            } else {
+                column.Append(source, row, row + 1);
+            }
+        }
+        return column;
+    }
+
+    const Aggregate& aggregate = aggregates_[index];
+    Column column(aggregate.Type());
+    column.Reserve(order.size());
+    for (auto i: order) {
+        const Accumulator& accumulator = accumulators_[i * aggregates_.size() + index];
+        bool is_integer = aggregate.argument.type == TYPE::INT;
+        if (aggregate.function == AggregateFunction::COUNT) {
+            if (accumulator.count > std::numeric_limits<int>::max()) {
+                throw std::logic_error("Integer overflow");
+            }
+            column.Append(Parameter(static_cast<int>(accumulator.count)));
+        } else if (accumulator.count == 0) {
+            column.Append(Parameter());
+        } else if (aggregate.function == AggregateFunction::SUM && is_integer) {
+            if (accumulator.integer > std::numeric_limits<int>::max() ||
+                accumulator.integer < std::numeric_limits<int>::min()) {
+                throw std::logic_error("Integer overflow");
+            }
+            column.Append(Parameter(static_cast<int>(accumulator.integer)));
+        } else if (aggregate.function == AggregateFunction::SUM) {
+            column.Append(Parameter(accumulator.real));
+        } else if (aggregate.function == AggregateFunction::AVG) {
+            double sum = is_integer ? static_cast<double>(accumulator.integer) : accumulator.real;
+            column.Append(Parameter(sum / static_cast<double>(accumulator.count)));
+        } else {
+            column.Append(GetColumn(aggregate.argument), accumulator.row, accumulator.row + 1);
+        }
+    }
+    return column;
+}
+
+std::vector<Column> HashAggregate::Finish(const std::vector<std::pair<bool, size_t>>& outputs) const {
+    std::vector<uint32_t> order(Groups());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](uint32_t first, uint32_t second) {
+        return rows_[first * snapshots_.size()] < rows_[second * snapshots_.size()];
+    });
+    std::vector<Column> columns;
+    for (const auto& i: outputs) {
+        columns.push_back(Output(i.first, i.second, order));
+    }
+    return columns;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "table.h"
+#include "Parser.h"
+
+// A column of one of the tables a select reads: source 0 is the table after FROM, 1 the joined one.
+struct SourceColumn {
+    size_t source = 0;
+    size_t ordinal = 0;
+    TYPE type = TYPE::NONE;
+};
+
+struct Aggregate {
+    AggregateFunction function = AggregateFunction::COUNT;
+    // COUNT(*) has no argument and counts rows.
+    bool has_argument = false;
+    SourceColumn argument;
+
+    // COUNT is INT, AVG is DOUBLE, SUM is INT over INT and DOUBLE otherwise, MIN and MAX keep the type.
+    [[nodiscard]] TYPE Type() const;
+};
+
+[[nodiscard]] const char* AggregateName(AggregateFunction function);
+
+// Hash aggregation over rows of the attached snapshots. Rows come in batches that are processed a
+// column at a time: the groups of all rows are looked up first, then every aggregate folds its
+// column. Without keys there is a single group and the folds run straight over the column values.
+// Every thread fills a partial aggregate of its own; the partials are merged at the end.
+class HashAggregate {
+private:
+    struct Accumulator {
+        int64_t count = 0;
+        int64_t integer = 0;
+        double real = 0;
+        // Row holding the least or the greatest value so far.
+        size_t row = Column::kNullRow;
+    };
+
+    const std::vector<SourceColumn>& keys_;
+    const std::vector<Aggregate>& aggregates_;
+    std::vector<const TableSnapshot*> snapshots_;
+    // Words of a group key: one per key column and the mask of the null ones.
+    size_t stride_;
+    std::vector<uint64_t> words_;
+    std::vector<uint64_t> hashes_;
+    // Earliest row of every group in every source; key values are read from it.
+    std::vector<size_t> rows_;
+    std::vector<Accumulator> accumulators_;
+    // Open addressing table; a slot holds the upper half of the hash and group + 1, or 0 when free.
+    std::vector<uint64_t> slots_;
+    std::vector<uint64_t> batch_;
+    std::vector<uint64_t> batch_hashes_;
+    std::vector<uint32_t> groups_;
+
+    [[nodiscard]] size_t Groups() const {
+        return hashes_.size();
+    }
+
+    [[nodiscard]] const Column& GetColumn(const SourceColumn& column) const {
+        return snapshots_[column.source]->GetColumn(column.ordinal);
+    }
+
+    template<typename T>
+    void FillKeys(size_t key, const size_t* rows, size_t count);
+
+    // Group with this key, added when there is none yet.
+    std::pair<uint32_t, bool> Insert(const uint64_t* key, uint64_t hash);
+
+    template<typename T>
+    void Fold(size_t index, const size_t* rows, size_t count);
+
+    template<typename T>
+    [[nodiscard]] bool Less(const Column& column, size_t first, size_t second) const;
+
+    void Combine(size_t index, Accumulator& into, const Accumulator& from) const;
+
+    [[nodiscard]] Column Output(bool is_key, size_t index, const std::vector<uint32_t>& order) const;
+
+public:
+    HashAggregate(const std::vector<SourceColumn>& keys, const std::vector<Aggregate>& aggregates,
+                  std::vector<const TableSnapshot*> snapshots);
+
+    // Adds `count` rows; rows[s][i] is the row of source s in the i-th of them, or kNullRow when an
+    // outer join did not match it.
+    void Add(const size_t* const* rows, size_t count);
+
+    void Merge(const HashAggregate& other);
+
+    // Result columns, each a key or an aggregate: (true, k) is key k and (false, k) aggregate k. Groups
+    // come in the order of their earliest rows.
+    [[nodiscard]] std::vector<Column> Finish(const std::vector<std::pair<bool, size_t>>& outputs) const;
+};
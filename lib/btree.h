@@ -0,0 +1,248 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+template<typename Key, typename Value, size_t Order = 64>
+class BTree {
+public:
+    using Entry = std::pair<Key, Value>;
+private:
+    struct Node {
+        bool is_leaf = true;
+        std::vector<Entry> entries;
+        std::vector<std::unique_ptr<Node>> children;
+        Node* next = nullptr;
+    };
+
+    std::unique_ptr<Node> root_ = std::make_unique<Node>();
+    size_t size_ = 0;
+
+    static bool Less(const Entry& first, const Entry& second) {
+        if (first.first < second.first) {
+            return true;
+        }
+        if (second.first < first.first) {
+            return false;
+        }
+        return first.second < second.second;
+    }
+
+    static size_t Child(const Node& node, const Entry& entry) {
+        return std::upper_bound(node.entries.begin(), node.entries.end(), entry, Less) - node.entries.begin();
+    }
+
+    const Node* FindLeaf(const Entry& entry) const {
+        const Node* node = root_.get();
+        while (!node->is_leaf) {
+            node = node->children[Child(*node, entry)].get();
+        }
+        return node;
+    }
+
+    // Returns the separator and the new right sibling when the node splits.
+    std::unique_ptr<Node> Insert(Node& node, Entry&& entry, Entry& separator) {
+        if (node.is_leaf) {
+            auto position = std::lower_bound(node.entries.begin(), node.entries.end(), entry, Less);
+            node.entries.insert(position, std::move(entry));
+        } else {
+            size_t child = Child(node, entry);
+            Entry child_separator;
+            auto sibling = Insert(*node.children[child], std::move(entry), child_separator);
+            if (sibling == nullptr) {
+                return nullptr;
+            }
+            node.entries.insert(node.entries.begin() + static_cast<std::ptrdiff_t>(child), std::move(child_separator));
+            node.children.insert(node.children.begin() + static_cast<std::ptrdiff_t>(child) + 1, std::move(sibling));
+        }
+        if (node.entries.size() <= Order) {
+            return nullptr;
+        }
+
+        auto sibling = std::make_unique<Node>();
+        sibling->is_leaf = node.is_leaf;
+        size_t middle = node.entries.size() / 2;
+        if (node.is_leaf) {
+            sibling->entries.assign(std::make_move_iterator(node.entries.begin() + static_cast<std::ptrdiff_t>(middle)),
+                                    std::make_move_iterator(node.entries.end()));
+            node.entries.resize(middle);
+            separator = sibling->entries.front();
+            sibling->next = node.next;
+            node.next = sibling.get();
+        } else {
+            separator = std::move(node.entries[middle]);
+            sibling->entries.assign(std::make_move_iterator(node.entries.begin() + static_cast<std::ptrdiff_t>(middle) + 1),
+                                    std::make_move_iterator(node.entries.end()));
+            sibling->children.assign(
+                    std::make_move_iterator(node.children.begin() + static_cast<std::ptrdiff_t>(middle) + 1),
+                    std::make_move_iterator(node.children.end()));
+            node.entries.resize(middle);
+            node.children.resize(middle + 1);
+        }
+        sibling->entries.reserve(Order + 1);
+        return sibling;
+    }
+
+    template<typename Function>
+    void Remap(Node& node, Function& function) {
+        if (!node.is_leaf) {
+            for (auto& i: node.entries) {
+                function(i.second);
+            }
+            for (auto& i: node.children) {
+                Remap(*i, function);
+            }
+            return;
+        }
+        // A kept entry is only moved when an entry before it was dropped: moving a string onto itself
+        // empties it.
+        size_t kept = 0;
+        for (size_t i = 0; i < node.entries.size(); ++i) {
+            if (function(node.entries[i].second)) {
+                if (kept != i) {
+                    node.entries[kept] = std::move(node.entries[i]);
+                }
+                ++kept;
+            }
+        }
+        size_ -= node.entries.size() - kept;
+        node.entries.erase(node.entries.begin() + static_cast<std::ptrdiff_t>(kept), node.entries.end());
+    }
+
+public:
+    BTree() = default;
+
+    [[nodiscard]] size_t Size() const noexcept {
+        return size_;
+    }
+
+    void Clear() {
+        root_ = std::make_unique<Node>();
+        size_ = 0;
+    }
+
+    void Insert(const Key& key, const Value& value) {
+        Entry separator;
+        auto sibling = Insert(*root_, Entry(key, value), separator);
+        if (sibling != nullptr) {
+            auto root = std::make_unique<Node>();
+            root->is_leaf = false;
+            root->entries.push_back(std::move(separator));
+            root->children.push_back(std::move(root_));
+            root->children.push_back(std::move(sibling));
+            root_ = std::move(root);
+        }
+        ++size_;
+    }
+
+    // Leaves may become underfull; they are not merged until the next Build.
+    bool Erase(const Key& key, const Value& value) {
+        Entry entry(key, value);
+        Node* node = root_.get();
+        while (!node->is_leaf) {
+            node = node->children[Child(*node, entry)].get();
+        }
+        auto position = std::lower_bound(node->entries.begin(), node->entries.end(), entry, Less);
+        if (position == node->entries.end() || Less(entry, *position)) {
+            return false;
+        }
+        node->entries.erase(position);
+        --size_;
+        return true;
+    }
+
+    void Build(std::vector<Entry>&& entries) {
+        std::sort(entries.begin(), entries.end(), Less);
+        Clear();
+        size_ = entries.size();
+        if (entries.empty()) {
+            return;
+        }
+
+        std::vector<std::unique_ptr<Node>> level;
+        std::vector<Entry> separators;
+        size_t fill = Order * 3 / 4;
+        for (size_t i = 0; i < entries.size(); i += fill) {
+            auto leaf = std::make_unique<Node>();
+            leaf->entries.reserve(Order + 1);
+            size_t end = std::min(entries.size(), i + fill);
+            leaf->entries.assign(std::make_move_iterator(entries.begin() + static_cast<std::ptrdiff_t>(i)),
+                                 std::make_move_iterator(entries.begin() + static_cast<std::ptrdiff_t>(end)));
+            if (!level.empty()) {
+                level.back()->next = leaf.get();
+            }
+            separators.push_back(leaf->entries.front());
+            level.push_back(std::move(leaf));
+        }
+
+        while (level.size() > 1) {
+            std::vector<std::unique_ptr<Node>> parents;
+            std::vector<Entry> parent_separators;
+            for (size_t i = 0; i < level.size(); i += fill + 1) {
+                auto parent = std::make_unique<Node>();
+                parent->is_leaf = false;
+                size_t end = std::min(level.size(), i + fill + 1);
+                parent_separators.push_back(separators[i]);
+                for (size_t j = i; j < end; ++j) {
+                    if (j != i) {
+                        parent->entries.push_back(separators[j]);
+                    }
+                    parent->children.push_back(std::move(level[j]));
+                }
+                parents.push_back(std::move(parent));
+            }
+            level = std::move(parents);
+            separators = std::move(parent_separators);
+        }
+        root_ = std::move(level.front());
+    }
+
+    // Passes every value to `function`, which may change it, and drops the leaf entries for which it
+    // returns false. Separators are passed too, so the new values have to keep the order of the old
+    // ones, and a dropped value has to land above every kept value below it and not above the rest.
+    // Leaves are not merged, as after Erase.
+    template<typename Function>
+    void Remap(Function function) {
+        Remap(*root_, function);
+    }
+
+    // Visits values with keys in the given bounds in key order; a null bound is unbounded. A `function`
+    // that returns bool stops the scan by returning false.
+    template<typename Function>
+    void Scan(const Key* low, bool low_inclusive, const Key* high, bool high_inclusive, Function function) const {
+        const Node* node;
+        size_t position = 0;
+        if (low == nullptr) {
+            node = root_.get();
+            while (!node->is_leaf) {
+                node = node->children.front().get();
+            }
+        } else {
+            Entry entry(*low, low_inclusive ? std::numeric_limits<Value>::min() : std::numeric_limits<Value>::max());
+            node = FindLeaf(entry);
+            auto bound = low_inclusive ?
+                         std::lower_bound(node->entries.begin(), node->entries.end(), entry, Less) :
+                         std::upper_bound(node->entries.begin(), node->entries.end(), entry, Less);
+            position = bound - node->entries.begin();
+        }
+        for (; node != nullptr; node = node->next, position = 0) {
+            for (; position < node->entries.size(); ++position) {
+                const Entry& entry = node->entries[position];
+                if (high != nullptr && (high_inclusive ? *high < entry.first : !(entry.first < *high))) {
+                    return;
+                }
+                if constexpr (std::is_same_v<std::invoke_result_t<Function&, const Value&>, bool>) {
+                    if (!function(entry.second)) {
+                        return;
+                    }
+                } else {
+                    function(entry.second);
+                }
+            }
+        }
+    }
+};
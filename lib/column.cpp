@@ -0,0 +1,360 @@
+#include "column.h"
+
+#include <algorithm>
+#include <cstring>
+
+void Column::AppendValue(const Parameter& value) {
+    bool is_null = value.Type() == TYPE::NONE;
+    switch (type_) {
+        case TYPE::INT:
+            ints_.push_back(is_null ? 0 : value.GetValue<int>());
+            break;
+        case TYPE::FLOAT:
+            floats_.push_back(is_null ? 0 : value.GetValue<float>());
+            break;
+        case TYPE::DOUBLE:
+            doubles_.push_back(is_null ? 0 : value.GetValue<double>());
+            break;
+        case TYPE::BOOL:
+            SetBit(bools_, size_, !is_null && value.GetValue<bool>());
+            break;
+        case TYPE::STRING:
+            codes_.push_back(is_null ? 0 : Intern(value.GetValue<std::string>()));
+            break;
+        default:
+            throw std::logic_error("Bad cast");
+    }
+    SetBit(nulls_, size_, is_null);
+    ++size_;
+}
+
+void Column::Rebuild() {
+    lookup_.codes.clear();
+    lookup_.codes.reserve(entries_);
+    for (uint32_t i = 0; i < entries_; ++i) {
+        lookup_.codes.emplace(Entry(i), i);
+    }
+    lookup_.base = data_.data();
+}
+
+uint32_t Column::Intern(std::string_view value) {
+    if (lookup_.base != data_.data() || lookup_.codes.size() != entries_) {
+        Rebuild();
+    }
+    auto position = lookup_.codes.find(value);
+    if (position != lookup_.codes.end()) {
+        return position->second;
+    }
+    if (entries_ >= kNoCode) {
+        throw std::logic_error("Too many distinct strings");
+    }
+    auto code = static_cast<uint32_t>(entries_);
+    data_ += value;
+    offsets_.push_back(data_.size());
+    std::atomic_ref(entries_).store(entries_ + 1, std::memory_order_release);
+    if (lookup_.base != data_.data()) {
+        Rebuild();
+    } else {
+        lookup_.codes.emplace(Entry(code), code);
+    }
+    return code;
+}
+
+uint32_t Column::Find(std::string_view value) const {
+    size_t entries = Entries();
+    for (uint32_t i = 0; i < entries; ++i) {
+        if (Entry(i) == value) {
+            return i;
+        }
+    }
+    return kNoCode;
+}
+
+Parameter Column::Get(size_t row) const {
+    if (IsNull(row)) {
+        return {};
+    }
+    switch (type_) {
+        case TYPE::INT:
+            return Parameter(ints_[row]);
+        case TYPE::FLOAT:
+            return Parameter(floats_[row]);
+        case TYPE::DOUBLE:
+            return Parameter(doubles_[row]);
+        case TYPE::BOOL:
+            return Parameter(Value<bool>(row));
+        case TYPE::STRING:
+            return Parameter(std::string(Value<std::string_view>(row)));
+        default:
+            return {};
+    }
+}
+
+bool Column::Fits(size_t rows, size_t bytes) const {
+    size_t size = size_ + rows;
+    size_t words = (size + 63) / 64;
+    if (nulls_.capacity() < words) {
+        return false;
+    }
+    switch (type_) {
+        case TYPE::INT:
+            return ints_.capacity() >= size;
+        case TYPE::FLOAT:
+            return floats_.capacity() >= size;
+        case TYPE::DOUBLE:
+            return doubles_.capacity() >= size;
+        case TYPE::BOOL:
+            return bools_.capacity() >= words;
+        case TYPE::STRING:
+            // Every new entry but the empty one takes at least a byte.
+            return codes_.capacity() >= size && offsets_.capacity() >= offsets_.size() + std::min(rows, bytes) &&
+                   data_.capacity() >= data_.size() + bytes;
+        default:
+            return true;
+    }
+}
+
+void Column::Reserve(size_t rows, size_t bytes) {
+    switch (type_) {
+        case TYPE::INT:
+            ints_.reserve(rows);
+            break;
+        case TYPE::FLOAT:
+            floats_.reserve(rows);
+            break;
+        case TYPE::DOUBLE:
+            doubles_.reserve(rows);
+            break;
+        case TYPE::BOOL:
+            bools_.reserve((rows + 63) / 64);
+            break;
+        case TYPE::STRING:
+            codes_.reserve(rows);
+            offsets_.reserve(std::min(rows, bytes) + 2);
+            data_.reserve(bytes);
+            break;
+        default:
+            break;
+    }
+    nulls_.reserve((rows + 63) / 64);
+}
+
+void Column::Append(const Parameter& value) {
+    if (value.Type() != TYPE::NONE && value.Type() != type_) {
+        AppendValue(CastParameter(value, type_));
+    } else {
+        AppendValue(value);
+    }
+}
+
+namespace {
+
+template<typename T>
+void AppendRange(std::vector<T>& values, const std::vector<T>& source, size_t begin, size_t end) {
+    if (&values == &source) {
+        for (size_t i = begin; i < end; ++i) {
+            values.push_back(source[i]);
+        }
+    } else {
+        values.insert(values.end(), source.begin() + static_cast<std::ptrdiff_t>(begin),
+                      source.begin() + static_cast<std::ptrdiff_t>(end));
+    }
+}
+
+}
+
+void Column::Append(const Column& source, size_t begin, size_t end) {
+    switch (type_) {
+        case TYPE::INT:
+            AppendRange(ints_, source.ints_, begin, end);
+            break;
+        case TYPE::FLOAT:
+            AppendRange(floats_, source.floats_, begin, end);
+            break;
+        case TYPE::DOUBLE:
+            AppendRange(doubles_, source.doubles_, begin, end);
+            break;
+        case TYPE::BOOL:
+            for (size_t i = begin; i < end; ++i) {
+                SetBit(bools_, size_ + i - begin, source.Value<bool>(i));
+            }
+            break;
+        case TYPE::STRING:
+            if (&source == this) {
+                AppendRange(codes_, source.codes_, begin, end);
+            } else if (end - begin < source.Entries()) {
+                for (size_t i = begin; i < end; ++i) {
+                    codes_.push_back(source.IsNull(i) ? 0 : Intern(source.Value<std::string_view>(i)));
+                }
+            } else {
+                // Each entry of the source is looked up once.
+                std::vector<uint32_t> codes(source.Entries(), kNoCode);
+                for (size_t i = begin; i < end; ++i) {
+                    uint32_t& code = codes[source.codes_[i]];
+                    if (code == kNoCode) {
+                        code = Intern(source.Entry(source.codes_[i]));
+                    }
+                    codes_.push_back(code);
+                }
+            }
+            break;
+        default:
+            break;
+    }
+    for (size_t i = begin; i < end; ++i) {
+        SetBit(nulls_, size_ + i - begin, source.IsNull(i));
+    }
+    size_ += end - begin;
+}
+
+void Column::TruncateBits(std::vector<uint64_t>& words, size_t rows) {
+    words.resize((rows + 63) / 64);
+    if (rows % 64 != 0) {
+        std::atomic_ref word(words.back());
+        word.store(word.load(std::memory_order_relaxed) & ((uint64_t(1) << (rows % 64)) - 1),
+                   std::memory_order_relaxed);
+    }
+}
+
+void Column::Truncate(size_t rows) {
+    if (rows >= size_) {
+        return;
+    }
+    switch (type_) {
+        case TYPE::INT:
+            ints_.resize(rows);
+            break;
+        case TYPE::FLOAT:
+            floats_.resize(rows);
+            break;
+        case TYPE::DOUBLE:
+            doubles_.resize(rows);
+            break;
+        case TYPE::BOOL:
+            TruncateBits(bools_, rows);
+            break;
+        case TYPE::STRING:
+            codes_.resize(rows);
+            break;
+        default:
+            break;
+    }
+    TruncateBits(nulls_, rows);
+    size_ = rows;
+}
+
+namespace {
+
+template<typename T>
+void SaveBlock(SnapshotWriter& writer, const std::vector<T>& values, size_t size) {
+    writer.Align();
+    writer.WriteBytes(values.data(), size * sizeof(T));
+}
+
+// The last word may be shared with rows that are being appended, so it is read atomically and cut.
+void SaveBits(SnapshotWriter& writer, const std::vector<uint64_t>& words, size_t rows) {
+    writer.Align();
+    size_t count = rows / 64;
+    writer.WriteBytes(words.data(), count * sizeof(uint64_t));
+    if (rows % 64 != 0) {
+        uint64_t word = std::atomic_ref(const_cast<uint64_t&>(words[count])).load(std::memory_order_relaxed);
+        writer.Write(word & ((uint64_t(1) << (rows % 64)) - 1));
+    }
+}
+
+template<typename T>
+void LoadBlock(SnapshotReader& reader, std::vector<T>& values, size_t size) {
+    reader.Align();
+    if (size > SIZE_MAX / sizeof(T)) {
+        throw std::runtime_error("Bad snapshot");
+    }
+    const char* data = reader.ReadBytes(size * sizeof(T));
+    values.resize(size);
+    std::memcpy(values.data(), data, size * sizeof(T));
+}
+
+}
+
+void Column::Save(SnapshotWriter& writer, size_t rows) const {
+    SaveBits(writer, nulls_, rows);
+    switch (type_) {
+        case TYPE::INT:
+            SaveBlock(writer, ints_, rows);
+            break;
+        case TYPE::FLOAT:
+            SaveBlock(writer, floats_, rows);
+            break;
+        case TYPE::DOUBLE:
+            SaveBlock(writer, doubles_, rows);
+            break;
+        case TYPE::BOOL:
+            SaveBits(writer, bools_, rows);
+            break;
+        case TYPE::STRING: {
+            // The dictionary goes along with the codes; entries appended after the rows are harmless.
+            size_t entries = Entries();
+            writer.Write(static_cast<uint64_t>(entries));
+            SaveBlock(writer, offsets_, entries + 1);
+            writer.WriteString(std::string_view(data_.data(), offsets_[entries]));
+            SaveBlock(writer, codes_, rows);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+Column Column::Load(SnapshotReader& reader, TYPE type, size_t rows) {
+    Column column(type);
+    column.size_ = rows;
+    LoadBlock(reader, column.nulls_, (rows + 63) / 64);
+    TruncateBits(column.nulls_, rows);
+    switch (type) {
+        case TYPE::INT:
+            LoadBlock(reader, column.ints_, rows);
+            break;
+        case TYPE::FLOAT:
+            LoadBlock(reader, column.floats_, rows);
+            break;
+        case TYPE::DOUBLE:
+            LoadBlock(reader, column.doubles_, rows);
+            break;
+        case TYPE::BOOL:
+            LoadBlock(reader, column.bools_, (rows + 63) / 64);
+            TruncateBits(column.bools_, rows);
+            break;
+        case TYPE::STRING: {
+            auto entries = reader.Read<uint64_t>();
+            if (entries == 0 || entries > kNoCode) {
+                throw std::runtime_error("Bad snapshot");
+            }
+            LoadBlock(reader, column.offsets_, entries + 1);
+            column.data_ = reader.ReadString();
+            const auto& offsets = column.offsets_;
+            if (offsets[0] != 0 || offsets[1] != 0 || offsets.back() != column.data_.size() ||
+                !std::is_sorted(offsets.begin(), offsets.end())) {
+                throw std::runtime_error("Bad snapshot");
+            }
+            LoadBlock(reader, column.codes_, rows);
+            if (std::any_of(column.codes_.begin(), column.codes_.end(), [entries](uint32_t code) {
+                return code >= entries;
+            })) {
+                throw std::runtime_error("Bad snapshot");
+            }
+            column.entries_ = entries;
+            column.Rebuild();
+            break;
+        }
+        default:
+            throw std::runtime_error("Bad snapshot");
+    }
+    return column;
+}
+
+size_t Column::MemoryUsage() const noexcept {
+    return ints_.capacity() * sizeof(int) + floats_.capacity() * sizeof(float) +
+           doubles_.capacity() * sizeof(double) + bools_.capacity() * sizeof(uint64_t) +
+           codes_.capacity() * sizeof(uint32_t) + offsets_.capacity() * sizeof(size_t) + data_.capacity() +
+           lookup_.codes.size() * (sizeof(std::string_view) + sizeof(uint32_t) + 2 * sizeof(void*)) +
+           lookup_.codes.bucket_count() * sizeof(void*) + nulls_.capacity() * sizeof(uint64_t);
+}
@@ -0,0 +1,247 @@
+#pragma once
+
+#include "parameter.h"
+#include "snapshot.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Rows below the size a reader saw never change, so readers may scan them while a writer appends.
+// Appending never moves the values as long as the column fits in its reserved capacity, and the bit
+// words shared by the last published rows and the new ones are accessed atomically.
+//
+// Strings are dictionary encoded: a row holds the code of its value and every distinct value is
+// stored once. Entry 0 is the empty string, which NULL rows point to as well. Entries are only
+// appended, so a code keeps its meaning for as long as the column lives.
+class Column {
+private:
+    // Code of every entry, for appends only. The keys point into data_ and are rebuilt once it moves;
+    // a copy starts empty and is rebuilt on its first append.
+    struct Lookup {
+        const char* base = nullptr;
+        std::unordered_map<std::string_view, uint32_t> codes;
+
+        Lookup() = default;
+
+        Lookup(const Lookup&) {}
+
+        Lookup(Lookup&&) = default;
+
+        Lookup& operator=(const Lookup&) {
+            base = nullptr;
+            codes.clear();
+            return *this;
+        }
+
+        Lookup& operator=(Lookup&&) = default;
+    };
+
+    TYPE type_ = TYPE::NONE;
+    size_t size_ = 0;
+    std::vector<int> ints_;
+    std::vector<float> floats_;
+    std::vector<double> doubles_;
+    std::vector<uint64_t> bools_;
+    std::vector<uint32_t> codes_;
+    std::vector<size_t> offsets_{0, 0};
+    std::string data_;
+    size_t entries_ = 1;
+    Lookup lookup_;
+    std::vector<uint64_t> nulls_;
+
+    static uint64_t GetWord(const std::vector<uint64_t>& words, size_t index) {
+        return std::atomic_ref(const_cast<uint64_t&>(words[index])).load(std::memory_order_relaxed);
+    }
+
+    static bool GetBit(const std::vector<uint64_t>& words, size_t row) {
+        return (GetWord(words, row / 64) >> (row % 64)) & 1;
+    }
+
+    static void SetBit(std::vector<uint64_t>& words, size_t row, bool value) {
+        if (row % 64 == 0) {
+            words.push_back(0);
+        }
+        if (value) {
+            std::atomic_ref word(words[row / 64]);
+            word.store(word.load(std::memory_order_relaxed) | uint64_t(1) << (row % 64), std::memory_order_relaxed);
+        }
+    }
+
+    static void TruncateBits(std::vector<uint64_t>& words, size_t rows);
+
+    void AppendValue(const Parameter& value);
+
+    void Rebuild();
+
+    // Code of `value`, which becomes a new entry if it is not in the dictionary yet.
+    uint32_t Intern(std::string_view value);
+
+public:
+    static constexpr size_t kNullRow = static_cast<size_t>(-1);
+
+    // Code of no entry.
+    static constexpr uint32_t kNoCode = static_cast<uint32_t>(-1);
+
+    Column() = default;
+
+    explicit Column(TYPE type) : type_(type) {}
+
+    [[nodiscard]] TYPE Type() const noexcept {
+        return type_;
+    }
+
+    [[nodiscard]] size_t Size() const noexcept {
+        return size_;
+    }
+
+    // Bytes of the distinct strings stored so far.
+    [[nodiscard]] size_t Bytes() const noexcept {
+        return data_.size();
+    }
+
+    // Entries in the dictionary; readers see at least the ones their rows point to.
+    [[nodiscard]] size_t Entries() const {
+        return std::atomic_ref(const_cast<size_t&>(entries_)).load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] std::string_view Entry(uint32_t code) const {
+        return {data_.data() + offsets_[code], offsets_[code + 1] - offsets_[code]};
+    }
+
+    [[nodiscard]] uint32_t Code(size_t row) const {
+        return codes_[row];
+    }
+
+    [[nodiscard]] const uint32_t* Codes(size_t row) const {
+        return codes_.data() + row;
+    }
+
+    // Code of `value`, or kNoCode. Reads the whole dictionary, so it is meant for scans.
+    [[nodiscard]] uint32_t Find(std::string_view value) const;
+
+    // Whether `rows` more rows holding `bytes` of string data can be appended without moving the values.
+    [[nodiscard]] bool Fits(size_t rows, size_t bytes) const;
+
+    [[nodiscard]] bool IsNull(size_t row) const {
+        return GetBit(nulls_, row);
+    }
+
+    template<typename T>
+    [[nodiscard]] T Value(size_t row) const;
+
+    // Values from `row` on, for kernels that compare many rows at once.
+    template<typename T>
+    [[nodiscard]] const T* Values(size_t row) const;
+
+    // Bits of rows [64 * index, 64 * index + 64).
+    [[nodiscard]] uint64_t NullWord(size_t index) const {
+        return GetWord(nulls_, index);
+    }
+
+    [[nodiscard]] uint64_t BoolWord(size_t index) const {
+        return GetWord(bools_, index);
+    }
+
+    [[nodiscard]] Parameter Get(size_t row) const;
+
+    void Reserve(size_t rows, size_t bytes = 0);
+
+    void Append(const Parameter& value);
+
+    // Appends rows [begin, end) of `source`, which has the same type.
+    void Append(const Column& source, size_t begin, size_t end);
+
+    template<typename T>
+    void Push(T value);
+
+    void PushNull() {
+        AppendValue(Parameter());
+    }
+
+    void Truncate(size_t rows);
+
+    // Writes the first `rows` rows.
+    void Save(SnapshotWriter& writer, size_t rows) const;
+
+    static Column Load(SnapshotReader& reader, TYPE type, size_t rows);
+
+    [[nodiscard]] size_t MemoryUsage() const noexcept;
+};
+
+template<>
+inline int Column::Value<int>(size_t row) const {
+    return ints_[row];
+}
+
+template<>
+inline float Column::Value<float>(size_t row) const {
+    return floats_[row];
+}
+
+template<>
+inline double Column::Value<double>(size_t row) const {
+    return doubles_[row];
+}
+
+template<>
+inline bool Column::Value<bool>(size_t row) const {
+    return GetBit(bools_, row);
+}
+
+template<>
+inline std::string_view Column::Value<std::string_view>(size_t row) const {
+    return Entry(codes_[row]);
+}
+
+template<>
+inline const int* Column::Values<int>(size_t row) const {
+    return ints_.data() + row;
+}
+
+template<>
+inline const float* Column::Values<float>(size_t row) const {
+    return floats_.data() + row;
+}
+
+template<>
+inline const double* Column::Values<double>(size_t row) const {
+    return doubles_.data() + row;
+}
+
+template<>
+inline void Column::Push<int>(int value) {
+    ints_.push_back(value);
+    SetBit(nulls_, size_, false);
+    ++size_;
+}
+
+template<>
+inline void Column::Push<float>(float value) {
+    floats_.push_back(value);
+    SetBit(nulls_, size_, false);
+    ++size_;
+}
+
+template<>
+inline void Column::Push<double>(double value) {
+    doubles_.push_back(value);
+    SetBit(nulls_, size_, false);
+    ++size_;
+}
+
+template<>
+inline void Column::Push<bool>(bool value) {
+    SetBit(bools_, size_, value);
+    SetBit(nulls_, size_, false);
+    ++size_;
+}
+
+template<>
+inline void Column::Push<std::string_view>(std::string_view value) {
+    codes_.push_back(Intern(value));
+    SetBit(nulls_, size_, false);
+    ++size_;
+}
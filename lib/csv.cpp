@@ -0,0 +1,207 @@
+#include "csv.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+
+namespace {
+
+class CsvReader {
+private:
+    std::string_view input_;
+    size_t position_ = 0;
+    std::string scratch_;
+
+public:
+    explicit CsvReader(std::string_view input) : input_(input) {}
+
+    [[nodiscard]] bool AtEnd() const noexcept {
+        return position_ >= input_.size();
+    }
+
+    bool SkipEmptyLine() {
+        if (input_[position_] == '\n') {
+            ++position_;
+            return true;
+        }
+        if (input_[position_] == '\r' && position_ + 1 < input_.size() && input_[position_ + 1] == '\n') {
+            position_ += 2;
+            return true;
+        }
+        return false;
+    }
+
+    // Returns true if another field of the same record follows.
+    bool ReadField(std::string_view& field, bool& quoted) {
+        quoted = position_ < input_.size() && input_[position_] == '"';
+        if (!quoted) {
+            size_t end = input_.find_first_of(",\n", position_);
+            if (end == std::string_view::npos) {
+                end = input_.size();
+            }
+            field = input_.substr(position_, end - position_);
+            if (!field.empty() && field.back() == '\r') {
+                field.remove_suffix(1);
+            }
+            position_ = end + 1;
+            return end < input_.size() && input_[end] == ',';
+        }
+
+        size_t start = ++position_;
+        bool escaped = false;
+        while (true) {
+            size_t end = input_.find('"', position_);
+            if (end == std::string_view::npos) {
+                throw std::runtime_error("Bad CSV format");
+            }
+            if (end + 1 < input_.size() && input_[end + 1] == '"') {
+                if (!escaped) {
+                    scratch_.clear();
+                    escaped = true;
+                }
+                scratch_.append(input_.substr(position_, end + 1 - position_));
+                position_ = end + 2;
+                continue;
+            }
+            if (escaped) {
+                scratch_.append(input_.substr(position_, end - position_));
+                field = scratch_;
+            } else {
+                field = input_.substr(start, end - start);
+            }
+            position_ = end + 1;
+            break;
+        }
+        if (position_ < input_.size() && input_[position_] == '\r') {
+            ++position_;
+        }
+        if (position_ >= input_.size() || input_[position_] == '\n') {
+            ++position_;
+            return false;
+        }
+        if (input_[position_] != ',') {
+            throw std::runtime_error("Bad CSV format");
+        }
+        ++position_;
+        return true;
+    }
+};
+
+template<typename T>
+T ParseNumber(std::string_view field) {
+    T value;
+    auto result = std::from_chars(field.data(), field.data() + field.size(), value);
+    if (result.ec != std::errc() || result.ptr != field.data() + field.size()) {
+        throw std::logic_error("Bad cast");
+    }
+    return value;
+}
+
+bool ParseBool(std::string_view field) {
+    auto equals = [field](std::string_view keyword) {
+        return std::equal(field.begin(), field.end(), keyword.begin(), keyword.end(), [](char first, char second) {
+            return std::tolower(static_cast<unsigned char>(first)) == second;
+        });
+    };
+    if (field == "1" || equals("true")) {
+        return true;
+    }
+    if (field == "0" || equals("false")) {
+        return false;
+    }
+    throw std::logic_error("Bad cast");
+}
+
+void PushField(Column& column, std::string_view field) {
+    switch (column.Type()) {
+        case TYPE::INT:
+            column.Push(ParseNumber<int>(field));
+            break;
+        case TYPE::FLOAT:
+            column.Push(ParseNumber<float>(field));
+            break;
+        case TYPE::DOUBLE:
+            column.Push(ParseNumber<double>(field));
+            break;
+        case TYPE::BOOL:
+            column.Push(ParseBool(field));
+            break;
+        case TYPE::STRING:
+            column.Push(field);
+            break;
+        default:
+            throw std::logic_error("Bad cast");
+    }
+}
+
+}
+
+void ReadCsv(Table& table, std::string_view input) {
+    CsvReader reader(input);
+    while (!reader.AtEnd() && reader.SkipEmptyLine()) {
+    }
+    if (reader.AtEnd()) {
+        return;
+    }
+
+    Schema& schema = table.GetSchema();
+    std::vector<size_t> ordinals;
+    std::vector<bool> present(schema.Size(), false);
+    std::string_view field;
+    bool quoted;
+    bool more = true;
+    while (more) {
+        more = reader.ReadField(field, quoted);
+        size_t ordinal = schema.Ordinal(std::string(field));
+        if (present[ordinal]) {
+            throw std::logic_error("This parameter already exists in this table");
+        }
+        present[ordinal] = true;
+        ordinals.push_back(ordinal);
+    }
+    std::vector<size_t> missing;
+    for (size_t i = 0; i < schema.Size(); ++i) {
+        if (!present[i]) {
+            if (schema.IsNotNull(i)) {
+                throw std::logic_error("NOT NULL parameters is not in parameter list");
+            }
+            missing.push_back(i);
+        }
+    }
+
+    // Rows are staged aside so that readers never see a partly loaded file.
+    std::vector<Column> columns;
+    size_t lines = static_cast<size_t>(std::count(input.begin(), input.end(), '\n')) + 1;
+    for (size_t i = 0; i < schema.Size(); ++i) {
+        columns.emplace_back(schema.Type(i));
+        columns.back().Reserve(lines);
+    }
+    while (!reader.AtEnd()) {
+        if (reader.SkipEmptyLine()) {
+            continue;
+        }
+        size_t count = 0;
+        do {
+            more = reader.ReadField(field, quoted);
+            if (count == ordinals.size()) {
+                throw std::logic_error("Wrong number of values");
+            }
+            Column& column = columns[ordinals[count++]];
+            if (field.empty() && !quoted) {
+                if (schema.IsNotNull(ordinals[count - 1])) {
+                    throw std::logic_error("NOT NULL parameter can not be NULL");
+                }
+                column.PushNull();
+            } else {
+                PushField(column, field);
+            }
+        } while (more);
+        if (count != ordinals.size()) {
+            throw std::logic_error("Wrong number of values");
+        }
+        for (auto i: missing) {
+            columns[i].PushNull();
+        }
+    }
+    table.Append(std::move(columns));
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "table.h"
+
+#include <string_view>
+
+// Appends the records of a CSV document whose first line names the columns.
+// Empty unquoted fields are NULL. The table is left unchanged if any record is rejected.
+void ReadCsv(Table& table, std::string_view input);
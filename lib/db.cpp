@@ -1,942 +1,1788 @@
 #include "db.h"
-#include <sstream>
-
-struct Column {
-    bool is_null = false;
-    bool is_primary = false;
-    bool is_foreign = false;
-    std::string table_name;
-    std::string column_name;
-    TYPE type = TYPE::NONE;
+#include "csv.h"
+#include "formatter.h"
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+
+namespace {
+
+enum class RecordKind : uint8_t {
+    STATEMENT = 1,
+    ROWS = 2,
+    LOAD = 3
 };
 
-bool IsDigit(const std::string& str) {
-    std::regex numeric_regex(R"(^[-]?\d+(\.\d+)?$)");
-    return std::regex_match(str, numeric_regex);
+template<typename T>
+void AppendValue(std::string& record, T value) {
+    record.append(reinterpret_cast<const char*>(&value), sizeof(T));
 }
 
-bool IsString(const std::string& input) {
-    std::regex regex(R"(^(['"])\w*(['"]))");
-    return std::regex_match(input, regex);
+void AppendString(std::string& record, std::string_view value) {
+    AppendValue(record, static_cast<uint64_t>(value.size()));
+    record.append(value);
 }
 
-bool IsBool(const std::string& input) {
-    return input == "true" || input == "false";
+void AppendParameter(std::string& record, const Parameter& value) {
+    AppendValue(record, static_cast<uint8_t>(value.Type()));
+    switch (value.Type()) {
+        case TYPE::INT:
+            AppendValue(record, value.GetValue<int>());
+            break;
+        case TYPE::FLOAT:
+            AppendValue(record, value.GetValue<float>());
+            break;
+        case TYPE::DOUBLE:
+            AppendValue(record, value.GetValue<double>());
+            break;
+        case TYPE::BOOL:
+            AppendValue(record, static_cast<uint8_t>(value.GetValue<bool>()));
+            break;
+        case TYPE::STRING:
+            AppendString(record, value.GetValue<std::string>());
+            break;
+        default:
+            break;
+    }
 }
 
-std::string RemoveQuotes(const std::string& str) {
-    std::regex quotesRegex(R"(["'])");
-    return std::regex_replace(str, quotesRegex, "");
+Parameter ReadParameter(SnapshotReader& reader) {
+    switch (static_cast<TYPE>(reader.Read<uint8_t>())) {
+        case TYPE::INT:
+            return Parameter(reader.Read<int>());
+        case TYPE::FLOAT:
+            return Parameter(reader.Read<float>());
+        case TYPE::DOUBLE:
+            return Parameter(reader.Read<double>());
+        case TYPE::BOOL:
+            return Parameter(reader.Read<uint8_t>() != 0);
+        case TYPE::STRING:
+            return Parameter(reader.ReadString());
+        case TYPE::NONE:
+            return {};
+        default:
+            throw std::runtime_error("Bad log");
+    }
 }
 
-template<typename T>
-T CastFromString(const std::string& string) {
-    T value;
-    std::istringstream iss(string);
-    if (iss >> value) {
-        return value;
-    } else {
-        throw std::logic_error("Bad cast");
+constexpr char kManifestMagic[8] = {'S', 'Q', 'L', 'C', 'K', 'P', 'T', '\0'};
+constexpr uint32_t kManifestVersion = 1;
+constexpr const char* kManifest = "MANIFEST";
+constexpr const char* kLog = "wal.log";
+constexpr const char* kTableExtension = ".tbl";
+
+// Sets the commit hook of a table for one statement.
+class CommitHook {
+private:
+    Table& table_;
+
+public:
+    CommitHook(Table& table, std::function<void(size_t, size_t)> hook) : table_(table) {
+        table_.SetCommitHook(std::move(hook));
+    }
+
+    CommitHook(const CommitHook&) = delete;
+
+    CommitHook& operator=(const CommitHook&) = delete;
+
+    ~CommitHook() {
+        table_.SetCommitHook({});
+    }
+};
+
+struct CheckpointJob {
+    std::string directory;
+    uint64_t generation = 0;
+    uint64_t position = 0;
+    std::string name;
+    std::vector<Connection> connections;
+    std::vector<std::pair<std::string, std::string>> tables;
+    std::vector<std::pair<std::string, TableImage>> images;
+    std::vector<std::string> obsolete;
+};
+
+void WriteCheckpoint(const CheckpointJob& job, WriteAheadLog& log) {
+    std::filesystem::path directory(job.directory);
+    for (const auto& i: job.images) {
+        std::string path = (directory / i.first).string();
+        {
+            std::ofstream output(path, std::ios::binary | std::ios::trunc);
+            SnapshotWriter writer(output);
+            writer.WriteBytes(kSnapshotMagic, sizeof(kSnapshotMagic));
+            writer.Write(kSnapshotVersion);
+            i.second.Save(writer);
+            writer.Flush();
+            output.flush();
+            if (!output) {
+                throw std::runtime_error("Can not write file");
+            }
+        }
+        SyncPath(path);
+    }
+
+    std::string manifest = (directory / kManifest).string();
+    std::string temporary = manifest + ".tmp";
+    {
+        std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+        SnapshotWriter writer(output);
+        writer.WriteBytes(kManifestMagic, sizeof(kManifestMagic));
+        writer.Write(kManifestVersion);
+        writer.Write(job.generation);
+        writer.Write(job.position);
+        writer.WriteString(job.name);
+        writer.Write(static_cast<uint32_t>(job.connections.size()));
+        for (const auto& i: job.connections) {
+            writer.WriteString(i.GetLink().first);
+            writer.WriteString(i.GetLink().second);
+            writer.WriteString(i.GetKey());
+        }
+        writer.Write(static_cast<uint32_t>(job.tables.size()));
+        for (const auto& i: job.tables) {
+            writer.WriteString(i.first);
+            writer.WriteString(i.second);
+        }
+        writer.Flush();
+        output.flush();
+        if (!output) {
+            throw std::runtime_error("Can not write file");
+        }
+    }
+    SyncPath(temporary);
+    std::filesystem::rename(temporary, manifest);
+    SyncPath(directory.string());
+
+    log.Truncate(job.position);
+    for (const auto& i: job.obsolete) {
+        std::error_code error;
+        std::filesystem::remove(directory / i, error);
     }
 }
 
-template<>
-bool CastFromString<bool>(const std::string& string) {
-    bool value;
-    std::istringstream iss(string);
-    if (iss >> std::boolalpha >> value) {
-        return value;
-    } else {
-        throw std::logic_error("Bad cast");
+template<typename T>
+T ParseStatement(const std::string& request) {
+    Statement statement = Parser(request).Parse();
+    if (auto* result = std::get_if<T>(&statement)) {
+        return std::move(*result);
     }
+    throw std::runtime_error("Syntax error");
 }
 
-Column ParseColumn(const std::string& request) {
-    Column column;
-    std::regex regex(
-            R"(\s*(\w+)\s*(INT|FLOAT|VARCHAR|DOUBLE|BOOL)?(\(\d+\))?\s*\s*(PRIMARY KEY)?\s*(NOT NULL)?\s*((FOREIGN KEY) REFERENCES(\((\w+)\)))?\s*)");
-    std::smatch match;
-    if (std::regex_match(request, match, regex)) {
-        column.column_name = match[1].str();
-        std::string type_ = match[2].str();
-        if (type_ == "INT") {
-            column.type = TYPE::INT;
-        } else if (type_ == "BOOL") {
-            column.type = TYPE::BOOL;
-        } else if (type_ == "FLOAT") {
-            column.type = TYPE::FLOAT;
-        } else if (type_ == "DOUBLE") {
-            column.type = TYPE::DOUBLE;
-        } else if (type_ == "VARCHAR") {
-            column.type = TYPE::STRING;
-        } else {
-            throw std::runtime_error("Syntax error");
-        }
-        if (!match[4].str().empty()) {
-            column.is_primary = true;
-        } else if (!match[5].str().empty()) {
-            column.is_null = true;
-        } else if (!match[7].str().empty()) {
-            column.is_foreign = true;
-            std::smatch other_match;
-            column.table_name = match[9].str();
-        }
-        return column;
-    } else {
-        throw std::runtime_error("Syntax error");
+const Parameter& Value(const Literal& literal, const std::vector<Parameter>& parameters) {
+    if (!literal.is_placeholder) {
+        return literal.value;
+    }
+    if (literal.index >= parameters.size()) {
+        throw std::logic_error("Parameter is not bound");
     }
+    return parameters[literal.index];
 }
 
-void SplitString(const std::string& input, std::vector<std::string>& result) {
-    std::regex split_element(R"(\s*,\s*)");
-    std::sregex_token_iterator iter(input.begin(), input.end(), split_element, -1);
-    std::sregex_token_iterator end;
-    while (iter != end) {
-        result.push_back(*iter);
-        ++iter;
+void CheckNotNull(Table& table, size_t column, const Parameter& value) {
+    if (value.Type() == TYPE::NONE && table.GetSchema().IsNotNull(column)) {
+        throw std::logic_error("NOT NULL parameter can not be NULL");
     }
 }
 
-std::string ParsePredicate(std::vector<std::string>& predicate, Element& element) {
-    if (predicate.size() == 1) {
-        return predicate[0];
-    } else {
-        if (element.GetParameters().find(predicate[0]) == element.GetParameters().end()) {
-            if (!IsDigit(predicate[0]) && !IsString(predicate[0])) {
-                throw std::logic_error("This parameter does not exist");
-            }
-        }
-        if (element.GetParameters().find(predicate[2]) == element.GetParameters().end()) {
-            if (!IsDigit(predicate[2]) && !IsString(predicate[2])) {
-                throw std::logic_error("This parameter does not exist");
-            }
+Access ChooseAccess(Table& table, const Predicate& predicate) {
+    Access access;
+    Schema& schema = table.GetSchema();
+    if (schema.HasPrimary() && predicate.Equality(0, schema.PrimaryOrdinal()) != nullptr) {
+        access.kind = Access::Kind::PRIMARY_KEY;
+        access.column = schema.PrimaryOrdinal();
+        return access;
+    }
+    for (size_t i = 0; i < schema.Size(); ++i) {
+        if (table.FindIndex(i) != nullptr && predicate.Restricts(0, i)) {
+            access.kind = Access::Kind::INDEX;
+            access.column = i;
+            return access;
         }
+    }
+    return access;
+}
 
-        Parameter first_parameter;
-        bool is_first_parameter;
-        Parameter second_parameter;
-        bool is_second_parameter;
+// Row positions that may satisfy the predicate, in table order; every row for a full scan.
+struct Candidates {
+    bool is_scan = true;
+    // Every row is visible and satisfies the predicate.
+    bool matched = false;
+    size_t size = 0;
+    std::vector<size_t> rows;
 
-        is_first_parameter = !IsDigit(predicate[0]) && !IsString(predicate[0]) && !IsBool(predicate[0]);
-        is_second_parameter = !IsDigit(predicate[2]) && !IsString(predicate[2]) && !IsBool(predicate[2]);
+    [[nodiscard]] size_t Count() const {
+        return is_scan ? size : rows.size();
+    }
 
-        if (is_first_parameter && is_second_parameter) {
-            first_parameter = element[predicate[0]];
-            second_parameter = element[predicate[2]];
+    size_t operator[](size_t i) const {
+        return is_scan ? i : rows[i];
+    }
+};
 
-            if (first_parameter.Type() != second_parameter.Type()) {
-                throw std::logic_error("Different types of parameters");
-            }
+// Index probes need the table lock and a snapshot of the latest generation.
+Candidates FindCandidates(const Table& table, const TableSnapshot& rows, const Predicate& predicate,
+                          const Access& access) {
+    Candidates candidates;
+    if (access.kind == Access::Kind::SCAN) {
+        candidates.size = rows.Size();
+        return candidates;
+    }
+    candidates.is_scan = false;
+    if (access.kind == Access::Kind::PRIMARY_KEY) {
+        auto row = table.Find(*predicate.Equality(0, access.column));
+        if (row.has_value()) {
+            candidates.rows.push_back(*row);
         }
-
-        if (is_first_parameter && !is_second_parameter) {
-            first_parameter = element[predicate[0]];
-
-            if (IsDigit(predicate[2])) {
-                if (first_parameter.Type() == TYPE::INT) {
-                    second_parameter = std::stoi(predicate[2]);
-                } else if (first_parameter.Type() == TYPE::FLOAT) {
-                    second_parameter = std::stof(predicate[2]);
-                } else if (first_parameter.Type() == TYPE::DOUBLE) {
-                    second_parameter = std::stod(predicate[2]);
-                } else {
-                    throw std::logic_error("Different types of parameters");
-                }
-            } else if (IsString(predicate[2])) {
-                if (first_parameter.Type() == TYPE::STRING) {
-                    second_parameter = RemoveQuotes(predicate[2]);
-                } else {
-                    throw std::logic_error("Different types of parameters");
-                }
-            } else if (IsBool(predicate[2])) {
-                if (first_parameter.Type() == TYPE::BOOL) {
-                    second_parameter = (predicate[2] == "true");
-                } else {
-                    throw std::logic_error("Different types of parameters");
-                }
+        return candidates;
+    }
+    Predicate::Bound low;
+    Predicate::Bound high;
+    if (predicate.Range(0, access.column, low, high)) {
+        table.FindIndex(access.column)->Scan(low.value, low.inclusive, high.value, high.inclusive, [&](size_t row) {
+            if (row < rows.Size()) {
+                candidates.rows.push_back(row);
             }
-        }
+        });
+    }
+    std::sort(candidates.rows.begin(), candidates.rows.end());
+    return candidates;
+}
 
-        if (!is_first_parameter && is_second_parameter) {
-            second_parameter = element[predicate[2]];
+// Scans are split into morsels of this many candidates; a scan of one morsel stays on the calling thread.
+constexpr size_t kMorselRows = 1 << 16;
 
-            if (IsDigit(predicate[0])) {
-                if (second_parameter.Type() == TYPE::INT) {
-                    first_parameter = std::stoi(predicate[0]);
-                } else if (second_parameter.Type() == TYPE::FLOAT) {
-                    first_parameter = std::stof(predicate[0]);
-                } else if (second_parameter.Type() == TYPE::DOUBLE) {
-                    first_parameter = std::stod(predicate[0]);
-                } else {
-                    throw std::logic_error("Different types of parameters");
-                }
-            } else if (IsString(predicate[0])) {
-                if (second_parameter.Type() == TYPE::STRING) {
-                    first_parameter = RemoveQuotes(predicate[0]);
-                } else {
-                    throw std::logic_error("Different types of parameters");
-                }
-            } else if (IsBool(predicate[0])) {
-                if (second_parameter.Type() == TYPE::BOOL) {
-                    first_parameter = (predicate[0] == "true");
-                } else {
-                    throw std::logic_error("Different types of parameters");
+// Candidates that are visible and satisfy the predicate, in table order. Morsels are filtered on the
+// pool and keep their matches apart, so joining them in morsel order keeps the table order.
+Candidates Filter(const Candidates& candidates, const TableSnapshot& rows, Predicate& predicate, ThreadPool& pool) {
+    if (candidates.is_scan) {
+        predicate.Encode();
+    }
+    auto filter = [&](size_t begin, size_t end, std::vector<size_t>& matches) {
+        if (candidates.is_scan) {
+            std::vector<uint64_t> bits;
+            predicate.Select(begin, end, bits);
+            for (size_t i = 0; i < bits.size(); ++i) {
+                for (uint64_t word = bits[i]; word != 0; word &= word - 1) {
+                    size_t row = begin + i * 64 + std::countr_zero(word);
+                    if (rows.Visible(row)) {
+                        matches.push_back(row);
+                    }
                 }
             }
+            return;
         }
-
-        if (!is_first_parameter && !is_second_parameter) {
-            if (IsDigit(predicate[0]) && IsDigit(predicate[2])) {
-                first_parameter = std::stod(predicate[0]);
-                second_parameter = std::stod(predicate[2]);
-            } else if (IsString(predicate[0]) && IsString(predicate[2])) {
-                first_parameter = RemoveQuotes(predicate[0]);
-                second_parameter = RemoveQuotes(predicate[2]);
-            } else if (IsBool(predicate[0]) && IsBool(predicate[0])) {
-                first_parameter = (predicate[0] == "true");
-                second_parameter = (predicate[2] == "true");
-            } else {
-                throw std::logic_error("Different types of parameters");
+        for (size_t i = begin; i < end; ++i) {
+            size_t row = candidates[i];
+            if (rows.Visible(row) && predicate(row)) {
+                matches.push_back(row);
             }
         }
+    };
+
+    Candidates result;
+    result.is_scan = false;
+    result.matched = true;
+    size_t count = candidates.Count();
+    size_t morsels = (count + kMorselRows - 1) / kMorselRows;
+    if (morsels < 2 || pool.Size() == 0) {
+        filter(0, count, result.rows);
+        return result;
+    }
+    std::vector<std::vector<size_t>> matches(morsels);
+    pool.ForEach(morsels, [&](size_t morsel) {
+        filter(morsel * kMorselRows, std::min(count, (morsel + 1) * kMorselRows), matches[morsel]);
+    });
+    size_t total = 0;
+    for (const auto& i: matches) {
+        total += i.size();
+    }
+    result.rows.reserve(total);
+    for (const auto& i: matches) {
+        result.rows.insert(result.rows.end(), i.begin(), i.end());
+    }
+    return result;
+}
 
-        if (predicate[1] == ">") {
-            return (first_parameter > second_parameter ? "true" : "false");
-        } else if (predicate[1] == "=") {
-            std::string flag = (first_parameter == second_parameter ? "true" : "false");
-            return (first_parameter == second_parameter ? "true" : "false");
-        } else if (predicate[1] == "<") {
-            bool flag = first_parameter < second_parameter;
-            return (first_parameter < second_parameter ? "true" : "false");
-        } else {
-            throw std::logic_error("Such symbol does not exist");
+bool IsAggregate(const SelectStatement& statement) {
+    auto is_function = [](AggregateFunction function) {
+        return function != AggregateFunction::NONE;
+    };
+    return !statement.group_by.empty() ||
+           std::any_of(statement.functions.begin(), statement.functions.end(), is_function) ||
+           std::any_of(statement.order_by.begin(), statement.order_by.end(), [&](const OrderKey& key) {
+               return is_function(key.function);
+           });
+}
+
+// The first of `sources` with the column, in source order.
+SourceColumn Resolve(const ColumnReference& reference, const std::vector<Predicate::Source>& sources) {
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (!reference.table.empty() && reference.table != sources[i].first) {
+            continue;
+        }
+        Schema& schema = sources[i].second->GetSchema();
+        if (schema.Contains(reference.column)) {
+            size_t ordinal = schema.Ordinal(reference.column);
+            return SourceColumn{i, ordinal, schema.Type(ordinal)};
         }
     }
+    throw std::logic_error("This parameter does not exist");
 }
 
-std::vector<std::string> ParseComplexLogic(std::string& string) noexcept {
-    std::regex regex(R"((\b\w+\b)|([()])|(>=|<=|<|>|=)|(\"([^\"]*)\")|(OR|AND))");
-    std::smatch match;
-    std::vector<std::string> elements;
-    std::string tmp = string;
-    while (std::regex_search(tmp, match, regex)) {
-        elements.push_back(match.str(0));
-        tmp = match.suffix();
+void PlanOrder(const SelectStatement& statement, const std::vector<Predicate::Source>& sources, SelectPlan& plan) {
+    for (const auto& i: statement.order_by) {
+        plan.order_by.push_back({Resolve(i.column, sources), i.is_descending});
     }
-    return elements;
 }
 
-std::string ParseLogicExpression(const std::vector<std::string>& predicates, Element& element) {
-    std::vector<std::string> current_predicate;
-    std::vector<std::string> new_expression;
-    std::stack<std::string> stack;
-    for (const auto& i: predicates) {
-        if (i != "AND" && i != "OR") {
-            current_predicate.push_back(i);
-        } else {
-            new_expression.push_back(ParsePredicate(current_predicate, element));
-            new_expression.push_back(i);
-            current_predicate.clear();
-        }
-    }
-    new_expression.push_back(ParsePredicate(current_predicate, element));
-    bool is = false;
-    current_predicate.clear();
-    for (const auto& i: new_expression) {
-        if (!is && i != "AND") {
-            current_predicate.push_back(i);
-        } else if (i == "AND" && !is) {
-            is = true;
-        } else {
-            if (!is) {
-                current_predicate.push_back(i);
-            } else {
-                if (!(current_predicate.back() == "true" && i == "true")) {
-                    current_predicate.pop_back();
-                    current_predicate.emplace_back("false");
-                }
-                is = false;
+// Resolves the keys, aggregates and outputs of an aggregating select over `sources`, in source order.
+// Sort keys have to be outputs.
+void PlanAggregate(const SelectStatement& statement, const std::vector<Predicate::Source>& sources, SelectPlan& plan) {
+    auto resolve = [&sources](const ColumnReference& reference) {
+        return Resolve(reference, sources);
+    };
+    auto same = [](const SourceColumn& first, const SourceColumn& second) {
+        return first.source == second.source && first.ordinal == second.ordinal;
+    };
+
+    plan.is_aggregate = true;
+    for (const auto& i: statement.group_by) {
+        plan.group_by.push_back(resolve(i));
+    }
+    if (plan.group_by.size() >= 64) {
+        throw std::logic_error("Too many grouping columns");
+    }
+    for (size_t i = 0; i < statement.columns.size(); ++i) {
+        const ColumnReference& reference = statement.columns[i];
+        AggregateFunction function = i < statement.functions.size() ? statement.functions[i] : AggregateFunction::NONE;
+        if (function == AggregateFunction::NONE) {
+            if (reference.column == "*") {
+                throw std::logic_error("Column must be grouped");
             }
+            SourceColumn column = resolve(reference);
+            auto key = std::find_if(plan.group_by.begin(), plan.group_by.end(), [&](const SourceColumn& key) {
+                return same(key, column);
+            });
+            if (key == plan.group_by.end()) {
+                throw std::logic_error("Column must be grouped");
+            }
+            plan.outputs.emplace_back(true, key - plan.group_by.begin());
+            plan.names.push_back(reference.column);
+            continue;
         }
-    }
-    new_expression.clear();
-    for (const auto& i: current_predicate) {
-        if (new_expression.empty()) {
-            new_expression.push_back(i);
-        } else if (i != "OR") {
-            if (!(i == "false" && new_expression.back() == "false")) {
-                new_expression.pop_back();
-                new_expression.emplace_back("true");
+        Aggregate aggregate;
+        aggregate.function = function;
+        aggregate.has_argument = reference.column != "*";
+        if (aggregate.has_argument) {
+            aggregate.argument = resolve(reference);
+            if ((function == AggregateFunction::SUM || function == AggregateFunction::AVG) &&
+                (aggregate.argument.type == TYPE::STRING || aggregate.argument.type == TYPE::BOOL)) {
+                throw std::logic_error("Bad cast");
             }
         }
+        plan.outputs.emplace_back(false, plan.aggregates.size());
+        plan.aggregates.push_back(aggregate);
+        plan.names.push_back(std::string(AggregateName(function)) + "(" + reference.column + ")");
     }
-    return new_expression[0];
-}
-
-std::string ExecuteLogicExpression(const std::vector<std::string>& elements, Element& element) {
-    std::vector<std::string> main_part;
-    std::vector<std::string> string_quotes;
-    std::stack<std::string> stack;
-    bool is_open = false;
-    for (const auto& i: elements) {
-        if (!is_open && (i != "(" && i != ")")) {
-            main_part.push_back(i);
-        } else if (i == "(" && !is_open) {
-            is_open = true;
-        } else if (!is_open && i == ")") {
-            throw std::runtime_error("Syntax error");
-        } else if (is_open) {
-            if (i == "(") {
-                stack.push(i);
-                string_quotes.push_back(i);
-            } else if (i == ")") {
-                if (!stack.empty()) {
-                    stack.pop();
-                    string_quotes.push_back(i);
-                } else {
-                    main_part.emplace_back(ExecuteLogicExpression(string_quotes, element));
-                    string_quotes.clear();
-                    is_open = false;
-                }
-            } else {
-                string_quotes.push_back(i);
+
+    for (const auto& i: statement.order_by) {
+        bool has_argument = i.column.column != "*";
+        SourceColumn column = has_argument ? resolve(i.column) : SourceColumn();
+        auto output = std::find_if(plan.outputs.begin(), plan.outputs.end(), [&](const std::pair<bool, size_t>& output) {
+            if (output.first) {
+                return i.function == AggregateFunction::NONE && same(plan.group_by[output.second], column);
             }
+            const Aggregate& aggregate = plan.aggregates[output.second];
+            return aggregate.function == i.function && aggregate.has_argument == has_argument &&
+                   (!has_argument || same(aggregate.argument, column));
+        });
+        if (output == plan.outputs.end()) {
+            throw std::logic_error("Column must be selected");
         }
+        size_t ordinal = output - plan.outputs.begin();
+        plan.order_by.push_back({{0, ordinal, TYPE::NONE}, i.is_descending});
     }
-    return ParseLogicExpression(main_part, element);
 }
 
-void DataBase::CreateTable(const std::string& request) {
-    std::regex regex(R"(CREATE\s+TABLE\s+(\w+)\s+\((.*?)\);)");
-    std::regex regex_reference(R"((\w+)(\(\s*(\w+)\s*\)))");
-    std::smatch match;
-    std::smatch new_match;
-    if (std::regex_match(request, match, regex)) {
-        std::string table_name = match[1].str();
-        std::string table_content = match[2].str();
-        tables_[table_name] = Table();
-        std::vector<std::string> columns;
-        SplitString(table_content, columns);
-        for (auto& i: columns) {
-            Column column = ParseColumn(i);
-            if (column.is_primary) {
-                tables_[table_name].GetPrimary() = column.column_name;
-            }
-            if (column.is_null) {
-                tables_[table_name].GetNull().insert(column.column_name);
+// Rows a sorter has to keep: the skipped ones and the returned ones.
+size_t SortLimit(const SelectPlan& plan) {
+    size_t unbounded = std::numeric_limits<size_t>::max();
+    return plan.limit_rows > unbounded - plan.offset_rows ? unbounded : plan.offset_rows + plan.limit_rows;
+}
+
+// Value of a LIMIT or OFFSET clause.
+size_t RowCount(const std::optional<Literal>& literal, const std::vector<Parameter>& parameters, size_t absent) {
+    if (!literal.has_value()) {
+        return absent;
+    }
+    const Parameter& value = Value(*literal, parameters);
+    if (value.Type() != TYPE::INT) {
+        throw std::logic_error("Bad cast");
+    }
+    if (value.GetValue<int>() < 0) {
+        throw std::logic_error("Negative row count");
+    }
+    return value.GetValue<int>();
+}
+
+// Skips the first `offset` rows of `producer` and stops after `limit` more, so a lazy producer stops
+// reading its input early.
+ResultSet::Producer Limit(ResultSet::Producer producer, size_t offset, size_t limit) {
+    if (offset == 0 && limit == std::numeric_limits<size_t>::max()) {
+        return producer;
+    }
+    auto position = std::make_shared<size_t>(0);
+    return [producer = std::move(producer), offset, limit, position](size_t& left, size_t& right) {
+        for (; *position < offset; ++*position) {
+            if (!producer(left, right)) {
+                return false;
             }
-            tables_[table_name].GetParameters()[column.column_name] = column.type;
-            tables_[table_name].GetOrder().push_back(column.column_name);
-            if (column.is_foreign) {
-                if (tables_.find(column.table_name) != tables_.end()) {
-                    if (std::regex_match(column.column_name, new_match, regex_reference)) {
-                        connections_.emplace_back(std::make_pair(table_name, match[1]), match[3]);
-                    }
-                }
+        }
+        if (*position - offset == limit || !producer(left, right)) {
+            return false;
+        }
+        ++*position;
+        return true;
+    };
+}
+
+ResultSet::Producer Sorted(std::vector<std::pair<size_t, size_t>> rows) {
+    auto sorted = std::make_shared<std::vector<std::pair<size_t, size_t>>>(std::move(rows));
+    auto position = std::make_shared<size_t>(0);
+    return [sorted, position](size_t& left, size_t& right) {
+        if (*position == sorted->size()) {
+            return false;
+        }
+        std::tie(left, right) = (*sorted)[(*position)++];
+        return true;
+    };
+}
+
+// Calls `fold(partial, begin, end)` for every morsel of `count` rows, on the pool when there are
+// several. Every thread that takes part folds into a partial of its own: one of `partials`, or a new
+// one made by `make`, which is added to them for merging. There is at least one partial afterwards.
+template<typename T, typename Make, typename Fold>
+void FoldMorsels(size_t count, ThreadPool& pool, std::vector<std::unique_ptr<T>>& partials, Make make, Fold fold) {
+    std::mutex mutex;
+    std::vector<T*> idle;
+    for (const auto& i: partials) {
+        idle.push_back(i.get());
+    }
+    auto run = [&](size_t morsel) {
+        T* partial;
+        {
+            std::lock_guard lock(mutex);
+            if (idle.empty()) {
+                partials.push_back(make());
+                idle.push_back(partials.back().get());
             }
+            partial = idle.back();
+            idle.pop_back();
+        }
+        fold(*partial, morsel * kMorselRows, std::min(count, (morsel + 1) * kMorselRows));
+        std::lock_guard lock(mutex);
+        idle.push_back(partial);
+    };
+
+    size_t morsels = (count + kMorselRows - 1) / kMorselRows;
+    if (morsels < 2 || pool.Size() == 0) {
+        for (size_t i = 0; i < std::max<size_t>(morsels, 1); ++i) {
+            run(i);
         }
     } else {
-        throw std::runtime_error("Syntax error");
+        pool.ForEach(morsels, run);
     }
 }
 
-void DataBase::DropTable(const std::string& input) {
-    std::regex drop_table_regex(R"(^\s*DROP\s+TABLE\s+(\w+)\s*;?\s*$)");
-    std::smatch match;
-    if (std::regex_match(input, match, drop_table_regex)) {
-        std::string table_name = match[1].str();
-        tables_.erase(table_name);
-    } else {
-        throw std::runtime_error("Syntax error");
+// Visible candidates in [begin, end); they are collected in `buffer` unless the candidates are matched.
+const size_t* VisibleRows(const Candidates& candidates, const TableSnapshot& rows, size_t begin, size_t end,
+                          std::vector<size_t>& buffer, size_t& count) {
+    if (candidates.matched) {
+        count = end - begin;
+        return candidates.rows.data() + begin;
+    }
+    for (size_t i = begin; i < end; ++i) {
+        if (rows.Visible(candidates[i])) {
+            buffer.push_back(candidates[i]);
+        }
     }
+    count = buffer.size();
+    return buffer.data();
 }
 
-void DataBase::Insert(const std::string& request) {
-    std::regex pattern(R"(\bINSERT\s+INTO\s+(\w+)\s*(\(([\w\s,]+)\))?\s+VALUES\s*\(([^;]+)\);)");
-    std::smatch match;
-    bool all_columns = false;
-    if (std::regex_match(request, match, pattern)) {
-        std::string table_name = match[1].str();
-        std::string column_names = match[3].str();
-        std::string values = match[4].str();
-        std::vector<std::string> vector_columns;
-        all_columns = column_names.empty();
-        if (!all_columns) {
-            SplitString(column_names, vector_columns);
-        } else {
-            for (const auto& i: tables_[table_name].GetOrder()) {
-                vector_columns.push_back(i);
+// Sorts the visible candidates. With a limit every thread that takes part keeps a sorter of its own;
+// without one every candidate gets a slot of a single sorter, which the morsels fill on the pool.
+std::vector<std::pair<size_t, size_t>> SortRows(const SelectPlan& plan, const TableSnapshot& rows,
+                                                const Candidates& candidates, ThreadPool& pool) {
+    std::vector<const Column*> columns;
+    for (const auto& i: plan.order_by) {
+        columns.push_back(&rows.GetColumn(i.column.ordinal));
+    }
+    RowOrder order(plan.order_by, std::move(columns));
+    size_t limit = SortLimit(plan);
+    auto add = [&](RowSorter& sorter, size_t begin, size_t end) {
+        std::vector<size_t> visible;
+        size_t count;
+        const size_t* positions[] = {VisibleRows(candidates, rows, begin, end, visible, count), nullptr};
+        sorter.Add(positions, count, begin);
+    };
+    std::vector<std::unique_ptr<RowSorter>> partials;
+    if (limit != std::numeric_limits<size_t>::max()) {
+        FoldMorsels(candidates.Count(), pool, partials, [&]() {
+            return std::make_unique<RowSorter>(order, limit);
+        }, add);
+    } else {
+        partials.push_back(std::make_unique<RowSorter>(order, limit));
+        RowSorter& sorter = *partials.front();
+        size_t count = candidates.Count();
+        sorter.Resize(count);
+        auto fill = [&](size_t morsel) {
+            size_t begin = morsel * kMorselRows;
+            size_t end = std::min(count, begin + kMorselRows);
+            std::vector<size_t> positions(end - begin);
+            for (size_t i = begin; i < end; ++i) {
+                size_t row = candidates[i];
+                positions[i - begin] = candidates.matched || rows.Visible(row) ? row : Column::kNullRow;
             }
-        }
-        std::vector<std::string> vector_values;
-        SplitString(values, vector_values);
-        if (tables_.find(table_name) == tables_.end()) {
-            throw std::logic_error("This table does not exist");
-        }
-
-        if (!all_columns) {
-            for (auto& i: vector_columns) {
-                if (tables_[table_name].GetParameters().find(i) == tables_[table_name].GetParameters().end()) {
-                    throw std::logic_error("This parameter does not exist in this table");
-                }
+            const size_t* fill_rows[] = {positions.data(), nullptr};
+            sorter.Fill(begin, fill_rows, end - begin, begin);
+        };
+        size_t morsels = (count + kMorselRows - 1) / kMorselRows;
+        if (morsels < 2 || pool.Size() == 0) {
+            for (size_t i = 0; i < morsels; ++i) {
+                fill(i);
             }
+        } else {
+            pool.ForEach(morsels, fill);
         }
+    }
+    for (size_t i = 1; i < partials.size(); ++i) {
+        partials[0]->Merge(*partials[i]);
+    }
+    return partials[0]->Finish(pool);
+}
 
-        if (!all_columns) {
-            for (auto& i: tables_[table_name].GetNull()) {
-                if (std::find(vector_columns.begin(), vector_columns.end(), i) == vector_columns.end()) {
-                    throw std::logic_error("NOT NULL parameters is not in parameter list");
-                }
-            }
+// Visible rows that satisfy the predicate in the order of the index on the only sort key, as many as
+// the select needs; rows with NULL keys come last. Probing the index needs the table lock.
+Candidates IndexOrder(const Table& table, const TableSnapshot& rows, const SelectPlan& plan) {
+    Candidates result;
+    result.is_scan = false;
+    result.matched = true;
+    size_t limit = SortLimit(plan);
+    if (limit == 0) {
+        return result;
+    }
+    auto take = [&](size_t row) {
+        if (row < rows.Size() && rows.Visible(row) && (!plan.has_where || plan.predicate(row))) {
+            result.rows.push_back(row);
         }
+        return result.rows.size() < limit;
+    };
+    size_t column = plan.order_by.front().column.ordinal;
+    const auto* index = table.FindIndex(column);
+    if (plan.access.kind == Access::Kind::INDEX) {
+        // The range on the key leaves out NULL keys.
+        Predicate::Bound low;
+        Predicate::Bound high;
+        if (plan.predicate.Range(0, column, low, high)) {
+            index->Scan(low.value, low.inclusive, high.value, high.inclusive, take);
+        }
+        return result;
+    }
+    index->Scan(nullptr, false, nullptr, false, take);
+    const Column& keys = rows.GetColumn(column);
+    for (size_t row = 0; row < rows.Size() && result.rows.size() < limit; ++row) {
+        if (keys.IsNull(row)) {
+            take(row);
+        }
+    }
+    return result;
+}
 
-        Element element = Element();
-        element.GetParameterList() = tables_[table_name].GetParameters();
-        element.GetOrder() = tables_[table_name].GetOrder();
-        for (auto& i: element.GetParameterList()) {
-            element[i.first];
-        }
-
-        for (size_t i = 0; i < vector_columns.size(); ++i) {
-            if (tables_[table_name].GetParameters()[vector_columns[i]] == TYPE::INT) {
-                element[vector_columns[i]] = CastFromString<int>(vector_values[i]);
-                element[vector_columns[i]].Type() = TYPE::INT;
-            } else if (tables_[table_name].GetParameters()[vector_columns[i]] == TYPE::BOOL) {
-                element[vector_columns[i]] = CastFromString<bool>(vector_values[i]);
-                element[vector_columns[i]].Type() = TYPE::BOOL;
-            } else if (tables_[table_name].GetParameters()[vector_columns[i]] == TYPE::FLOAT) {
-                element[vector_columns[i]] = CastFromString<float>(vector_values[i]);
-                element[vector_columns[i]].Type() = TYPE::FLOAT;
-            } else if (tables_[table_name].GetParameters()[vector_columns[i]] == TYPE::DOUBLE) {
-                element[vector_columns[i]] = CastFromString<double>(vector_values[i]);
-                element[vector_columns[i]].Type() = TYPE::DOUBLE;
-            } else if (tables_[table_name].GetParameters()[vector_columns[i]] == TYPE::STRING) {
-                element[vector_columns[i]] = RemoveQuotes(vector_values[i]);
-                element[vector_columns[i]].Type() = TYPE::STRING;
-            }
+ResultSet AggregateResult(const SelectPlan& plan, const HashAggregate& aggregate, ThreadPool& pool) {
+    auto values = std::make_shared<std::vector<Column>>(aggregate.Finish(plan.outputs));
+    std::vector<ResultSet::ColumnInfo> columns;
+    std::vector<ResultSet::Source> sources;
+    for (size_t i = 0; i < values->size(); ++i) {
+        columns.push_back({plan.names[i], (*values)[i].Type()});
+        sources.push_back({true, &(*values)[i]});
+    }
+    size_t size = values->empty() ? 0 : values->front().Size();
+    ResultSet::Producer producer;
+    if (!plan.order_by.empty()) {
+        std::vector<const Column*> keys;
+        for (const auto& i: plan.order_by) {
+            keys.push_back(&(*values)[i.column.ordinal]);
         }
-        tables_[table_name].GetElement().push_back(element);
+        RowOrder order(plan.order_by, std::move(keys));
+        RowSorter sorter(order, SortLimit(plan));
+        std::vector<size_t> positions(size);
+        std::iota(positions.begin(), positions.end(), 0);
+        const size_t* rows[] = {positions.data(), nullptr};
+        sorter.Add(rows, size, 0);
+        producer = Sorted(sorter.Finish(pool));
     } else {
-        throw std::runtime_error("Syntax error");
-    }
-}
-
-void DataBase::SelectRequest(const std::string& request) {
-
-    std::regex regex_select_pattern1(R"(SELECT\s+(.*?)\s+FROM\s+(.*?);)");
-    std::regex regex_select_pattern2(
-            R"(SELECT\s+(.*?)\s+FROM\s+(.*?)\s*(LEFT|RIGHT|INNER)?\s+JOIN\s+(.*?)\s+ON\s+(.*?);)");
-    std::regex regex_select_pattern3(R"(SELECT\s+(.*?)\s+FROM\s+(.*?)\s+WHERE\s+(.*?);)");
-    std::regex regex_select_pattern4(
-            R"(SELECT\s+(.*?)\s+FROM\s+(.*?)\s*(LEFT|RIGHT|INNER)?\s+JOIN\s+(.*?)\s+ON\s+(.*?)\s+WHERE\s+(.*?);)");
-
-    std::smatch match;
-
-    if (std::regex_match(request, match, regex_select_pattern4)) {
-        std::string columns = match[1].str();
-        std::string type_join = match[3].str();
-        std::string left_table = match[2].str();
-        std::string right_table = match[4].str();
-        std::string on_conditional = match[5].str();
-        std::string where_conditional = match[6].str();
-
-        std::vector<std::pair<std::string, std::string>> tables_with_columns;
-        std::vector<std::string> all_column;
-        SplitString(columns, all_column);
-        std::regex separator(R"((\w+)\.(\w+))");
-        std::smatch tmp;
-        for (const auto& i: all_column) {
-            if (std::regex_match(i, tmp, separator)) {
-                std::string f = tmp[1];
-                std::string s = tmp[2];
-                if (tables_.find(tmp[1]) != tables_.end() &&
-                    tables_[tmp[1]].GetParameters().find(tmp[2]) != tables_[tmp[1]].GetParameters().end()) {
-                    tables_with_columns.emplace_back(tmp[1], tmp[2]);
-                } else {
-                    throw std::logic_error("Table error");
-                }
+        auto position = std::make_shared<size_t>(0);
+        producer = [size, position](size_t& left, size_t&) {
+            if (*position == size) {
+                return false;
             }
+            left = (*position)++;
+            return true;
+        };
+    }
+    ResultSet result(std::move(columns), std::move(sources),
+                     Limit(std::move(producer), plan.offset_rows, plan.limit_rows));
+    result.Hold(std::move(values));
+    return result;
+}
+
+// Morsels are folded into partial aggregates, one for every thread that takes part, which are merged
+// once the scan is over.
+ResultSet AggregateRows(const SelectPlan& plan, const TableSnapshot& rows, const Candidates& candidates,
+                        ThreadPool& pool) {
+    std::vector<std::unique_ptr<HashAggregate>> partials;
+    FoldMorsels(candidates.Count(), pool, partials, [&]() {
+        return std::make_unique<HashAggregate>(plan.group_by, plan.aggregates, std::vector<const TableSnapshot*>{&rows});
+    }, [&](HashAggregate& partial, size_t begin, size_t end) {
+        std::vector<size_t> visible;
+        size_t count;
+        const size_t* positions = VisibleRows(candidates, rows, begin, end, visible, count);
+        partial.Add(&positions, count);
+    });
+    for (size_t i = 1; i < partials.size(); ++i) {
+        partials[0]->Merge(*partials[i]);
+    }
+    return AggregateResult(plan, *partials[0], pool);
+}
+
+}
+
+Table& DataBase::GetTable(const std::string& table_name) {
+    auto table = tables_.find(table_name);
+    if (table == tables_.end()) {
+        throw std::logic_error("This table doesn't exist");
+    }
+    return table->second;
+}
+
+std::shared_ptr<DataBase::Locks> DataBase::LockCatalog() {
+    auto locks = std::make_shared<Locks>();
+    locks->exclusive_catalog = std::unique_lock(catalog_mutex_);
+    return locks;
+}
+
+std::shared_ptr<DataBase::Locks> DataBase::LockTables(const std::vector<std::string>& tables, bool write) {
+    auto locks = std::make_shared<Locks>();
+    locks->catalog = std::shared_lock(catalog_mutex_);
+    std::vector<std::shared_mutex*> mutexes;
+    for (const auto& i: tables) {
+        auto table = tables_.find(i);
+        if (table != tables_.end()) {
+            mutexes.push_back(&table->second.Mutex());
         }
+    }
+    std::sort(mutexes.begin(), mutexes.end());
+    mutexes.erase(std::unique(mutexes.begin(), mutexes.end()), mutexes.end());
+    if (write && !mutexes.empty()) {
+        locks->writer = std::unique_lock(*mutexes.front());
+    }
+    return locks;
+}
 
-        SelectWithWhereAndJoin(tables_with_columns, left_table, right_table, on_conditional,
-                               where_conditional, type_join);
-
-    } else if (std::regex_match(request, match, regex_select_pattern3)) {
-        std::string columns = match[1].str();
-        std::string table1 = match[2].str();
-        std::string where_condition = match[3];
-        std::unordered_set<std::string> select_set;
-        std::vector<std::string> tmp;
-        SplitString(columns, tmp);
-        for (const auto& i: tmp) {
-            select_set.insert(i);
-        }
-        SelectWithWhere(select_set, table1, where_condition);
-    } else if (std::regex_match(request, match, regex_select_pattern2)) {
-        std::string columns = match[1].str();
-        std::string type_join = match[3].str();
-        std::string left_table = match[2].str();
-        std::string right_table = match[4].str();
-        std::string on_conditional = match[5].str();
-
-        std::vector<std::pair<std::string, std::string>> tables_with_columns;
-        std::vector<std::string> all_column;
-        SplitString(columns, all_column);
-        std::regex separator(R"((\w+)\.(\w+))");
-        std::smatch tmp;
-
-        for (const auto& i: all_column) {
-            if (std::regex_match(i, tmp, separator)) {
-                std::string f = tmp[1];
-                std::string s = tmp[2];
-                if (tables_.find(tmp[1]) != tables_.end() &&
-                    tables_[tmp[1]].GetParameters().find(tmp[2]) != tables_[tmp[1]].GetParameters().end()) {
-                    tables_with_columns.emplace_back(tmp[1], tmp[2]);
-                } else {
-                    throw std::logic_error("Table error");
-                }
-            }
+std::shared_ptr<DataBase::Locks> DataBase::Lock(const Statement& statement) {
+    if (auto* insert = std::get_if<InsertStatement>(&statement)) {
+        return LockTables({insert->table}, true);
+    } else if (auto* select = std::get_if<SelectStatement>(&statement)) {
+        if (select->join.has_value()) {
+            return LockTables({select->table, select->join->table}, false);
         }
+        return LockTables({select->table}, false);
+    } else if (auto* update = std::get_if<UpdateStatement>(&statement)) {
+        return LockTables({update->table}, true);
+    } else if (auto* remove = std::get_if<DeleteStatement>(&statement)) {
+        return LockTables({remove->table}, true);
+    } else if (auto* copy = std::get_if<CopyStatement>(&statement)) {
+        return LockTables({copy->table}, !copy->is_export);
+    }
+    return LockCatalog();
+}
 
-        SelectWithJoin(tables_with_columns, left_table, right_table, on_conditional, type_join);
+Plan DataBase::MakePlan(const Statement& statement) {
+    if (auto* create = std::get_if<CreateTableStatement>(&statement)) {
+        return *create;
+    } else if (auto* drop = std::get_if<DropTableStatement>(&statement)) {
+        return *drop;
+    } else if (auto* create_index = std::get_if<CreateIndexStatement>(&statement)) {
+        return *create_index;
+    } else if (auto* drop_index = std::get_if<DropIndexStatement>(&statement)) {
+        return *drop_index;
+    } else if (auto* copy = std::get_if<CopyStatement>(&statement)) {
+        return *copy;
+    } else if (auto* insert = std::get_if<InsertStatement>(&statement)) {
+        return PlanInsert(*insert);
+    } else if (auto* select = std::get_if<SelectStatement>(&statement)) {
+        return PlanSelect(*select);
+    } else if (auto* update = std::get_if<UpdateStatement>(&statement)) {
+        return PlanUpdate(*update);
+    } else {
+        return PlanDelete(std::get<DeleteStatement>(statement));
+    }
+}
 
-    } else if (std::regex_match(request, match, regex_select_pattern1)) {
-        std::string columns = match[1].str();
-        std::string table1 = match[2].str();
-        std::unordered_set<std::string> select_set;
-        std::vector<std::string> tmp;
-        SplitString(columns, tmp);
-        for (const auto& i: tmp) {
-            select_set.insert(i);
-        }
-        Select(select_set, table1);
+ResultSet DataBase::Execute(Plan& plan, const std::vector<Parameter>& parameters) {
+    if (auto* create = std::get_if<CreateTableStatement>(&plan)) {
+        ExecuteCreateTable(*create);
+    } else if (auto* drop = std::get_if<DropTableStatement>(&plan)) {
+        ExecuteDropTable(*drop);
+    } else if (auto* create_index = std::get_if<CreateIndexStatement>(&plan)) {
+        ExecuteCreateIndex(*create_index);
+    } else if (auto* drop_index = std::get_if<DropIndexStatement>(&plan)) {
+        ExecuteDropIndex(*drop_index);
+    } else if (auto* copy = std::get_if<CopyStatement>(&plan)) {
+        ExecuteCopy(*copy);
+    } else if (auto* insert = std::get_if<InsertPlan>(&plan)) {
+        ExecuteInsert(*insert, parameters);
+    } else if (auto* select = std::get_if<SelectPlan>(&plan)) {
+        return ExecuteSelect(*select, parameters);
+    } else if (auto* update = std::get_if<UpdatePlan>(&plan)) {
+        ExecuteUpdate(*update, parameters);
     } else {
-        throw std::runtime_error("Syntax error");
+        ExecuteDelete(std::get<DeletePlan>(plan), parameters);
     }
+    return {};
 }
 
-void DataBase::Select(const std::unordered_set<std::string>& columns, const std::string& table_name) {
-    if (tables_.find(table_name) == tables_.end()) {
-        throw std::logic_error("This table doesn't exist");
+// A change to a table is logged right before it commits, so it is durable before anyone can see it. A
+// change to the catalog is hidden by the catalog lock until the statement is over: the ones that can
+// not fail are logged first, the others are undone when logging fails.
+ResultSet DataBase::ExecuteLogged(Plan& plan, const std::string& request, const std::vector<Parameter>& parameters) {
+    if (log_ == nullptr || std::holds_alternative<SelectPlan>(plan) || std::holds_alternative<CopyStatement>(plan)) {
+        return Execute(plan, parameters);
     }
-    bool all_columns = false;
-    if (columns.size() == 1 && *columns.begin() == "*") {
-        all_columns = true;
+    auto log = [&]() {
+        Log(request, parameters);
+    };
+    std::string table;
+    if (auto* insert = std::get_if<InsertPlan>(&plan)) {
+        table = insert->table;
+    } else if (auto* update = std::get_if<UpdatePlan>(&plan)) {
+        table = update->table;
+    } else if (auto* remove = std::get_if<DeletePlan>(&plan)) {
+        table = remove->table;
     }
-    for (auto& i: tables_[table_name].GetElement()) {
-        for (auto& parameter: i.GetOrder()) {
-            if (all_columns) {
-                i[parameter].Print();
-                std::cout << " ";
-            } else {
-                if (columns.find(parameter) != columns.end()) {
-                    i[parameter].Print();
-                    std::cout << " ";
-                }
-            }
+    if (!table.empty()) {
+        CommitHook hook(GetTable(table), [&log](size_t, size_t) {
+            log();
+        });
+        return Execute(plan, parameters);
+    }
+
+    if (auto* drop_index = std::get_if<DropIndexStatement>(&plan)) {
+        if (std::none_of(tables_.begin(), tables_.end(), [drop_index](const auto& table) {
+            return table.second.HasIndex(drop_index->name);
+        })) {
+            throw std::logic_error("This index does not exist");
+        }
+    }
+    if (std::holds_alternative<DropTableStatement>(plan) || std::holds_alternative<DropIndexStatement>(plan)) {
+        log();
+        return Execute(plan, parameters);
+    }
+    size_t connections = connections_.size();
+    Execute(plan, parameters);
+    try {
+        log();
+    } catch (...) {
+        if (auto* create = std::get_if<CreateTableStatement>(&plan)) {
+            tables_.erase(create->table);
+            connections_.resize(connections);
+        } else {
+            auto& create_index = std::get<CreateIndexStatement>(plan);
+            GetTable(create_index.table).DropIndex(create_index.name);
         }
-        std::cout << "\n";
+        ++schema_version_;
+        throw;
     }
+    return {};
 }
 
-void DataBase::SelectWithWhere(const std::unordered_set<std::string>& columns, const std::string& table_name,
-                               std::string& where_condition) {
-    if (tables_.find(table_name) == tables_.end()) {
-        throw std::logic_error("This table doesn't exist");
+PreparedStatement DataBase::Prepare(const std::string& request) {
+    Parser parser(request);
+    Statement statement = parser.Parse();
+    std::shared_lock lock(catalog_mutex_);
+    return {*this, request, std::move(statement), parser.Placeholders()};
+}
+
+void DataBase::Log(const std::string& request, const std::vector<Parameter>& parameters) {
+    if (log_ == nullptr) {
+        return;
     }
-    bool all_columns = false;
-    if (columns.size() == 1 && *columns.begin() == "*") {
-        all_columns = true;
+    std::string record;
+    AppendValue(record, RecordKind::STATEMENT);
+    AppendString(record, request);
+    AppendValue(record, static_cast<uint32_t>(parameters.size()));
+    for (const auto& i: parameters) {
+        AppendParameter(record, i);
     }
-    for (auto& i: tables_[table_name].GetElement()) {
-        if (CastFromString<bool>(ExecuteLogicExpression(ParseComplexLogic(where_condition), i))) {
-            for (auto& parameter: i.GetOrder()) {
-                if (all_columns) {
-                    i[parameter].Print();
-                    std::cout << " ";
-                } else {
-                    if (columns.find(parameter) != columns.end()) {
-                        i[parameter].Print();
-                        std::cout << " ";
-                    }
-                }
+    log_->Append(record);
+}
+
+void DataBase::LogRows(const std::string& table_name, size_t begin, size_t end) {
+    Table& table = GetTable(table_name);
+    if (log_ == nullptr || begin == end) {
+        return;
+    }
+    std::string record;
+    AppendValue(record, RecordKind::ROWS);
+    AppendString(record, table_name);
+    AppendValue(record, static_cast<uint64_t>(end - begin));
+    AppendValue(record, static_cast<uint32_t>(table.GetColumns().size()));
+    for (size_t i = begin; i < end; ++i) {
+        for (const auto& j: table.GetColumns()) {
+            AppendParameter(record, j.Get(i));
+        }
+    }
+    log_->Append(record);
+}
+
+void DataBase::Apply(std::string_view record) {
+    SnapshotReader reader(record);
+    auto kind = reader.Read<RecordKind>();
+    if (kind == RecordKind::STATEMENT) {
+        std::string request = reader.ReadString();
+        PreparedStatement statement = Prepare(request);
+        auto count = reader.Read<uint32_t>();
+        for (uint32_t i = 0; i < count; ++i) {
+            statement.Bind(i, ReadParameter(reader));
+        }
+        statement.Execute();
+    } else if (kind == RecordKind::ROWS) {
+        std::string table_name = reader.ReadString();
+        std::vector<std::vector<Parameter>> rows(reader.Read<uint64_t>());
+        auto width = reader.Read<uint32_t>();
+        for (auto& i: rows) {
+            i.reserve(width);
+            for (uint32_t j = 0; j < width; ++j) {
+                i.push_back(ReadParameter(reader));
             }
-            std::cout << "\n";
         }
+        BulkInsert(table_name, std::move(rows));
+    } else if (kind == RecordKind::LOAD) {
+        LoadSnapshot(record.substr(sizeof(RecordKind)));
+    } else {
+        throw std::runtime_error("Bad log");
     }
 }
 
-void DataBase::DeleteRequest(const std::string& request) {
-    std::regex regex_delete_pattern1(R"(DELETE\s+FROM\s+(\w+)\s+WHERE\s+(.*);)");
-    std::regex regex_delete_pattern2(R"(DELETE\s+FROM\s+(\w+)\s*;)");
+void DataBase::StartLog(const std::string& path, WalOptions options, uint64_t from) {
+    auto log = std::make_unique<WriteAheadLog>(path, options, from);
+    log->Replay(from, [this](std::string_view record) {
+        Apply(record);
+    });
+    std::unique_lock lock(catalog_mutex_);
+    log_ = std::move(log);
+}
 
-    std::smatch match;
+void DataBase::OpenLog(const std::string& path, WalOptions options) {
+    CloseLog();
+    {
+        std::lock_guard checkpoint(checkpoint_mutex_);
+        std::unique_lock lock(catalog_mutex_);
+        directory_.clear();
+        checkpoint_files_.clear();
+    }
+    StartLog(path, options, 0);
+}
+
+void DataBase::CloseLog() {
+    std::lock_guard checkpoint(checkpoint_mutex_);
+    if (checkpoint_.valid()) {
+        checkpoint_.wait();
+        checkpoint_ = {};
+    }
+    std::unique_lock lock(catalog_mutex_);
+    log_.reset();
+}
+
+void DataBase::Open(const std::string& directory, WalOptions options) {
+    CloseLog();
+    std::filesystem::path root(directory);
+    std::filesystem::create_directories(root);
+    std::string manifest = (root / kManifest).string();
+
+    uint64_t generation = 0;
+    uint64_t position = 0;
+    std::string name = name_;
+    std::unordered_map<std::string, Table> tables;
+    std::vector<Connection> connections;
+    std::unordered_map<std::string, std::pair<size_t, std::string>> files;
+    if (std::filesystem::exists(manifest)) {
+        MappedFile file(manifest);
+        SnapshotReader reader(file.View());
+        if (std::memcmp(reader.ReadBytes(sizeof(kManifestMagic)), kManifestMagic, sizeof(kManifestMagic)) != 0) {
+            throw std::runtime_error("Bad snapshot");
+        }
+        if (reader.Read<uint32_t>() != kManifestVersion) {
+            throw std::runtime_error("Unsupported snapshot version");
+        }
+        generation = reader.Read<uint64_t>();
+        position = reader.Read<uint64_t>();
+        name = reader.ReadString();
+        connections.resize(reader.Read<uint32_t>());
+        for (auto& i: connections) {
+            std::string table_name = reader.ReadString();
+            std::string foreign_table = reader.ReadString();
+            i = Connection(std::make_pair(table_name, foreign_table), reader.ReadString());
+        }
+        auto count = reader.Read<uint32_t>();
+        for (uint32_t i = 0; i < count; ++i) {
+            std::string table_name = reader.ReadString();
+            std::string table_file = reader.ReadString();
+            MappedFile table_data((root / table_file).string());
+            SnapshotReader table_reader(table_data.View());
+            if (std::memcmp(table_reader.ReadBytes(sizeof(kSnapshotMagic)), kSnapshotMagic,
+                            sizeof(kSnapshotMagic)) != 0 || table_reader.Read<uint32_t>() != kSnapshotVersion) {
+                throw std::runtime_error("Bad snapshot");
+            }
+            Table table = Table::Load(table_reader);
+            files[table_name] = {table.Version(), table_file};
+            tables[table_name] = std::move(table);
+        }
+    }
+    for (const auto& i: std::filesystem::directory_iterator(root)) {
+        if (i.path().extension() == kTableExtension &&
+            std::none_of(files.begin(), files.end(), [&i](const auto& file) {
+                return file.second.second == i.path().filename().string();
+            })) {
+            std::error_code error;
+            std::filesystem::remove(i.path(), error);
+        }
+    }
 
-    if (std::regex_match(request, match, regex_delete_pattern1)) {
-        std::string table_name = match[1];
-        std::string where_condition = match[2];
+    {
+        std::lock_guard checkpoint(checkpoint_mutex_);
+        std::unique_lock lock(catalog_mutex_);
+        name_ = std::move(name);
+        tables_ = std::move(tables);
+        connections_ = std::move(connections);
+        ++schema_version_;
+        directory_ = directory;
+        checkpoint_generation_ = generation;
+        checkpoint_files_ = std::move(files);
+    }
+    StartLog((root / kLog).string(), options, position);
+}
 
-        DeleteWithWhere(table_name, where_condition);
-    } else if (std::regex_match(request, match, regex_delete_pattern2)) {
-        std::string table_name = match[1];
+void DataBase::Checkpoint() {
+    std::lock_guard checkpoint(checkpoint_mutex_);
+    WaitForCheckpointLocked();
+    std::shared_lock catalog(catalog_mutex_);
+    if (log_ == nullptr || directory_.empty()) {
+        throw std::logic_error("Database is not opened in a directory");
+    }
+    std::vector<std::shared_mutex*> mutexes;
+    for (const auto& i: tables_) {
+        mutexes.push_back(&i.second.Mutex());
+    }
+    std::sort(mutexes.begin(), mutexes.end());
+    std::vector<std::shared_lock<std::shared_mutex>> readers;
+    for (auto i: mutexes) {
+        readers.emplace_back(*i);
+    }
 
-        Delete(table_name);
-    } else {
-        throw std::runtime_error("Syntax error");
+    CheckpointJob job;
+    job.directory = directory_;
+    job.generation = ++checkpoint_generation_;
+    job.position = log_->Position();
+    job.name = name_;
+    job.connections = connections_;
+    std::unordered_map<std::string, std::pair<size_t, std::string>> files;
+    for (const auto& i: tables_) {
+        auto file = checkpoint_files_.find(i.first);
+        if (file != checkpoint_files_.end() && file->second.first == i.second.Version()) {
+            job.tables.emplace_back(i.first, file->second.second);
+            files.emplace(i.first, file->second);
+            continue;
+        }
+        std::string table_file = i.first + "." + std::to_string(job.generation) + kTableExtension;
+        job.images.emplace_back(table_file, i.second.Image());
+        job.tables.emplace_back(i.first, table_file);
+        files.emplace(i.first, std::make_pair(i.second.Version(), table_file));
+    }
+    for (const auto& i: checkpoint_files_) {
+        auto file = files.find(i.first);
+        if (file == files.end() || file->second.second != i.second.second) {
+            job.obsolete.push_back(i.second.second);
+        }
     }
+    checkpoint_files_ = std::move(files);
+    checkpoint_ = std::async(std::launch::async, [job = std::move(job), log = log_.get()] {
+        WriteCheckpoint(job, *log);
+    });
+}
 
+void DataBase::WaitForCheckpoint() {
+    std::lock_guard checkpoint(checkpoint_mutex_);
+    WaitForCheckpointLocked();
 }
 
-void DataBase::Delete(const std::string& table_name) {
-    if (tables_.find(table_name) == tables_.end()) {
-        throw std::logic_error("This table doesn't exist");
+DataBase::~DataBase() {
+    std::lock_guard lock(collector_mutex_);
+    if (collector_.valid()) {
+        collector_.wait();
     }
-    tables_[table_name].GetElement().clear();
 }
 
-void DataBase::DeleteWithWhere(const std::string& table_name, std::string& where_condition) {
-    if (tables_.find(table_name) == tables_.end()) {
-        throw std::logic_error("This table doesn't exist");
+void DataBase::NotifyCollector(const Table& table) {
+    if (table.Garbage() == 0 || table.Garbage() * 4 < table.Size()) {
+        return;
     }
-    for (auto i = tables_[table_name].GetElement().begin(); i != tables_[table_name].GetElement().end();) {
-        if (CastFromString<bool>(ExecuteLogicExpression(ParseComplexLogic(where_condition), *i))) {
-            i = tables_[table_name].GetElement().erase(i);
-        } else {
-            ++i;
+    std::lock_guard lock(collector_mutex_);
+    if (collector_.valid() && collector_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+    collector_ = std::async(std::launch::async, [this] {
+        Collect(false);
+    });
+}
+
+void DataBase::Collect(bool force) {
+    std::shared_lock catalog(catalog_mutex_);
+    for (auto& i: tables_) {
+        std::unique_lock writer(i.second.Mutex());
+        if (i.second.Garbage() != 0 && (force || i.second.Garbage() * 4 >= i.second.Size())) {
+            i.second.Collect();
         }
     }
 }
 
-void DataBase::UpdateRequest(const std::string& request) {
-    std::regex update_regex_pattern1(R"(\s*UPDATE\s+(\w+)\s+SET\s+(.*)\s+WHERE\s+(.*);)");
-    std::regex update_regex_pattern2(R"(\s*UPDATE\s+(\w+)\s+SET\s+(.*);)");
+void DataBase::CollectGarbage() {
+    Collect(true);
+}
 
-    std::smatch match;
+void DataBase::SetParallelism(size_t parallelism) {
+    if (parallelism == 0) {
+        throw std::logic_error("Parallelism must be positive");
+    }
+    std::unique_lock lock(catalog_mutex_);
+    pool_ = std::make_unique<ThreadPool>(parallelism - 1);
+}
 
-    if (std::regex_match(request, match, update_regex_pattern1)) {
-        std::string table_name = match[1];
-        std::string set_values = match[2];
-        std::string where_condition = match[3];
+void DataBase::WaitForCheckpointLocked() {
+    if (!checkpoint_.valid()) {
+        return;
+    }
+    try {
+        checkpoint_.get();
+    } catch (...) {
+        checkpoint_files_.clear();
+        throw;
+    }
+}
 
-        UpdateWithWhere(table_name, set_values, where_condition);
-    } else if (std::regex_match(request, match, update_regex_pattern2)) {
-        std::string table_name = match[1];
-        std::string set_values = match[2];
+void DataBase::CreateTable(const std::string& request) {
+    Plan plan = ParseStatement<CreateTableStatement>(request);
+    auto locks = LockCatalog();
+    ExecuteLogged(plan, request, {});
+}
 
-        Update(table_name, set_values);
+void DataBase::ExecuteCreateTable(const CreateTableStatement& statement) {
+    if (tables_.find(statement.table) != tables_.end()) {
+        throw std::logic_error("This table already exists");
+    }
+    Table table;
+    for (auto& column: statement.columns) {
+        table.AddColumn(column.name, column.type, column.is_not_null);
+        if (column.is_primary) {
+            table.SetPrimary(column.name);
+        }
+        if (!column.foreign_table.empty()) {
+            if (tables_.find(column.foreign_table) == tables_.end()) {
+                throw std::logic_error("This table does not exist");
+            }
+            connections_.emplace_back(std::make_pair(statement.table, column.foreign_table), column.name);
+        }
     }
+    tables_[statement.table] = std::move(table);
+    ++schema_version_;
+}
 
+void DataBase::DropTable(const std::string& request) {
+    Plan plan = ParseStatement<DropTableStatement>(request);
+    auto locks = LockCatalog();
+    ExecuteLogged(plan, request, {});
 }
 
-std::pair<std::string, Parameter> DataBase::SetValue(const std::string& table_name, const std::string& input) {
-    std::regex regex(R"(\s*(\w+)\s*=\s*([",']?[\w,\s]+[",']?))");
-    std::smatch match;
-    Parameter parameter_value;
-    if (std::regex_match(input, match, regex)) {
+void DataBase::ExecuteDropTable(const DropTableStatement& statement) {
+    tables_.erase(statement.table);
+    ++schema_version_;
+}
 
-        std::string name = match[1];
-        std::string value = match[2];
+void DataBase::CreateIndex(const std::string& request) {
+    Plan plan = ParseStatement<CreateIndexStatement>(request);
+    auto locks = LockCatalog();
+    ExecuteLogged(plan, request, {});
+}
 
-        if (tables_[table_name].GetParameters().find(name) != tables_[table_name].GetParameters().end()) {
-            if (IsDigit(value)) {
-                if (tables_[table_name].GetParameters()[name] == TYPE::INT) {
-                    parameter_value = std::stoi(value);
-                } else if (tables_[table_name].GetParameters()[name] == TYPE::FLOAT) {
-                    parameter_value = std::stof(value);
-                } else if (tables_[table_name].GetParameters()[name] == TYPE::DOUBLE) {
-                    parameter_value = std::stod(value);
-                } else {
-                    throw std::logic_error("Different types of parameters");
-                }
-            } else if (IsString(value)) {
-                if (tables_[table_name].GetParameters()[name] == TYPE::STRING) {
-                    parameter_value = RemoveQuotes(value);
-                } else {
-                    throw std::logic_error("Different types of parameters");
-                }
-            } else if (IsBool(value)) {
-                if (tables_[table_name].GetParameters()[name] == TYPE::BOOL) {
-                    parameter_value = (value == "true");
-                } else {
-                    throw std::logic_error("Different types of parameters");
-                }
-            }
+void DataBase::ExecuteCreateIndex(const CreateIndexStatement& statement) {
+    for (auto& i: tables_) {
+        if (i.second.HasIndex(statement.name)) {
+            throw std::logic_error("This index already exists");
         }
-        return std::make_pair(name, parameter_value);
-    } else {
-        throw std::runtime_error("Syntax error");
     }
+    Table& table = GetTable(statement.table);
+    table.CreateIndex(statement.name, table.GetSchema().Ordinal(statement.column));
+    ++schema_version_;
 }
 
-void
-DataBase::UpdateWithWhere(const std::string& table_name, const std::string& new_values, std::string& where_condition) {
-    if (tables_.find(table_name) == tables_.end()) {
-        throw std::logic_error("This table doesn't exist");
+void DataBase::DropIndex(const std::string& request) {
+    Plan plan = ParseStatement<DropIndexStatement>(request);
+    auto locks = LockCatalog();
+    ExecuteLogged(plan, request, {});
+}
+
+void DataBase::ExecuteDropIndex(const DropIndexStatement& statement) {
+    for (auto& i: tables_) {
+        if (i.second.DropIndex(statement.name)) {
+            ++schema_version_;
+            return;
+        }
     }
-    std::vector<std::string> vector_values;
-    SplitString(new_values, vector_values);
+    throw std::logic_error("This index does not exist");
+}
 
-    std::vector<std::pair<std::string, Parameter>> values;
+void DataBase::Insert(const std::string& request) {
+    auto statement = ParseStatement<InsertStatement>(request);
+    auto locks = LockTables({statement.table}, true);
+    Plan plan = PlanInsert(statement);
+    ExecuteLogged(plan, request, {});
+}
 
-    values.reserve(vector_values.size());
-    for (const auto& i: vector_values) {
-        values.push_back(SetValue(table_name, i));
+InsertPlan DataBase::PlanInsert(const InsertStatement& statement) {
+    auto table = tables_.find(statement.table);
+    if (table == tables_.end()) {
+        throw std::logic_error("This table does not exist");
     }
 
-    for (auto& i: tables_[table_name].GetElement()) {
-        if (CastFromString<bool>(ExecuteLogicExpression(ParseComplexLogic(where_condition), i))) {
-            for (auto& value: values) {
-                i[value.first] = value.second;
-            }
+    InsertPlan plan;
+    plan.table = statement.table;
+    Schema& schema = table->second.GetSchema();
+    if (statement.columns.empty()) {
+        for (size_t i = 0; i < schema.Size(); ++i) {
+            plan.columns.push_back(i);
+        }
+    } else {
+        for (auto& i: statement.columns) {
+            plan.columns.push_back(schema.Ordinal(i));
         }
     }
-}
 
-void DataBase::Update(const std::string& table_name, const std::string& new_values) {
-    if (tables_.find(table_name) == tables_.end()) {
-        throw std::logic_error("This table doesn't exist");
+    for (auto i: plan.columns) {
+        plan.types.push_back(schema.Type(i));
+    }
+    for (const auto& i: statement.values) {
+        if (plan.columns.size() != i.size()) {
+            throw std::logic_error("Wrong number of values");
+        }
+    }
+    for (size_t i = 0; i < schema.Size(); ++i) {
+        if (schema.IsNotNull(i) && std::find(plan.columns.begin(), plan.columns.end(), i) == plan.columns.end()) {
+            throw std::logic_error("NOT NULL parameters is not in parameter list");
+        }
     }
-    std::vector<std::string> vector_values;
-    SplitString(new_values, vector_values);
 
-    std::vector<std::pair<std::string, Parameter>> values;
+    plan.values = statement.values;
+    for (auto& row: plan.values) {
+        for (size_t i = 0; i < row.size(); ++i) {
+            if (!row[i].is_placeholder) {
+                CheckNotNull(table->second, plan.columns[i], row[i].value);
+                row[i].value = CastParameter(row[i].value, plan.types[i]);
+            }
+        }
+    }
+    return plan;
+}
 
-    values.reserve(vector_values.size());
-    for (const auto& i: vector_values) {
-        values.push_back(SetValue(table_name, i));
+void DataBase::ExecuteInsert(const InsertPlan& plan, const std::vector<Parameter>& parameters) {
+    Table& table = GetTable(plan.table);
+    size_t width = table.GetSchema().Size();
+    if (plan.values.size() == 1) {
+        std::vector<Parameter> row(width);
+        for (size_t i = 0; i < plan.columns.size(); ++i) {
+            const Parameter& value = Value(plan.values[0][i], parameters);
+            if (plan.values[0][i].is_placeholder) {
+                CheckNotNull(table, plan.columns[i], value);
+            }
+            row[plan.columns[i]] = value;
+        }
+        table.Append(row);
+        return;
     }
 
-    for (auto& i: tables_[table_name].GetElement()) {
-        for (auto& value: values) {
-            i[value.first] = value.second;
+    std::vector<std::vector<Parameter>> rows(plan.values.size(), std::vector<Parameter>(width));
+    for (size_t i = 0; i < plan.values.size(); ++i) {
+        for (size_t j = 0; j < plan.columns.size(); ++j) {
+            const Parameter& value = Value(plan.values[i][j], parameters);
+            if (plan.values[i][j].is_placeholder) {
+                CheckNotNull(table, plan.columns[j], value);
+            }
+            rows[i][plan.columns[j]] = value;
         }
     }
+    table.Append(rows);
 }
 
-bool DataBase::JoinPredicate(Element& first_element, const std::string& first_column, Element& second_element,
-                             const std::string& sign) {
-    if (sign == "=") {
-        return first_element[first_column] == second_element[first_column];
-    } else if (sign == ">") {
-        return first_element[first_column] > second_element[first_column];
-    } else if (sign == "<") {
-        return first_element[first_column] < second_element[first_column];
-    } else {
-        return false;
+void DataBase::BulkInsert(const std::string& table_name, std::vector<std::vector<Parameter>> rows) {
+    auto locks = LockTables({table_name}, true);
+    Table& table = GetTable(table_name);
+    Schema& schema = table.GetSchema();
+    for (auto& row: rows) {
+        if (row.size() != schema.Size()) {
+            throw std::logic_error("Wrong number of values");
+        }
+        for (size_t i = 0; i < row.size(); ++i) {
+            CheckNotNull(table, i, row[i]);
+            if (row[i].Type() != TYPE::NONE && row[i].Type() != schema.Type(i)) {
+                row[i] = CastParameter(row[i], schema.Type(i));
+            }
+        }
     }
+    CommitHook hook(table, [&](size_t begin, size_t end) {
+        LogRows(table_name, begin, end);
+    });
+    table.Append(rows);
+}
+
+void DataBase::Copy(const std::string& request) {
+    auto statement = ParseStatement<CopyStatement>(request);
+    auto locks = LockTables({statement.table}, !statement.is_export);
+    ExecuteCopy(statement);
 }
 
-void DataBase::SelectWithJoin(const std::vector<std::pair<std::string, std::string>>& columns_list,
-                              const std::string& left_table, const std::string& right_table,
-                              const std::string& on_conditional, const std::string& type) {
-    Table tmp_table;
-    Element tmp_element;
-    for (const auto& i: columns_list) {
-        tmp_table.GetParameters()[i.second] = tables_[i.first].GetParameters()[i.second];
-        tmp_element.GetOrder().push_back(i.second);
-        tmp_element[i.second];
+void DataBase::ExecuteCopy(const CopyStatement& statement) {
+    Table& table = GetTable(statement.table);
+    if (!statement.is_export) {
+        MappedFile file(statement.path);
+        CommitHook hook(table, [&](size_t begin, size_t end) {
+            LogRows(statement.table, begin, end);
+        });
+        ReadCsv(table, file.View());
+        return;
     }
+    std::ofstream output(statement.path, std::ios::binary);
+    if (!output) {
+        throw std::runtime_error("Can not open file");
+    }
+    SelectStatement select;
+    select.table = statement.table;
+    select.columns.push_back({"", "*"});
+    ResultSet result = ExecuteSelect(PlanSelect(select), {});
+    Write(result, output, Format::CSV, 1 << 20);
+    output.flush();
+    if (!output) {
+        throw std::runtime_error("Can not write file");
+    }
+}
 
-    std::regex on_conditional_pattern(R"(\w+\.(\w+)\s+([=|>|<])\s+\w+\.\w+)");
-    std::smatch tmp;
-    std::string related_column;
-    std::string sign;
-    if (std::regex_match(on_conditional, tmp, on_conditional_pattern)) {
-        related_column = tmp[1].str();
-        sign = tmp[2].str();
-    } else {
-        throw std::runtime_error("Syntax error");
-    }
-
-    if (type == "INNER") {
-        for (auto& i: tables_[left_table].GetElement()) {
-            for (auto& j: tables_[right_table].GetElement()) {
-                if (JoinPredicate(i, related_column, j, sign)) {
-                    for (auto& k: columns_list) {
-                        if (k.first == left_table) {
-                            tmp_element[k.second] = i[k.second];
-                        } else {
-                            tmp_element[k.second] = j[k.second];
-                        }
-                    }
-                    tmp_table.GetElement().push_back(tmp_element);
-                }
-            }
+void DataBase::Save(const std::string& path) const {
+    std::shared_lock catalog(catalog_mutex_);
+    std::vector<const Table*> tables;
+    for (const auto& i: tables_) {
+        tables.push_back(&i.second);
+    }
+    std::vector<TableSnapshot> snapshots = Table::Read(tables);
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+        if (!output) {
+            throw std::runtime_error("Can not open file");
         }
-    } else if (type == "LEFT") {
-        for (auto& i: tables_[left_table].GetElement()) {
-            bool find_flag = false;
-            for (auto& j: tables_[right_table].GetElement()) {
-                if (JoinPredicate(i, related_column, j, sign)) {
-                    find_flag = true;
-                    for (auto& k: columns_list) {
-                        if (k.first == left_table) {
-                            tmp_element[k.second] = i[k.second];
-                        } else {
-                            tmp_element[k.second] = j[k.second];
-                        }
-                    }
-                    tmp_table.GetElement().push_back(tmp_element);
+        SnapshotWriter writer(output);
+        writer.WriteBytes(kSnapshotMagic, sizeof(kSnapshotMagic));
+        writer.Write(kSnapshotVersion);
+        writer.WriteString(name_);
+        writer.Write(static_cast<uint32_t>(tables_.size()));
+        size_t index = 0;
+        for (const auto& i: tables_) {
+            writer.WriteString(i.first);
+            i.second.Image(snapshots[index++]).Save(writer);
+        }
+        writer.Write(static_cast<uint32_t>(connections_.size()));
+        for (const auto& i: connections_) {
+            writer.WriteString(i.GetLink().first);
+            writer.WriteString(i.GetLink().second);
+            writer.WriteString(i.GetKey());
+        }
+        writer.Flush();
+        output.flush();
+        if (!output) {
+            throw std::runtime_error("Can not write file");
+        }
+    }
+    std::filesystem::rename(temporary, path);
+}
+
+void DataBase::Load(const std::string& path) {
+    MappedFile file(path);
+    LoadSnapshot(file.View());
+}
+
+void DataBase::LoadSnapshot(std::string_view snapshot) {
+    SnapshotReader reader(snapshot);
+    if (std::memcmp(reader.ReadBytes(sizeof(kSnapshotMagic)), kSnapshotMagic, sizeof(kSnapshotMagic)) != 0) {
+        throw std::runtime_error("Bad snapshot");
+    }
+    if (reader.Read<uint32_t>() != kSnapshotVersion) {
+        throw std::runtime_error("Unsupported snapshot version");
+    }
+    std::string name = reader.ReadString();
+    std::unordered_map<std::string, Table> tables;
+    auto count = reader.Read<uint32_t>();
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string table_name = reader.ReadString();
+        tables[table_name] = Table::Load(reader);
+    }
+    std::vector<Connection> connections(reader.Read<uint32_t>());
+    for (auto& i: connections) {
+        std::string table_name = reader.ReadString();
+        std::string foreign_table = reader.ReadString();
+        i = Connection(std::make_pair(table_name, foreign_table), reader.ReadString());
+    }
+    if (!reader.AtEnd()) {
+        throw std::runtime_error("Bad snapshot");
+    }
+    auto locks = LockCatalog();
+    if (log_ != nullptr) {
+        std::string record;
+        record.reserve(sizeof(RecordKind) + snapshot.size());
+        AppendValue(record, RecordKind::LOAD);
+        record.append(snapshot);
+        log_->Append(record);
+    }
+    name_ = std::move(name);
+    tables_ = std::move(tables);
+    connections_ = std::move(connections);
+    ++schema_version_;
+}
+
+ResultSet DataBase::SelectRequest(const std::string& request) {
+    Statement statement = ParseStatement<SelectStatement>(request);
+    auto locks = Lock(statement);
+    return ExecuteSelect(PlanSelect(std::get<SelectStatement>(statement)), {});
+}
+
+SelectPlan DataBase::PlanSelect(const SelectStatement& statement) {
+    SelectPlan plan;
+    plan.table = statement.table;
+    plan.limit = statement.limit;
+    plan.offset = statement.offset;
+    Table& left = GetTable(statement.table);
+
+    if (!statement.join.has_value()) {
+        Schema& schema = left.GetSchema();
+        if (IsAggregate(statement)) {
+            PlanAggregate(statement, {{statement.table, &left}}, plan);
+        } else {
+            std::vector<bool> projection(schema.Size(), false);
+            for (const auto& i: statement.columns) {
+                if (i.column == "*") {
+                    projection.assign(schema.Size(), true);
+                } else {
+                    projection[schema.Ordinal(i.column)] = true;
                 }
             }
-            if (!find_flag) {
-                for (auto& k: columns_list) {
-                    if (k.first == left_table) {
-                        tmp_element[k.second] = i[k.second];
-                    } else {
-                        tmp_element[k.second] = Parameter();
-                    }
+            for (size_t i = 0; i < projection.size(); ++i) {
+                if (projection[i]) {
+                    plan.columns.push_back(i);
                 }
-                tmp_table.GetElement().push_back(tmp_element);
             }
+            PlanOrder(statement, {{statement.table, &left}}, plan);
         }
-    } else if (type == "RIGHT") {
-        for (auto& i: tables_[right_table].GetElement()) {
-            bool find_flag = false;
-            for (auto& j: tables_[left_table].GetElement()) {
-                if (JoinPredicate(i, related_column, j, sign)) {
-                    find_flag = true;
-                    for (auto& k: columns_list) {
-                        if (k.first == left_table) {
-                            tmp_element[k.second] = j[k.second];
-                        } else {
-                            tmp_element[k.second] = i[k.second];
-                        }
-                    }
-                    tmp_table.GetElement().push_back(tmp_element);
+        if (statement.where.has_value()) {
+            plan.has_where = true;
+            plan.predicate = Predicate(*statement.where, {{statement.table, &left}});
+            plan.access = ChooseAccess(left, plan.predicate);
+        }
+        // Reading a whole index in order only pays off without a filter or when the limit stops it early.
+        if (!plan.is_aggregate && plan.order_by.size() == 1 && !plan.order_by.front().is_descending &&
+            left.FindIndex(plan.order_by.front().column.ordinal) != nullptr &&
+            (!plan.has_where || plan.limit.has_value())) {
+            size_t column = plan.order_by.front().column.ordinal;
+            plan.is_index_order = plan.access.kind == Access::Kind::SCAN ||
+                                  (plan.access.kind == Access::Kind::INDEX && plan.access.column == column);
+        }
+        return plan;
+    }
+
+    const std::string& left_table = statement.table;
+    const std::string& right_table = statement.join->table;
+    Table& right = GetTable(right_table);
+
+    Schema& left_schema = left.GetSchema();
+    Schema& right_schema = right.GetSchema();
+    if (IsAggregate(statement)) {
+        PlanAggregate(statement, {{left_table, &left}, {right_table, &right}}, plan);
+    } else {
+        for (const auto& i: statement.columns) {
+            if (i.column == "*") {
+                for (size_t column = 0; column < left_schema.Size(); ++column) {
+                    plan.columns_list.emplace_back(true, column);
                 }
-            }
-            if (!find_flag) {
-                for (auto& k: columns_list) {
-                    if (k.first == right_table) {
-                        tmp_element[k.second] = i[k.second];
-                    } else {
-                        tmp_element[k.second] = Parameter();
-                    }
+                for (size_t column = 0; column < right_schema.Size(); ++column) {
+                    plan.columns_list.emplace_back(false, column);
                 }
-                tmp_table.GetElement().push_back(tmp_element);
+            } else if ((i.table.empty() || i.table == left_table) && left_schema.Contains(i.column)) {
+                plan.columns_list.emplace_back(true, left_schema.Ordinal(i.column));
+            } else if ((i.table.empty() || i.table == right_table) && right_schema.Contains(i.column)) {
+                plan.columns_list.emplace_back(false, right_schema.Ordinal(i.column));
+            } else {
+                throw std::logic_error("Table error");
             }
         }
+        PlanOrder(statement, {{left_table, &left}, {right_table, &right}}, plan);
     }
 
-    for (auto& i: tmp_table.GetElement()) {
-        for (auto& parameter: i.GetOrder()) {
-            if (i[parameter].Type() == TYPE::NONE) {
-                std::cout << "NULL";
-            } else {
-                i[parameter].Print();
-            }
-            std::cout << " ";
+    plan.join = statement.join;
+    if (plan.join->left.table == right_table || plan.join->right.table == left_table) {
+        std::swap(plan.join->left, plan.join->right);
+        plan.join->sign = Mirror(plan.join->sign);
+    }
+    if (!left_schema.Contains(plan.join->left.column) || !right_schema.Contains(plan.join->right.column)) {
+        throw std::logic_error("Table error");
+    }
+    plan.left_column = left_schema.Ordinal(plan.join->left.column);
+    plan.right_column = right_schema.Ordinal(plan.join->right.column);
+    if (left_schema.Type(plan.left_column) != right_schema.Type(plan.right_column)) {
+        throw std::logic_error("Different types of parameters");
+    }
+    if (plan.join->sign == CompareOperator::EQUAL) {
+        plan.join_method = JoinMethod::HASH;
+    } else if (plan.join->sign != CompareOperator::NOT_EQUAL) {
+        plan.join_method = JoinMethod::MERGE;
+    }
+
+    if (statement.where.has_value()) {
+        plan.has_where = true;
+        plan.predicate = Predicate(*statement.where, {{left_table, &left}, {right_table, &right}});
+    }
+    return plan;
+}
+
+ResultSet DataBase::ExecuteSelect(SelectPlan plan, const std::vector<Parameter>& parameters) {
+    if (plan.has_where) {
+        plan.predicate.Bind(parameters);
+    }
+    plan.offset_rows = RowCount(plan.offset, parameters, 0);
+    plan.limit_rows = RowCount(plan.limit, parameters, std::numeric_limits<size_t>::max());
+    auto shared = std::make_shared<SelectPlan>(std::move(plan));
+    if (shared->join.has_value()) {
+        if (shared->has_where) {
+            return SelectWithWhereAndJoin(shared);
+        } else {
+            return SelectWithJoin(shared);
+        }
+    } else {
+        if (shared->has_where) {
+            return SelectWithWhere(shared);
+        } else {
+            return Select(shared);
         }
-        std::cout << "\n";
     }
 }
 
-void DataBase::SelectWithWhereAndJoin(const std::vector<std::pair<std::string, std::string>>& columns_list,
-                                      const std::string& left_table, const std::string& right_table,
-                                      const std::string& on_conditional, std::string& where_conditional,
-                                      const std::string& type) {
-    Table tmp_table;
-    Element tmp_element;
-    for (const auto& i: columns_list) {
-        tmp_table.GetParameters()[i.second] = tables_[i.first].GetParameters()[i.second];
-        tmp_element.GetOrder().push_back(i.second);
-        tmp_element[i.second];
+ResultSet DataBase::Select(const std::shared_ptr<SelectPlan>& plan) {
+    return SelectWithWhere(plan);
+}
+
+ResultSet DataBase::SelectWithWhere(const std::shared_ptr<SelectPlan>& plan) {
+    Table& table = GetTable(plan->table);
+    auto snapshots = std::make_shared<std::vector<TableSnapshot>>();
+    auto candidates = std::make_shared<Candidates>();
+    if (plan->is_index_order) {
+        std::shared_lock reader(table.Mutex());
+        *snapshots = Table::Read({&table});
+        plan->predicate.Attach({&snapshots->front()});
+        *candidates = IndexOrder(table, snapshots->front(), *plan);
+    } else if (plan->access.kind == Access::Kind::SCAN) {
+        *snapshots = Table::Read({&table});
+        *candidates = FindCandidates(table, snapshots->front(), plan->predicate, plan->access);
+    } else {
+        std::shared_lock reader(table.Mutex());
+        *snapshots = Table::Read({&table});
+        *candidates = FindCandidates(table, snapshots->front(), plan->predicate, plan->access);
+    }
+    const TableSnapshot& rows = snapshots->front();
+    plan->predicate.Attach({&rows});
+    // A limit without an order lets the rows be filtered one by one as they are read, up to the limit.
+    bool is_lazy = plan->order_by.empty() && plan->limit.has_value() && !plan->is_aggregate;
+    if (plan->has_where && !plan->is_index_order && !is_lazy) {
+        *candidates = Filter(*candidates, rows, plan->predicate, *pool_);
+    }
+    if (plan->is_aggregate) {
+        return AggregateRows(*plan, rows, *candidates, *pool_);
+    }
+
+    std::vector<ResultSet::ColumnInfo> columns;
+    std::vector<ResultSet::Source> sources;
+    for (auto i: plan->columns) {
+        columns.push_back({table.GetSchema().Name(i), table.GetSchema().Type(i)});
+        sources.push_back({true, &rows.GetColumn(i)});
     }
 
-    std::regex on_conditional_pattern(R"(\w+\.(\w+)\s+([=|>|<])\s+\w+\.\w+)");
-    std::smatch tmp;
-    std::string related_column;
-    std::string sign;
-    if (std::regex_match(on_conditional, tmp, on_conditional_pattern)) {
-        related_column = tmp[1].str();
-        sign = tmp[2].str();
+    ResultSet::Producer producer;
+    if (!plan->order_by.empty() && !plan->is_index_order) {
+        producer = Sorted(SortRows(*plan, rows, *candidates, *pool_));
     } else {
-        throw std::runtime_error("Syntax error");
-    }
-
-    if (type == "INNER") {
-        for (auto& i: tables_[left_table].GetElement()) {
-            for (auto& j: tables_[right_table].GetElement()) {
-                if (JoinPredicate(i, related_column, j, sign)) {
-                    for (auto& k: columns_list) {
-                        if (k.first == left_table) {
-                            tmp_element[k.second] = i[k.second];
-                        } else {
-                            tmp_element[k.second] = j[k.second];
-                        }
-                    }
-                    tmp_table.GetElement().push_back(tmp_element);
+        auto position = std::make_shared<size_t>(0);
+        producer = [plan, &rows, candidates, position](size_t& left, size_t&) {
+            while (*position < candidates->Count()) {
+                size_t row = (*candidates)[(*position)++];
+                if (candidates->matched || (rows.Visible(row) && (!plan->has_where || plan->predicate(row)))) {
+                    left = row;
+                    return true;
                 }
             }
+            return false;
+        };
+    }
+    ResultSet result(std::move(columns), std::move(sources),
+                     Limit(std::move(producer), plan->offset_rows, plan->limit_rows));
+    result.Hold(std::move(snapshots));
+    return result;
+}
+
+void DataBase::DeleteRequest(const std::string& request) {
+    auto statement = ParseStatement<DeleteStatement>(request);
+    auto locks = LockTables({statement.table}, true);
+    Plan plan = PlanDelete(statement);
+    ExecuteLogged(plan, request, {});
+}
+
+DeletePlan DataBase::PlanDelete(const DeleteStatement& statement) {
+    DeletePlan plan;
+    plan.table = statement.table;
+    Table& table = GetTable(statement.table);
+    if (statement.where.has_value()) {
+        plan.has_where = true;
+        plan.predicate = Predicate(*statement.where, {{statement.table, &table}});
+        plan.access = ChooseAccess(table, plan.predicate);
+    }
+    return plan;
+}
+
+void DataBase::ExecuteDelete(DeletePlan& plan, const std::vector<Parameter>& parameters) {
+    if (plan.has_where) {
+        plan.predicate.Bind(parameters);
+        DeleteWithWhere(plan);
+    } else {
+        Delete(plan.table);
+    }
+}
+
+void DataBase::Delete(const std::string& table_name) {
+    Table& table = GetTable(table_name);
+    table.Clear();
+    NotifyCollector(table);
+}
+
+void DataBase::DeleteWithWhere(DeletePlan& plan) {
+    Table& table = GetTable(plan.table);
+    TableSnapshot rows = table.Read();
+    plan.predicate.Attach({&rows});
+    Candidates dead = Filter(FindCandidates(table, rows, plan.predicate, plan.access), rows, plan.predicate, *pool_);
+    table.Erase(dead.rows);
+    NotifyCollector(table);
+}
+
+void DataBase::UpdateRequest(const std::string& request) {
+    auto statement = ParseStatement<UpdateStatement>(request);
+    auto locks = LockTables({statement.table}, true);
+    Plan plan = PlanUpdate(statement);
+    ExecuteLogged(plan, request, {});
+}
+
+std::pair<size_t, Literal> DataBase::SetValue(const std::string& table_name, const Assignment& assignment) {
+    Table& table = GetTable(table_name);
+    size_t column = table.GetSchema().Ordinal(assignment.column);
+    Literal value = assignment.value;
+    if (!value.is_placeholder) {
+        CheckNotNull(table, column, value.value);
+        value.value = CastParameter(value.value, table.GetSchema().Type(column));
+    }
+    return std::make_pair(column, value);
+}
+
+UpdatePlan DataBase::PlanUpdate(const UpdateStatement& statement) {
+    UpdatePlan plan;
+    plan.table = statement.table;
+    Table& table = GetTable(statement.table);
+    std::vector<Assignment> assignments = statement.assignments;
+    if (table.GetSchema().HasPrimary()) {
+        std::stable_partition(assignments.begin(), assignments.end(), [&](const Assignment& assignment) {
+            return assignment.column == table.GetPrimary();
+        });
+    }
+    for (const auto& i: assignments) {
+        auto value = SetValue(statement.table, i);
+        plan.columns.push_back(value.first);
+        plan.types.push_back(table.GetSchema().Type(value.first));
+        plan.values.push_back(std::move(value.second));
+    }
+    if (statement.where.has_value()) {
+        plan.has_where = true;
+        plan.predicate = Predicate(*statement.where, {{statement.table, &table}});
+        plan.access = ChooseAccess(table, plan.predicate);
+    }
+    return plan;
+}
+
+void DataBase::ExecuteUpdate(UpdatePlan& plan, const std::vector<Parameter>& parameters) {
+    if (plan.has_where) {
+        plan.predicate.Bind(parameters);
+        UpdateWithWhere(plan, parameters);
+    } else {
+        Update(plan, parameters);
+    }
+}
+
+void DataBase::UpdateWithWhere(UpdatePlan& plan, const std::vector<Parameter>& parameters) {
+    Table& table = GetTable(plan.table);
+    std::vector<std::pair<size_t, Parameter>> values;
+    for (size_t i = 0; i < plan.values.size(); ++i) {
+        CheckNotNull(table, plan.columns[i], Value(plan.values[i], parameters));
+        values.emplace_back(plan.columns[i], Value(plan.values[i], parameters));
+    }
+
+    TableSnapshot snapshot = table.Read();
+    plan.predicate.Attach({&snapshot});
+    Candidates rows = Filter(FindCandidates(table, snapshot, plan.predicate, plan.access), snapshot, plan.predicate,
+                             *pool_);
+    table.Update(rows.rows, values);
+    NotifyCollector(table);
+}
+
+void DataBase::Update(const UpdatePlan& plan, const std::vector<Parameter>& parameters) {
+    Table& table = GetTable(plan.table);
+    std::vector<std::pair<size_t, Parameter>> values;
+    for (size_t i = 0; i < plan.values.size(); ++i) {
+        CheckNotNull(table, plan.columns[i], Value(plan.values[i], parameters));
+        values.emplace_back(plan.columns[i], Value(plan.values[i], parameters));
+    }
+
+    TableSnapshot snapshot = table.Read();
+    std::vector<size_t> rows;
+    for (size_t i = 0; i < snapshot.Size(); ++i) {
+        if (snapshot.Visible(i)) {
+            rows.push_back(i);
         }
-    } else if (type == "LEFT") {
-        for (auto& i: tables_[left_table].GetElement()) {
-            bool find_flag = false;
-            for (auto& j: tables_[right_table].GetElement()) {
-                if (JoinPredicate(i, related_column, j, sign)) {
-                    find_flag = true;
-                    for (auto& k: columns_list) {
-                        if (k.first == left_table) {
-                            tmp_element[k.second] = i[k.second];
-                        } else {
-                            tmp_element[k.second] = j[k.second];
-                        }
-                    }
-                    tmp_table.GetElement().push_back(tmp_element);
-                }
+    }
+    table.Update(rows, values);
+    NotifyCollector(table);
+}
+
+ResultSet DataBase::SelectWithJoin(const std::shared_ptr<SelectPlan>& plan) {
+    return SelectWithWhereAndJoin(plan);
+}
+
+ResultSet DataBase::SelectWithWhereAndJoin(const std::shared_ptr<SelectPlan>& plan) {
+    Table& left = GetTable(plan->table);
+    Table& right = GetTable(plan->join->table);
+    auto snapshots = std::make_shared<std::vector<TableSnapshot>>(Table::Read({&left, &right}));
+    const TableSnapshot& left_rows = (*snapshots)[0];
+    const TableSnapshot& right_rows = (*snapshots)[1];
+    plan->predicate.Attach({&left_rows, &right_rows});
+
+    std::vector<ResultSet::ColumnInfo> columns;
+    std::vector<ResultSet::Source> sources;
+    for (auto& i: plan->columns_list) {
+        Table& table = i.first ? left : right;
+        columns.push_back({table.GetSchema().Name(i.second), table.GetSchema().Type(i.second)});
+        sources.push_back({i.first, &(i.first ? left_rows : right_rows).GetColumn(i.second)});
+    }
+
+    std::shared_ptr<JoinCursor> cursor;
+    if (plan->join_method == JoinMethod::HASH) {
+        cursor = MakeHashJoin(left_rows, plan->left_column, right_rows, plan->right_column, plan->join->type);
+    } else if (plan->join_method == JoinMethod::MERGE) {
+        cursor = MakeMergeJoin(left_rows, plan->left_column, right_rows, plan->right_column, plan->join->sign,
+                               plan->join->type);
+    } else {
+        cursor = std::make_shared<NestedLoopJoin>(left_rows, plan->left_column, right_rows, plan->right_column,
+                                                  plan->join->sign, plan->join->type);
+    }
+    // Aggregates and sorts take the joined rows in batches of up to `batch` (left, right) pairs.
+    auto each_batch = [&](size_t batch, const std::function<void(const size_t* const*, size_t)>& add) {
+        std::vector<size_t> pairs[2];
+        auto flush = [&]() {
+            const size_t* rows[] = {pairs[0].data(), pairs[1].data()};
+            add(rows, pairs[0].size());
+            pairs[0].clear();
+            pairs[1].clear();
+        };
+        size_t left_row;
+        size_t right_row;
+        while (cursor->Next(left_row, right_row)) {
+            if (plan->has_where && !plan->predicate(left_row, right_row)) {
+                continue;
             }
-            if (!find_flag) {
-                for (auto& k: columns_list) {
-                    if (k.first == left_table) {
-                        tmp_element[k.second] = i[k.second];
-                    } else {
-                        tmp_element[k.second] = Parameter();
-                    }
-                }
-                tmp_table.GetElement().push_back(tmp_element);
+            pairs[0].push_back(left_row);
+            pairs[1].push_back(right_row);
+            if (pairs[0].size() == batch) {
+                flush();
             }
         }
-    } else if (type == "RIGHT") {
-        for (auto& i: tables_[right_table].GetElement()) {
-            bool find_flag = false;
-            for (auto& j: tables_[left_table].GetElement()) {
-                if (JoinPredicate(i, related_column, j, sign)) {
-                    find_flag = true;
-                    for (auto& k: columns_list) {
-                        if (k.first == left_table) {
-                            tmp_element[k.second] = j[k.second];
-                        } else {
-                            tmp_element[k.second] = i[k.second];
-                        }
-                    }
-                    tmp_table.GetElement().push_back(tmp_element);
-                }
-            }
-            if (!find_flag) {
-                for (auto& k: columns_list) {
-                    if (k.first == right_table) {
-                        tmp_element[k.second] = i[k.second];
-                    } else {
-                        tmp_element[k.second] = Parameter();
-                    }
-                }
-                tmp_table.GetElement().push_back(tmp_element);
-            }
+        flush();
+    };
+    if (plan->is_aggregate) {
+        // The cursor runs on this thread; every batch holds a morsel for each thread, which fold into
+        // partials of their own that are kept across batches and merged at the end.
+        std::vector<std::unique_ptr<HashAggregate>> partials;
+        each_batch(kMorselRows * (pool_->Size() + 1), [&](const size_t* const* rows, size_t count) {
+            FoldMorsels(count, *pool_, partials, [&]() {
+                return std::make_unique<HashAggregate>(plan->group_by, plan->aggregates,
+                                                       std::vector<const TableSnapshot*>{&left_rows, &right_rows});
+            }, [&](HashAggregate& partial, size_t begin, size_t end) {
+                const size_t* morsel[] = {rows[0] + begin, rows[1] + begin};
+                partial.Add(morsel, end - begin);
+            });
+        });
+        for (size_t i = 1; i < partials.size(); ++i) {
+            partials[0]->Merge(*partials[i]);
         }
+        return AggregateResult(*plan, *partials[0], *pool_);
     }
 
-    for (auto& i: tmp_table.GetElement()) {
-        if (CastFromString<bool>(ExecuteLogicExpression(ParseComplexLogic(where_conditional), i))) {
-            for (auto& parameter: i.GetOrder()) {
-                if (i[parameter].Type() == TYPE::NONE) {
-                    std::cout << "NULL";
-                } else {
-                    i[parameter].Print();
+    ResultSet::Producer producer;
+    if (!plan->order_by.empty()) {
+        std::vector<const Column*> keys;
+        for (const auto& i: plan->order_by) {
+            keys.push_back(&(*snapshots)[i.column.source].GetColumn(i.column.ordinal));
+        }
+        RowOrder order(plan->order_by, std::move(keys));
+        RowSorter sorter(order, SortLimit(*plan));
+        uint64_t sequence = 0;
+        each_batch(kMorselRows, [&](const size_t* const* rows, size_t count) {
+            sorter.Add(rows, count, sequence);
+            sequence += count;
+        });
+        producer = Sorted(sorter.Finish(*pool_));
+    } else {
+        producer = [plan, cursor](size_t& left_row, size_t& right_row) {
+            while (cursor->Next(left_row, right_row)) {
+                if (!plan->has_where || plan->predicate(left_row, right_row)) {
+                    return true;
                 }
-                std::cout << " ";
             }
-            std::cout << "\n";
-        }
+            return false;
+        };
     }
-}
\ No newline at end of file
+    ResultSet result(std::move(columns), std::move(sources),
+                     Limit(std::move(producer), plan->offset_rows, plan->limit_rows));
+    result.Hold(std::move(snapshots));
+    return result;
+}
@@ -1,43 +1,121 @@
 #pragma once
 
 #include "table.h"
-#include <regex>
+#include "join.h"
+#include "plan.h"
+#include "result.h"
+#include "statement.h"
+#include "thread_pool.h"
+#include "wal.h"
+#include <future>
+#include <shared_mutex>
 #include <unordered_set>
 
 static std::unordered_set<std::string> types{"INT", "BOOL", "FLOAT", "DOUBLE", "VARCHAR"};
 
 class DataBase {
+    friend class PreparedStatement;
 private:
+    // Held for one statement. Readers only need the catalog: they work on snapshots of the tables.
+    struct Locks {
+        std::shared_lock<std::shared_mutex> catalog;
+        std::unique_lock<std::shared_mutex> exclusive_catalog;
+        std::unique_lock<std::shared_mutex> writer;
+    };
+
+    mutable std::shared_mutex catalog_mutex_;
+    std::mutex checkpoint_mutex_;
     std::string name_;
     std::unordered_map<std::string, Table> tables_;
     std::vector<Connection> connections_;
+    size_t schema_version_ = 0;
+    std::unique_ptr<WriteAheadLog> log_;
+    std::string directory_;
+    uint64_t checkpoint_generation_ = 0;
+    std::unordered_map<std::string, std::pair<size_t, std::string>> checkpoint_files_;
+    std::future<void> checkpoint_;
+    std::mutex collector_mutex_;
+    std::future<void> collector_;
+    std::unique_ptr<ThreadPool> pool_ = std::make_unique<ThreadPool>(HardwareParallelism() - 1);
 
-    void Select(const std::unordered_set<std::string>& columns, const std::string& table_name);
+    Table& GetTable(const std::string& table_name);
 
-    void SelectWithWhere(const std::unordered_set<std::string>& columns, const std::string& table_name,
-                         std::string& where);
+    std::shared_ptr<Locks> LockCatalog();
 
-    void SelectWithWhereAndJoin(const std::vector<std::pair<std::string, std::string>>& columns_list,
-                                     const std::string& left_table, const std::string& right_table,
-                                     const std::string& general_column,
-                                     std::string& where_conditional, const std::string& type);
+    std::shared_ptr<Locks> LockTables(const std::vector<std::string>& tables, bool write);
 
-    void SelectWithJoin(const std::vector<std::pair<std::string, std::string>>& columns_list,
-                             const std::string& left_table, const std::string& right_table,
-                             const std::string& general_column, const std::string& type);
+    std::shared_ptr<Locks> Lock(const Statement& statement);
 
-    void Delete(const std::string& table_name);
+    void WaitForCheckpointLocked();
+
+    // Starts a background collection once a quarter of the versions in `table` are garbage.
+    void NotifyCollector(const Table& table);
+
+    void Collect(bool force);
+
+    void Log(const std::string& request, const std::vector<Parameter>& parameters);
+
+    void LogRows(const std::string& table_name, size_t begin, size_t end);
+
+    void Apply(std::string_view record);
+
+    // Replaces the catalog with the one in `snapshot`, which is logged as a whole so that replay does
+    // not depend on the file it came from.
+    void LoadSnapshot(std::string_view snapshot);
+
+    void StartLog(const std::string& path, WalOptions options, uint64_t from);
+
+    Plan MakePlan(const Statement& statement);
+
+    InsertPlan PlanInsert(const InsertStatement& statement);
+
+    SelectPlan PlanSelect(const SelectStatement& statement);
+
+    UpdatePlan PlanUpdate(const UpdateStatement& statement);
+
+    DeletePlan PlanDelete(const DeleteStatement& statement);
+
+    ResultSet Execute(Plan& plan, const std::vector<Parameter>& parameters);
+
+    // Executes `plan` and logs `request` with `parameters` so that a change is never visible or kept
+    // without its record.
+    ResultSet ExecuteLogged(Plan& plan, const std::string& request, const std::vector<Parameter>& parameters);
+
+    void ExecuteCreateTable(const CreateTableStatement& statement);
+
+    void ExecuteDropTable(const DropTableStatement& statement);
+
+    void ExecuteCreateIndex(const CreateIndexStatement& statement);
+
+    void ExecuteDropIndex(const DropIndexStatement& statement);
+
+    void ExecuteInsert(const InsertPlan& plan, const std::vector<Parameter>& parameters);
+
+    void ExecuteCopy(const CopyStatement& statement);
+
+    ResultSet ExecuteSelect(SelectPlan plan, const std::vector<Parameter>& parameters);
+
+    void ExecuteUpdate(UpdatePlan& plan, const std::vector<Parameter>& parameters);
+
+    void ExecuteDelete(DeletePlan& plan, const std::vector<Parameter>& parameters);
 
-    void DeleteWithWhere(const std::string& table_name, std::string& where_condition);
+    ResultSet Select(const std::shared_ptr<SelectPlan>& plan);
 
-    void UpdateWithWhere(const std::string& table_name, const std::string& new_values, std::string& where_condition);
+    ResultSet SelectWithWhere(const std::shared_ptr<SelectPlan>& plan);
 
-    void Update(const std::string& table_name, const std::string& new_values);
+    ResultSet SelectWithWhereAndJoin(const std::shared_ptr<SelectPlan>& plan);
 
-    std::pair<std::string, Parameter> SetValue(const std::string& table_name, const std::string& input);
+    ResultSet SelectWithJoin(const std::shared_ptr<SelectPlan>& plan);
 
-    static bool JoinPredicate(Element& first_element, const std::string& first_column, Element& second_element,
-                       const std::string& sign);
+    void Delete(const std::string& table_name);
+
+    void DeleteWithWhere(DeletePlan& plan);
+
+    void UpdateWithWhere(UpdatePlan& plan, const std::vector<Parameter>& parameters);
+
+    void Update(const UpdatePlan& plan, const std::vector<Parameter>& parameters);
+
+    std::pair<size_t, Literal> SetValue(const std::string& table_name, const Assignment& assignment);
 
 public:
 
@@ -45,7 +123,14 @@ public:
 
     explicit DataBase(const std::string& name) : name_(name) {}
 
-    [[nodiscard]] size_t Size() const noexcept {
+    DataBase(const DataBase&) = delete;
+
+    DataBase& operator=(const DataBase&) = delete;
+
+    ~DataBase();
+
+    [[nodiscard]] size_t Size() const {
+        std::shared_lock lock(catalog_mutex_);
         return tables_.size();
     }
 
@@ -53,16 +138,59 @@ public:
 
     void DropTable(const std::string& request);
 
+    void CreateIndex(const std::string& request);
+
+    void DropIndex(const std::string& request);
+
     void Insert(const std::string& request);
 
-    void SelectRequest(const std::string& request);
+    void BulkInsert(const std::string& table_name, std::vector<std::vector<Parameter>> rows);
+
+    void Copy(const std::string& request);
+
+    void Save(const std::string& path) const;
+
+    void Load(const std::string& path);
+
+    // Replays the log at `path` and then appends every later change to it.
+    void OpenLog(const std::string& path, WalOptions options = {});
+
+    void CloseLog();
+
+    // Loads the latest checkpoint in `directory`, replays the log after it and keeps logging there.
+    void Open(const std::string& directory, WalOptions options = {});
+
+    // Writes the tables changed since the previous checkpoint on a background thread and drops the
+    // log records they cover once the checkpoint is durable.
+    void Checkpoint();
+
+    // Waits for the running checkpoint and rethrows its error.
+    void WaitForCheckpoint();
+
+    // Drops every row version that no new snapshot can see; the background collector does the same
+    // for tables with enough garbage. Results opened earlier keep the versions they read.
+    void CollectGarbage();
+
+    // Scans and filters of large tables run on `parallelism` threads, the calling one included; the
+    // default is one per hardware thread.
+    void SetParallelism(size_t parallelism);
+
+    [[nodiscard]] size_t Parallelism() const {
+        std::shared_lock lock(catalog_mutex_);
+        return pool_->Size() + 1;
+    }
+
+    ResultSet SelectRequest(const std::string& request);
 
     void DeleteRequest(const std::string& request);
 
     void UpdateRequest(const std::string& request);
 
+    PreparedStatement Prepare(const std::string& request);
+
+    // Direct access to the storage, without any locking.
     std::unordered_map<std::string, Table>& GetTables() {
         return tables_;
     }
 
-};
\ No newline at end of file
+};
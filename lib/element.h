@@ -1,52 +1,41 @@
+#pragma once
+
 #include <iostream>
 #include <vector>
-#include <unordered_map>
 
-#include "parameter.h"
+#include "schema.h"
 
 class Element {
 public:
-    using Row = std::unordered_map<std::string, Parameter>;
+    using Row = std::vector<Parameter>;
 private:
-    std::string primary_parameter_;
+    const Schema* schema_ = nullptr;
     Row parameters_;
-    std::unordered_map<std::string, TYPE> parameter_list_;
-    std::vector<std::string> order_;
 public:
     Element() = default;
 
-    Element(const std::string& primary_parameter, const Row& parameters) :primary_parameter_(primary_parameter),
-                                                                       parameters_(parameters) {}
+    explicit Element(const Schema& schema) : schema_(&schema), parameters_(schema.Size()) {}
 
-    explicit Element(const Row& parameters) : parameters_(parameters) {}
+    Element(const Schema& schema, Row&& parameters) : schema_(&schema), parameters_(std::move(parameters)) {}
 
-    void SetKeyParameter(const std::string& primary_key) {
-        primary_parameter_ = primary_key;
+    Parameter& operator[](size_t ordinal) {
+        return parameters_[ordinal];
     }
 
-    Parameter& operator[] (const std::string& key) {
-        return parameters_[key];
+    const Parameter& operator[](size_t ordinal) const {
+        return parameters_[ordinal];
     }
 
-    std::unordered_map<std::string, TYPE>& GetParameterList() {
-        return parameter_list_;
+    Parameter& operator[](const std::string& key) {
+        return parameters_[schema_->Ordinal(key)];
     }
 
     Row& GetParameters() {
         return parameters_;
     }
 
-    TYPE GetCurrentParameter(const std::string& name) {
-        for (const auto& i : parameter_list_) {
-            if (i.first == name) {
-                return i.second;
-            }
-        }
-        return TYPE::NONE;
-    }
-
-    std::vector<std::string>& GetOrder() {
-        return order_;
+    const Schema& GetSchema() const {
+        return *schema_;
     }
 
 };
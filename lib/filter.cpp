@@ -0,0 +1,371 @@
+#include "filter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define FILTER_X86
+#endif
+
+namespace {
+
+template<CompareOperator sign, typename T>
+bool Matches(T left, T right) {
+    if constexpr (sign == CompareOperator::EQUAL) {
+        return left == right;
+    } else if constexpr (sign == CompareOperator::NOT_EQUAL) {
+        return left != right;
+    } else if constexpr (sign == CompareOperator::LESS) {
+        return left < right;
+    } else if constexpr (sign == CompareOperator::GREATER) {
+        return left > right;
+    } else if constexpr (sign == CompareOperator::LESS_EQUAL) {
+        return left <= right;
+    } else {
+        return left >= right;
+    }
+}
+
+// A constant operand, read like a column whose rows all hold it.
+template<typename T>
+struct Repeat {
+    T value;
+
+    T operator[](size_t) const {
+        return value;
+    }
+};
+
+// Rows [begin, count) one at a time; `begin` is a multiple of 64.
+template<CompareOperator sign, typename T, typename Right>
+void ScalarKernel(const T* left, Right right, size_t begin, size_t count, uint64_t* bits) {
+    for (size_t i = begin; i < count; i += 64) {
+        size_t rows = std::min<size_t>(64, count - i);
+        uint64_t word = 0;
+        for (size_t j = 0; j < rows; ++j) {
+            word |= uint64_t(Matches<sign>(left[i + j], right[i + j])) << j;
+        }
+        bits[i / 64] = word;
+    }
+}
+
+#ifdef FILTER_X86
+
+// Integers only compare for equal and greater, so the other signs negate or swap those. The floating
+// point signs are ordered except NOT_EQUAL, which holds for NaN as it does in C++.
+struct Sse2 {
+    static __m128i Load(const int* values) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+    }
+
+    static __m128 Load(const float* values) {
+        return _mm_loadu_ps(values);
+    }
+
+    static __m128d Load(const double* values) {
+        return _mm_loadu_pd(values);
+    }
+
+    static __m128i Load(Repeat<int> constant) {
+        return _mm_set1_epi32(constant.value);
+    }
+
+    static __m128 Load(Repeat<float> constant) {
+        return _mm_set1_ps(constant.value);
+    }
+
+    static __m128d Load(Repeat<double> constant) {
+        return _mm_set1_pd(constant.value);
+    }
+
+    template<CompareOperator sign>
+    static int Mask(__m128i left, __m128i right) {
+        auto mask = [](__m128i result) {
+            return _mm_movemask_ps(_mm_castsi128_ps(result));
+        };
+        if constexpr (sign == CompareOperator::EQUAL) {
+            return mask(_mm_cmpeq_epi32(left, right));
+        } else if constexpr (sign == CompareOperator::NOT_EQUAL) {
+            return mask(_mm_cmpeq_epi32(left, right)) ^ 0xF;
+        } else if constexpr (sign == CompareOperator::LESS) {
+            return mask(_mm_cmpgt_epi32(right, left));
+        } else if constexpr (sign == CompareOperator::GREATER) {
+            return mask(_mm_cmpgt_epi32(left, right));
+        } else if constexpr (sign == CompareOperator::LESS_EQUAL) {
+            return mask(_mm_cmpgt_epi32(left, right)) ^ 0xF;
+        } else {
+            return mask(_mm_cmpgt_epi32(right, left)) ^ 0xF;
+        }
+    }
+
+    template<CompareOperator sign>
+    static int Mask(__m128 left, __m128 right) {
+        if constexpr (sign == CompareOperator::EQUAL) {
+            return _mm_movemask_ps(_mm_cmpeq_ps(left, right));
+        } else if constexpr (sign == CompareOperator::NOT_EQUAL) {
+            return _mm_movemask_ps(_mm_cmpneq_ps(left, right));
+        } else if constexpr (sign == CompareOperator::LESS) {
+            return _mm_movemask_ps(_mm_cmplt_ps(left, right));
+        } else if constexpr (sign == CompareOperator::GREATER) {
+            return _mm_movemask_ps(_mm_cmpgt_ps(left, right));
+        } else if constexpr (sign == CompareOperator::LESS_EQUAL) {
+            return _mm_movemask_ps(_mm_cmple_ps(left, right));
+        } else {
+            return _mm_movemask_ps(_mm_cmpge_ps(left, right));
+        }
+    }
+
+    template<CompareOperator sign>
+    static int Mask(__m128d left, __m128d right) {
+        if constexpr (sign == CompareOperator::EQUAL) {
+            return _mm_movemask_pd(_mm_cmpeq_pd(left, right));
+        } else if constexpr (sign == CompareOperator::NOT_EQUAL) {
+            return _mm_movemask_pd(_mm_cmpneq_pd(left, right));
+        } else if constexpr (sign == CompareOperator::LESS) {
+            return _mm_movemask_pd(_mm_cmplt_pd(left, right));
+        } else if constexpr (sign == CompareOperator::GREATER) {
+            return _mm_movemask_pd(_mm_cmpgt_pd(left, right));
+        } else if constexpr (sign == CompareOperator::LESS_EQUAL) {
+            return _mm_movemask_pd(_mm_cmple_pd(left, right));
+        } else {
+            return _mm_movemask_pd(_mm_cmpge_pd(left, right));
+        }
+    }
+};
+
+template<CompareOperator sign, typename T, typename Right>
+void Sse2Kernel(const T* left, Right right, size_t count, uint64_t* bits) {
+    constexpr size_t lanes = 16 / sizeof(T);
+    size_t blocks = count / 64 * 64;
+    for (size_t i = 0; i < blocks; i += 64) {
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; j += lanes) {
+            if constexpr (std::is_pointer_v<Right>) {
+                word |= uint64_t(Sse2::Mask<sign>(Sse2::Load(left + i + j), Sse2::Load(right + i + j))) << j;
+            } else {
+                word |= uint64_t(Sse2::Mask<sign>(Sse2::Load(left + i + j), Sse2::Load(right))) << j;
+            }
+        }
+        bits[i / 64] = word;
+    }
+    ScalarKernel<sign>(left, right, blocks, count, bits);
+}
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+struct Avx2 {
+    AVX2_TARGET static __m256i Load(const int* values) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values));
+    }
+
+    AVX2_TARGET static __m256 Load(const float* values) {
+        return _mm256_loadu_ps(values);
+    }
+
+    AVX2_TARGET static __m256d Load(const double* values) {
+        return _mm256_loadu_pd(values);
+    }
+
+    AVX2_TARGET static __m256i Load(Repeat<int> constant) {
+        return _mm256_set1_epi32(constant.value);
+    }
+
+    AVX2_TARGET static __m256 Load(Repeat<float> constant) {
+        return _mm256_set1_ps(constant.value);
+    }
+
+    AVX2_TARGET static __m256d Load(Repeat<double> constant) {
+        return _mm256_set1_pd(constant.value);
+    }
+
+    AVX2_TARGET static int Mask(__m256i result) {
+        return _mm256_movemask_ps(_mm256_castsi256_ps(result));
+    }
+
+    template<CompareOperator sign>
+    AVX2_TARGET static int Mask(__m256i left, __m256i right) {
+        if constexpr (sign == CompareOperator::EQUAL) {
+            return Mask(_mm256_cmpeq_epi32(left, right));
+        } else if constexpr (sign == CompareOperator::NOT_EQUAL) {
+            return Mask(_mm256_cmpeq_epi32(left, right)) ^ 0xFF;
+        } else if constexpr (sign == CompareOperator::LESS) {
+            return Mask(_mm256_cmpgt_epi32(right, left));
+        } else if constexpr (sign == CompareOperator::GREATER) {
+            return Mask(_mm256_cmpgt_epi32(left, right));
+        } else if constexpr (sign == CompareOperator::LESS_EQUAL) {
+            return Mask(_mm256_cmpgt_epi32(left, right)) ^ 0xFF;
+        } else {
+            return Mask(_mm256_cmpgt_epi32(right, left)) ^ 0xFF;
+        }
+    }
+
+    template<CompareOperator sign>
+    AVX2_TARGET static int Mask(__m256 left, __m256 right) {
+        if constexpr (sign == CompareOperator::EQUAL) {
+            return _mm256_movemask_ps(_mm256_cmp_ps(left, right, _CMP_EQ_OQ));
+        } else if constexpr (sign == CompareOperator::NOT_EQUAL) {
+            return _mm256_movemask_ps(_mm256_cmp_ps(left, right, _CMP_NEQ_UQ));
+        } else if constexpr (sign == CompareOperator::LESS) {
+            return _mm256_movemask_ps(_mm256_cmp_ps(left, right, _CMP_LT_OQ));
+        } else if constexpr (sign == CompareOperator::GREATER) {
+            return _mm256_movemask_ps(_mm256_cmp_ps(left, right, _CMP_GT_OQ));
+        } else if constexpr (sign == CompareOperator::LESS_EQUAL) {
+            return _mm256_movemask_ps(_mm256_cmp_ps(left, right, _CMP_LE_OQ));
+        } else {
+            return _mm256_movemask_ps(_mm256_cmp_ps(left, right, _CMP_GE_OQ));
+        }
+    }
+
+    template<CompareOperator sign>
+    AVX2_TARGET static int Mask(__m256d left, __m256d right) {
+        if constexpr (sign == CompareOperator::EQUAL) {
+            return _mm256_movemask_pd(_mm256_cmp_pd(left, right, _CMP_EQ_OQ));
+        } else if constexpr (sign == CompareOperator::NOT_EQUAL) {
+            return _mm256_movemask_pd(_mm256_cmp_pd(left, right, _CMP_NEQ_UQ));
+        } else if constexpr (sign == CompareOperator::LESS) {
+            return _mm256_movemask_pd(_mm256_cmp_pd(left, right, _CMP_LT_OQ));
+        } else if constexpr (sign == CompareOperator::GREATER) {
+            return _mm256_movemask_pd(_mm256_cmp_pd(left, right, _CMP_GT_OQ));
+        } else if constexpr (sign == CompareOperator::LESS_EQUAL) {
+            return _mm256_movemask_pd(_mm256_cmp_pd(left, right, _CMP_LE_OQ));
+        } else {
+            return _mm256_movemask_pd(_mm256_cmp_pd(left, right, _CMP_GE_OQ));
+        }
+    }
+};
+
+template<CompareOperator sign, typename T, typename Right>
+AVX2_TARGET void Avx2Kernel(const T* left, Right right, size_t count, uint64_t* bits) {
+    constexpr size_t lanes = 32 / sizeof(T);
+    size_t blocks = count / 64 * 64;
+    for (size_t i = 0; i < blocks; i += 64) {
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; j += lanes) {
+            if constexpr (std::is_pointer_v<Right>) {
+                word |= uint64_t(Avx2::Mask<sign>(Avx2::Load(left + i + j), Avx2::Load(right + i + j))) << j;
+            } else {
+                word |= uint64_t(Avx2::Mask<sign>(Avx2::Load(left + i + j), Avx2::Load(right))) << j;
+            }
+        }
+        bits[i / 64] = word;
+    }
+    ScalarKernel<sign>(left, right, blocks, count, bits);
+}
+
+#endif
+
+std::atomic<InstructionSet>& Current() {
+    static std::atomic<InstructionSet> current = BestInstructionSet();
+    return current;
+}
+
+template<CompareOperator sign, typename T, typename Right>
+void Run(const T* left, Right right, size_t count, uint64_t* bits) {
+    switch (Current().load(std::memory_order_relaxed)) {
+#ifdef FILTER_X86
+        case InstructionSet::AVX2:
+            Avx2Kernel<sign>(left, right, count, bits);
+            return;
+        case InstructionSet::SSE2:
+            Sse2Kernel<sign>(left, right, count, bits);
+            return;
+#endif
+        default:
+            ScalarKernel<sign>(left, right, 0, count, bits);
+    }
+}
+
+template<typename T, typename Right>
+void Dispatch(const T* left, Right right, size_t count, CompareOperator sign, uint64_t* bits) {
+    switch (sign) {
+        case CompareOperator::EQUAL:
+            return Run<CompareOperator::EQUAL>(left, right, count, bits);
+        case CompareOperator::NOT_EQUAL:
+            return Run<CompareOperator::NOT_EQUAL>(left, right, count, bits);
+        case CompareOperator::LESS:
+            return Run<CompareOperator::LESS>(left, right, count, bits);
+        case CompareOperator::GREATER:
+            return Run<CompareOperator::GREATER>(left, right, count, bits);
+        case CompareOperator::LESS_EQUAL:
+            return Run<CompareOperator::LESS_EQUAL>(left, right, count, bits);
+        case CompareOperator::GREATER_EQUAL:
+            return Run<CompareOperator::GREATER_EQUAL>(left, right, count, bits);
+    }
+}
+
+}
+
+InstructionSet BestInstructionSet() {
+#ifdef FILTER_X86
+    static const InstructionSet best = []() {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") ? InstructionSet::AVX2 : InstructionSet::SSE2;
+    }();
+    return best;
+#else
+    return InstructionSet::SCALAR;
+#endif
+}
+
+InstructionSet CurrentInstructionSet() {
+    return Current().load(std::memory_order_relaxed);
+}
+
+void UseInstructionSet(InstructionSet set) {
+    Current().store(std::min(set, BestInstructionSet()), std::memory_order_relaxed);
+}
+
+const char* InstructionSetName(InstructionSet set) {
+    switch (set) {
+        case InstructionSet::SSE2:
+            return "SSE2";
+        case InstructionSet::AVX2:
+            return "AVX2";
+        default:
+            return "scalar";
+    }
+}
+
+void CompareToConstant(const int* values, size_t count, CompareOperator sign, int constant, uint64_t* bits) {
+    Dispatch(values, Repeat<int>{constant}, count, sign, bits);
+}
+
+void CompareToConstant(const float* values, size_t count, CompareOperator sign, float constant, uint64_t* bits) {
+    Dispatch(values, Repeat<float>{constant}, count, sign, bits);
+}
+
+void CompareToConstant(const double* values, size_t count, CompareOperator sign, double constant, uint64_t* bits) {
+    Dispatch(values, Repeat<double>{constant}, count, sign, bits);
+}
+
+void CompareColumns(const int* left, const int* right, size_t count, CompareOperator sign, uint64_t* bits) {
+    Dispatch(left, right, count, sign, bits);
+}
+
+void CompareColumns(const float* left, const float* right, size_t count, CompareOperator sign, uint64_t* bits) {
+    Dispatch(left, right, count, sign, bits);
+}
+
+void CompareColumns(const double* left, const double* right, size_t count, CompareOperator sign, uint64_t* bits) {
+    Dispatch(left, right, count, sign, bits);
+}
+
+uint64_t CompareBits(uint64_t left, CompareOperator sign, uint64_t right) {
+    switch (sign) {
+        case CompareOperator::EQUAL:
+            return ~(left ^ right);
+        case CompareOperator::NOT_EQUAL:
+            return left ^ right;
+        case CompareOperator::LESS:
+            return ~left & right;
+        case CompareOperator::GREATER:
+            return left & ~right;
+        case CompareOperator::LESS_EQUAL:
+            return ~left | right;
+        case CompareOperator::GREATER_EQUAL:
+            return left | ~right;
+    }
+    return 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Parser.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Comparison kernels that fill selection bitmaps: bit i % 64 of word i / 64 is set when row i matches.
+// Rows [0, count) are compared and the bits of the last word past `count` are cleared.
+
+enum class InstructionSet {
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+// The widest instruction set this processor supports; kernels use it unless told otherwise.
+[[nodiscard]] InstructionSet BestInstructionSet();
+
+[[nodiscard]] InstructionSet CurrentInstructionSet();
+
+// Kernels run on `set` from now on, or on the best supported one when the processor lacks `set`.
+void UseInstructionSet(InstructionSet set);
+
+[[nodiscard]] const char* InstructionSetName(InstructionSet set);
+
+void CompareToConstant(const int* values, size_t count, CompareOperator sign, int constant, uint64_t* bits);
+
+void CompareToConstant(const float* values, size_t count, CompareOperator sign, float constant, uint64_t* bits);
+
+void CompareToConstant(const double* values, size_t count, CompareOperator sign, double constant, uint64_t* bits);
+
+void CompareColumns(const int* left, const int* right, size_t count, CompareOperator sign, uint64_t* bits);
+
+void CompareColumns(const float* left, const float* right, size_t count, CompareOperator sign, uint64_t* bits);
+
+void CompareColumns(const double* left, const double* right, size_t count, CompareOperator sign, uint64_t* bits);
+
+// Compares 64 bools packed into words; a constant is a word with every bit equal to it.
+[[nodiscard]] uint64_t CompareBits(uint64_t left, CompareOperator sign, uint64_t right);
@@ -0,0 +1,177 @@
+#include "formatter.h"
+
+void Formatter::AppendText(const ResultSet& result, size_t column, bool round_trip) {
+    constexpr int kPrecision = 6;
+    switch (result.GetColumns()[column].type) {
+        case TYPE::INT:
+            buffer_.AppendNumber(result.Get<int>(column));
+            break;
+        case TYPE::FLOAT:
+            if (round_trip) {
+                buffer_.AppendNumber(result.Get<float>(column));
+            } else {
+                buffer_.AppendNumber(result.Get<float>(column), kPrecision);
+            }
+            break;
+        case TYPE::DOUBLE:
+            if (round_trip) {
+                buffer_.AppendNumber(result.Get<double>(column));
+            } else {
+                buffer_.AppendNumber(result.Get<double>(column), kPrecision);
+            }
+            break;
+        case TYPE::BOOL:
+            buffer_.Append(result.Get<bool>(column) ? '1' : '0');
+            break;
+        case TYPE::STRING:
+            buffer_.Append(result.Get<std::string_view>(column));
+            break;
+        default:
+            break;
+    }
+}
+
+void TextFormatter::Row(const ResultSet& result) {
+    for (size_t i = 0; i < result.GetColumns().size(); ++i) {
+        if (result.IsNull(i)) {
+            buffer_.Append("NULL");
+        } else {
+            AppendText(result, i, false);
+        }
+        buffer_.Append(' ');
+    }
+    buffer_.Append('\n');
+}
+
+namespace {
+
+void AppendCsvField(OutputBuffer& buffer, std::string_view value) {
+    if (!value.empty() && value.find_first_of(",\"\r\n") == std::string_view::npos) {
+        buffer.Append(value);
+        return;
+    }
+    buffer.Append('"');
+    for (char i: value) {
+        if (i == '"') {
+            buffer.Append('"');
+        }
+        buffer.Append(i);
+    }
+    buffer.Append('"');
+}
+
+}
+
+void CsvFormatter::Header(const std::vector<ResultSet::ColumnInfo>& columns) {
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (i != 0) {
+            buffer_.Append(',');
+        }
+        AppendCsvField(buffer_, columns[i].name);
+    }
+    buffer_.Append('\n');
+}
+
+void CsvFormatter::Row(const ResultSet& result) {
+    for (size_t i = 0; i < result.GetColumns().size(); ++i) {
+        if (i != 0) {
+            buffer_.Append(',');
+        }
+        if (result.IsNull(i)) {
+            continue;
+        }
+        TYPE type = result.GetColumns()[i].type;
+        if (type == TYPE::STRING) {
+            AppendCsvField(buffer_, result.Get<std::string_view>(i));
+        } else if (type == TYPE::BOOL) {
+            buffer_.Append(result.Get<bool>(i) ? "true" : "false");
+        } else {
+            AppendText(result, i, true);
+        }
+    }
+    buffer_.Append('\n');
+}
+
+void BinaryFormatter::Header(const std::vector<ResultSet::ColumnInfo>& columns) {
+    auto count = static_cast<uint32_t>(columns.size());
+    buffer_.AppendBytes(&count, sizeof(count));
+    for (const auto& i: columns) {
+        buffer_.Append(static_cast<char>(i.type));
+        auto length = static_cast<uint32_t>(i.name.size());
+        buffer_.AppendBytes(&length, sizeof(length));
+        buffer_.Append(i.name);
+    }
+}
+
+void BinaryFormatter::Row(const ResultSet& result) {
+    size_t count = result.GetColumns().size();
+    buffer_.Append('\1');
+    for (size_t i = 0; i < count; i += 8) {
+        uint8_t nulls = 0;
+        for (size_t j = i; j < count && j < i + 8; ++j) {
+            if (result.IsNull(j)) {
+                nulls |= static_cast<uint8_t>(1 << (j - i));
+            }
+        }
+        buffer_.Append(static_cast<char>(nulls));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (result.IsNull(i)) {
+            continue;
+        }
+        switch (result.GetColumns()[i].type) {
+            case TYPE::INT: {
+                int value = result.Get<int>(i);
+                buffer_.AppendBytes(&value, sizeof(value));
+                break;
+            }
+            case TYPE::FLOAT: {
+                float value = result.Get<float>(i);
+                buffer_.AppendBytes(&value, sizeof(value));
+                break;
+            }
+            case TYPE::DOUBLE: {
+                double value = result.Get<double>(i);
+                buffer_.AppendBytes(&value, sizeof(value));
+                break;
+            }
+            case TYPE::BOOL:
+                buffer_.Append(result.Get<bool>(i) ? '\1' : '\0');
+                break;
+            case TYPE::STRING: {
+                std::string_view value = result.Get<std::string_view>(i);
+                auto length = static_cast<uint32_t>(value.size());
+                buffer_.AppendBytes(&length, sizeof(length));
+                buffer_.Append(value);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+}
+
+void BinaryFormatter::Footer() {
+    buffer_.Append('\0');
+}
+
+std::unique_ptr<Formatter> MakeFormatter(Format format, OutputBuffer& buffer) {
+    switch (format) {
+        case Format::CSV:
+            return std::make_unique<CsvFormatter>(buffer);
+        case Format::BINARY:
+            return std::make_unique<BinaryFormatter>(buffer);
+        default:
+            return std::make_unique<TextFormatter>(buffer);
+    }
+}
+
+void Write(ResultSet& result, std::ostream& output, Format format, size_t capacity) {
+    OutputBuffer buffer(output, capacity);
+    auto formatter = MakeFormatter(format, buffer);
+    formatter->Header(result.GetColumns());
+    while (result.Next()) {
+        formatter->Row(result);
+    }
+    formatter->Footer();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "output_buffer.h"
+#include "result.h"
+
+enum class Format {
+    TEXT,
+    CSV,
+    BINARY
+};
+
+class Formatter {
+protected:
+    OutputBuffer& buffer_;
+
+    void AppendText(const ResultSet& result, size_t column, bool round_trip);
+
+public:
+    explicit Formatter(OutputBuffer& buffer) : buffer_(buffer) {}
+
+    virtual ~Formatter() = default;
+
+    virtual void Header(const std::vector<ResultSet::ColumnInfo>&) {}
+
+    virtual void Row(const ResultSet& result) = 0;
+
+    virtual void Footer() {}
+};
+
+class TextFormatter : public Formatter {
+public:
+    using Formatter::Formatter;
+
+    void Row(const ResultSet& result) override;
+};
+
+class CsvFormatter : public Formatter {
+public:
+    using Formatter::Formatter;
+
+    void Header(const std::vector<ResultSet::ColumnInfo>& columns) override;
+
+    void Row(const ResultSet& result) override;
+};
+
+// Header: column count, then a type byte and a length-prefixed name per column. Every row starts with
+// a 1 byte followed by a null bitmap and the non-null values in native byte order; a 0 byte ends the stream.
+class BinaryFormatter : public Formatter {
+public:
+    using Formatter::Formatter;
+
+    void Header(const std::vector<ResultSet::ColumnInfo>& columns) override;
+
+    void Row(const ResultSet& result) override;
+
+    void Footer() override;
+};
+
+std::unique_ptr<Formatter> MakeFormatter(Format format, OutputBuffer& buffer);
+
+void Write(ResultSet& result, std::ostream& output, Format format = Format::TEXT, size_t capacity = 1 << 16);
@@ -0,0 +1,71 @@
+#include "join.h"
+
+bool NestedLoopJoin::Next(size_t& left, size_t& right) {
+    bool outer_left = type_ != JoinType::RIGHT;
+    const TableSnapshot& outer = outer_left ? left_rows_ : right_rows_;
+    const TableSnapshot& inner = outer_left ? right_rows_ : left_rows_;
+    while (outer_ < outer.Size()) {
+        if (!outer.Visible(outer_)) {
+            ++outer_;
+            continue;
+        }
+        while (inner_ < inner.Size()) {
+            size_t row = inner_++;
+            if (!inner.Visible(row)) {
+                continue;
+            }
+            left = outer_left ? outer_ : row;
+            right = outer_left ? row : outer_;
+            if (Compare(left_, left, sign_, right_, right)) {
+                find_flag_ = true;
+                return true;
+            }
+        }
+        size_t row = outer_++;
+        bool find_flag = find_flag_;
+        inner_ = 0;
+        find_flag_ = false;
+        if (!find_flag && type_ != JoinType::INNER) {
+            left = outer_left ? row : Column::kNullRow;
+            right = outer_left ? Column::kNullRow : row;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::unique_ptr<JoinCursor> MakeHashJoin(const TableSnapshot& left, size_t left_column, const TableSnapshot& right,
+                                         size_t right_column, JoinType type) {
+    switch (left.GetColumn(left_column).Type()) {
+        case TYPE::INT:
+            return std::make_unique<HashJoin<int>>(left, left_column, right, right_column, type);
+        case TYPE::FLOAT:
+            return std::make_unique<HashJoin<float>>(left, left_column, right, right_column, type);
+        case TYPE::DOUBLE:
+            return std::make_unique<HashJoin<double>>(left, left_column, right, right_column, type);
+        case TYPE::BOOL:
+            return std::make_unique<HashJoin<bool>>(left, left_column, right, right_column, type);
+        case TYPE::STRING:
+            return std::make_unique<HashJoin<std::string_view>>(left, left_column, right, right_column, type);
+        default:
+            return std::make_unique<NestedLoopJoin>(left, left_column, right, right_column, CompareOperator::EQUAL, type);
+    }
+}
+
+std::unique_ptr<JoinCursor> MakeMergeJoin(const TableSnapshot& left, size_t left_column, const TableSnapshot& right,
+                                          size_t right_column, CompareOperator sign, JoinType type) {
+    switch (left.GetColumn(left_column).Type()) {
+        case TYPE::INT:
+            return std::make_unique<MergeJoin<int>>(left, left_column, right, right_column, sign, type);
+        case TYPE::FLOAT:
+            return std::make_unique<MergeJoin<float>>(left, left_column, right, right_column, sign, type);
+        case TYPE::DOUBLE:
+            return std::make_unique<MergeJoin<double>>(left, left_column, right, right_column, sign, type);
+        case TYPE::BOOL:
+            return std::make_unique<MergeJoin<bool>>(left, left_column, right, right_column, sign, type);
+        case TYPE::STRING:
+            return std::make_unique<MergeJoin<std::string_view>>(left, left_column, right, right_column, sign, type);
+        default:
+            return std::make_unique<NestedLoopJoin>(left, left_column, right, right_column, sign, type);
+    }
+}
@@ -0,0 +1,271 @@
+#pragma once
+
+#include "predicate.h"
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+
+class JoinCursor {
+public:
+    virtual ~JoinCursor() = default;
+
+    virtual bool Next(size_t& left, size_t& right) = 0;
+};
+
+// Join inputs are snapshots and produce only the rows visible in them.
+class NestedLoopJoin : public JoinCursor {
+private:
+    TableSnapshot left_rows_;
+    TableSnapshot right_rows_;
+    const Column& left_;
+    const Column& right_;
+    CompareOperator sign_;
+    JoinType type_;
+    size_t outer_ = 0;
+    size_t inner_ = 0;
+    bool find_flag_ = false;
+public:
+    NestedLoopJoin(TableSnapshot left, size_t left_column, TableSnapshot right, size_t right_column,
+                   CompareOperator sign, JoinType type) :
+            left_rows_(std::move(left)), right_rows_(std::move(right)), left_(left_rows_.GetColumn(left_column)),
+            right_(right_rows_.GetColumn(right_column)), sign_(sign), type_(type) {}
+
+    bool Next(size_t& left, size_t& right) override;
+};
+
+template<typename T>
+class HashJoin : public JoinCursor {
+private:
+    bool build_left_;
+    TableSnapshot build_rows_;
+    TableSnapshot probe_rows_;
+    const Column& build_;
+    const Column& probe_;
+    bool preserve_probe_;
+    // Rows sharing a key are chained through next_ in ascending order.
+    std::unordered_map<T, size_t> head_;
+    // Strings are joined on dictionary codes: the heads are indexed by build code and every probe
+    // entry is translated to a build code once.
+    std::vector<size_t> code_head_;
+    std::vector<uint32_t> translation_;
+    std::vector<size_t> next_;
+    std::vector<bool> matched_;
+    size_t position_ = 0;
+    size_t current_ = 0;
+    size_t chain_ = Column::kNullRow;
+    size_t unmatched_ = 0;
+
+    bool Pair(size_t build_row, size_t probe_row, size_t& left, size_t& right) const {
+        left = build_left_ ? build_row : probe_row;
+        right = build_left_ ? probe_row : build_row;
+        return true;
+    }
+
+    // First build row with the key of `probe_row`.
+    [[nodiscard]] size_t Find(size_t probe_row) const {
+        if constexpr (std::is_same_v<T, std::string_view>) {
+            uint32_t code = translation_[probe_.Code(probe_row)];
+            return code == Column::kNoCode ? Column::kNullRow : code_head_[code];
+        } else {
+            auto position = head_.find(probe_.Value<T>(probe_row));
+            return position == head_.end() ? Column::kNullRow : position->second;
+        }
+    }
+
+public:
+    HashJoin(const TableSnapshot& left, size_t left_column, const TableSnapshot& right, size_t right_column,
+             JoinType type) :
+            build_left_(left.Size() < right.Size()), build_rows_(build_left_ ? left : right),
+            probe_rows_(build_left_ ? right : left),
+            build_(build_rows_.GetColumn(build_left_ ? left_column : right_column)),
+            probe_(probe_rows_.GetColumn(build_left_ ? right_column : left_column)),
+            preserve_probe_((type == JoinType::LEFT && !build_left_) || (type == JoinType::RIGHT && build_left_)),
+            next_(build_rows_.Size(), Column::kNullRow) {
+        if ((type == JoinType::LEFT && build_left_) || (type == JoinType::RIGHT && !build_left_)) {
+            matched_.resize(build_rows_.Size());
+        }
+        if constexpr (std::is_same_v<T, std::string_view>) {
+            code_head_.assign(build_.Entries(), Column::kNullRow);
+            std::unordered_map<std::string_view, uint32_t> codes;
+            codes.reserve(code_head_.size());
+            for (uint32_t i = 0; i < code_head_.size(); ++i) {
+                codes.emplace(build_.Entry(i), i);
+            }
+            translation_.resize(probe_.Entries(), Column::kNoCode);
+            for (uint32_t i = 0; i < translation_.size(); ++i) {
+                auto position = codes.find(probe_.Entry(i));
+                if (position != codes.end()) {
+                    translation_[i] = position->second;
+                }
+            }
+        } else {
+            head_.reserve(build_rows_.Size());
+        }
+        for (size_t i = build_rows_.Size(); i-- > 0;) {
+            if (!build_rows_.Visible(i) || build_.IsNull(i)) {
+                continue;
+            }
+            if constexpr (std::is_same_v<T, std::string_view>) {
+                size_t& head = code_head_[build_.Code(i)];
+                next_[i] = head;
+                head = i;
+            } else {
+                auto [position, inserted] = head_.try_emplace(build_.Value<T>(i), i);
+                if (!inserted) {
+                    next_[i] = position->second;
+                    position->second = i;
+                }
+            }
+        }
+    }
+
+    bool Next(size_t& left, size_t& right) override {
+        while (true) {
+            if (chain_ != Column::kNullRow) {
+                size_t row = chain_;
+                chain_ = next_[row];
+                if (!matched_.empty()) {
+                    matched_[row] = true;
+                }
+                return Pair(row, current_, left, right);
+            }
+            if (position_ < probe_rows_.Size()) {
+                current_ = position_++;
+                if (!probe_rows_.Visible(current_)) {
+                    continue;
+                }
+                if (!probe_.IsNull(current_)) {
+                    chain_ = Find(current_);
+                    if (chain_ != Column::kNullRow) {
+                        continue;
+                    }
+                }
+                if (preserve_probe_) {
+                    return Pair(Column::kNullRow, current_, left, right);
+                }
+                continue;
+            }
+            while (unmatched_ < matched_.size()) {
+                size_t row = unmatched_++;
+                if (!matched_[row] && build_rows_.Visible(row)) {
+                    return Pair(row, Column::kNullRow, left, right);
+                }
+            }
+            return false;
+        }
+    }
+};
+
+// Both inputs are sorted once; for every outer key the matching inner rows form a prefix or a suffix
+// of the sorted inner input whose boundary only moves forward while the outer keys ascend.
+template<typename T>
+class MergeJoin : public JoinCursor {
+private:
+    bool outer_left_;
+    bool is_inner_;
+    CompareOperator sign_;
+    std::vector<std::pair<T, size_t>> outer_keys_;
+    std::vector<std::pair<T, size_t>> inner_keys_;
+    std::vector<size_t> outer_nulls_;
+    size_t position_ = 0;
+    size_t current_ = 0;
+    size_t lower_ = 0;
+    size_t upper_ = 0;
+    size_t begin_ = 0;
+    size_t end_ = 0;
+    size_t null_ = 0;
+
+    static std::vector<std::pair<T, size_t>> SortedKeys(const TableSnapshot& rows, size_t ordinal,
+                                                       std::vector<size_t>* nulls) {
+        const Column& column = rows.GetColumn(ordinal);
+        std::vector<std::pair<T, size_t>> keys;
+        keys.reserve(rows.Size());
+        for (size_t i = 0; i < rows.Size(); ++i) {
+            if (!rows.Visible(i)) {
+                continue;
+            }
+            if (!column.IsNull(i)) {
+                keys.emplace_back(column.Value<T>(i), i);
+            } else if (nulls != nullptr) {
+                nulls->push_back(i);
+            }
+        }
+        std::sort(keys.begin(), keys.end());
+        return keys;
+    }
+
+    bool Pair(size_t outer_row, size_t inner_row, size_t& left, size_t& right) const {
+        left = outer_left_ ? outer_row : inner_row;
+        right = outer_left_ ? inner_row : outer_row;
+        return true;
+    }
+
+    void Seek(const T& key) {
+        while (lower_ < inner_keys_.size() && inner_keys_[lower_].first < key) {
+            ++lower_;
+        }
+        upper_ = std::max(upper_, lower_);
+        while (upper_ < inner_keys_.size() && !(key < inner_keys_[upper_].first)) {
+            ++upper_;
+        }
+        begin_ = 0;
+        end_ = inner_keys_.size();
+        switch (sign_) {
+            case CompareOperator::LESS:
+                begin_ = upper_;
+                break;
+            case CompareOperator::LESS_EQUAL:
+                begin_ = lower_;
+                break;
+            case CompareOperator::GREATER:
+                end_ = lower_;
+                break;
+            case CompareOperator::GREATER_EQUAL:
+                end_ = upper_;
+                break;
+            default:
+                begin_ = lower_;
+                end_ = upper_;
+                break;
+        }
+    }
+
+public:
+    MergeJoin(const TableSnapshot& left, size_t left_column, const TableSnapshot& right, size_t right_column,
+              CompareOperator sign, JoinType type) :
+            outer_left_(type != JoinType::RIGHT), is_inner_(type == JoinType::INNER),
+            sign_(outer_left_ ? sign : Mirror(sign)) {
+        outer_keys_ = outer_left_ ? SortedKeys(left, left_column, &outer_nulls_) :
+                      SortedKeys(right, right_column, &outer_nulls_);
+        inner_keys_ = outer_left_ ? SortedKeys(right, right_column, nullptr) : SortedKeys(left, left_column, nullptr);
+    }
+
+    bool Next(size_t& left, size_t& right) override {
+        while (true) {
+            if (begin_ < end_) {
+                return Pair(current_, inner_keys_[begin_++].second, left, right);
+            }
+            if (position_ < outer_keys_.size()) {
+                const auto& key = outer_keys_[position_++];
+                current_ = key.second;
+                Seek(key.first);
+                if (begin_ == end_ && !is_inner_) {
+                    return Pair(current_, Column::kNullRow, left, right);
+                }
+                continue;
+            }
+            if (!is_inner_ && null_ < outer_nulls_.size()) {
+                return Pair(outer_nulls_[null_++], Column::kNullRow, left, right);
+            }
+            return false;
+        }
+    }
+};
+
+std::unique_ptr<JoinCursor> MakeHashJoin(const TableSnapshot& left, size_t left_column, const TableSnapshot& right,
+                                         size_t right_column, JoinType type);
+
+std::unique_ptr<JoinCursor> MakeMergeJoin(const TableSnapshot& left, size_t left_column, const TableSnapshot& right,
+                                          size_t right_column, CompareOperator sign, JoinType type);
@@ -0,0 +1,62 @@
+#include "mapped_file.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fstream>
+#include <sstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("Can not open file");
+    }
+    std::ostringstream content;
+    content << input.rdbuf();
+    buffer_ = std::move(content).str();
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+}
+
+MappedFile::~MappedFile() = default;
+
+#else
+
+MappedFile::MappedFile(const std::string& path) {
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor == -1) {
+        throw std::runtime_error("Can not open file");
+    }
+    struct stat status{};
+    if (fstat(descriptor, &status) == -1) {
+        close(descriptor);
+        throw std::runtime_error("Can not open file");
+    }
+    size_ = static_cast<size_t>(status.st_size);
+    if (size_ != 0) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (data == MAP_FAILED) {
+            close(descriptor);
+            throw std::runtime_error("Can not open file");
+        }
+        madvise(data, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(data);
+    }
+    close(descriptor);
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+#endif
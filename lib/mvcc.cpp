@@ -0,0 +1,22 @@
+#include "mvcc.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace {
+
+std::mutex commit_mutex;
+std::atomic<Timestamp> committed{0};
+
+}
+
+Timestamp LastCommit() {
+    return committed.load();
+}
+
+void Commit(const std::function<void(Timestamp)>& stamp) {
+    std::lock_guard lock(commit_mutex);
+    Timestamp timestamp = committed.load(std::memory_order_relaxed) + 1;
+    stamp(timestamp);
+    committed.store(timestamp);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+
+using Timestamp = uint64_t;
+
+// Begin of a version that is not committed yet and end of a version that is still live.
+constexpr Timestamp kInfinity = std::numeric_limits<Timestamp>::max();
+
+// Sees the latest committed version of every row; only a writer holding the table lock may read at it.
+constexpr Timestamp kLatest = kInfinity - 1;
+
+// A version is visible at timestamp t when begin <= t < end. Commits are numbered by one clock
+// shared by all tables, so a timestamp gives a consistent view of several tables at once.
+[[nodiscard]] Timestamp LastCommit();
+
+// Calls `stamp` with the next timestamp; snapshots see everything it stamps from the moment it returns.
+void Commit(const std::function<void(Timestamp)>& stamp);
@@ -0,0 +1,305 @@
+#include "order.h"
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+namespace {
+
+constexpr uint64_t kNullWord = ~uint64_t(0);
+constexpr size_t kUnbounded = std::numeric_limits<size_t>::max();
+// Inputs below this many rows per thread are sorted on the calling thread.
+constexpr size_t kSortRows = 1 << 16;
+// Fewer rows are sorted by comparisons.
+constexpr size_t kRadixRows = 1 << 10;
+
+// Order preserving word of a value: signed numbers have their sign bit flipped and negative floats
+// all their bits, zeros lose their sign and NaNs their payload and sort above the infinities.
+template<typename T>
+uint64_t Word(const Column& column, size_t row) {
+    T value = column.Value<T>(row);
+    if constexpr (std::is_floating_point_v<T>) {
+        using Bits = std::conditional_t<sizeof(T) == sizeof(uint32_t), uint32_t, uint64_t>;
+        constexpr Bits kSign = Bits(1) << (sizeof(Bits) * 8 - 1);
+        if (value == 0) {
+            value = 0;
+        } else if (std::isnan(value)) {
+            value = std::numeric_limits<T>::quiet_NaN();
+        }
+        auto bits = std::bit_cast<Bits>(value);
+        return (bits & kSign) != 0 ? static_cast<Bits>(~bits) : bits | kSign;
+    } else if constexpr (std::is_same_v<T, bool>) {
+        return value;
+    } else {
+        return static_cast<uint32_t>(value) ^ 0x80000000U;
+    }
+}
+
+// Stable sort on the `word` of the entries, kRadixBits at a time from the lowest ones; digits that
+// all entries share are skipped. `buffer` has room for the entries.
+template<typename Entry>
+void RadixSort(Entry* begin, Entry* end, Entry* buffer) {
+    constexpr size_t kRadixBits = 11;
+    constexpr size_t kDigits = (64 + kRadixBits - 1) / kRadixBits;
+    constexpr uint64_t kMask = (uint64_t(1) << kRadixBits) - 1;
+    size_t size = end - begin;
+    std::vector<std::array<size_t, kMask + 1>> counts(kDigits);
+    for (Entry* i = begin; i != end; ++i) {
+        for (size_t digit = 0; digit < kDigits; ++digit) {
+            ++counts[digit][(i->word >> (digit * kRadixBits)) & kMask];
+        }
+    }
+    Entry* from = begin;
+    Entry* to = buffer;
+    for (size_t digit = 0; digit < kDigits; ++digit) {
+        auto& count = counts[digit];
+        if (count[(from->word >> (digit * kRadixBits)) & kMask] == size) {
+            continue;
+        }
+        size_t offset = 0;
+        for (auto& i: count) {
+            offset += std::exchange(i, offset);
+        }
+        for (Entry* i = from; i != from + size; ++i) {
+            to[count[(i->word >> (digit * kRadixBits)) & kMask]++] = *i;
+        }
+        std::swap(from, to);
+    }
+    if (from != begin) {
+        std::copy(from, from + size, begin);
+    }
+}
+
+// Sorts parts of the input on the pool with `sort` and merges neighbouring parts in rounds.
+template<typename Iterator, typename Compare, typename Sort>
+void ParallelSort(Iterator begin, Iterator end, Compare less, Sort sort, ThreadPool& pool) {
+    size_t size = end - begin;
+    size_t parts = std::min(pool.Size() + 1, size / kSortRows);
+    if (parts < 2) {
+        sort(begin, end);
+        return;
+    }
+    std::vector<size_t> bounds(parts + 1);
+    for (size_t i = 0; i <= parts; ++i) {
+        bounds[i] = i * size / parts;
+    }
+    pool.ForEach(parts, [&](size_t part) {
+        sort(begin + bounds[part], begin + bounds[part + 1]);
+    });
+    for (size_t width = 1; width < parts; width *= 2) {
+        pool.ForEach((parts + 2 * width - 1) / (2 * width), [&](size_t merge) {
+            size_t first = 2 * width * merge;
+            size_t middle = std::min(parts, first + width);
+            size_t last = std::min(parts, first + 2 * width);
+            if (middle < last) {
+                std::inplace_merge(begin + bounds[first], begin + bounds[middle], begin + bounds[last], less);
+            }
+        });
+    }
+}
+
+}
+
+RowOrder::RowOrder(const std::vector<SortKey>& keys, std::vector<const Column*> columns) :
+        keys_(keys), columns_(std::move(columns)), ranks_(keys.size()) {
+    for (size_t i = 0; i < keys_.size(); ++i) {
+        const Column& column = *columns_[i];
+        if (column.Type() != TYPE::STRING) {
+            continue;
+        }
+        std::vector<uint32_t> codes(column.Entries());
+        std::iota(codes.begin(), codes.end(), 0);
+        std::sort(codes.begin(), codes.end(), [&column](uint32_t first, uint32_t second) {
+            return column.Entry(first) < column.Entry(second);
+        });
+        ranks_[i].resize(codes.size());
+        for (size_t j = 0; j < codes.size(); ++j) {
+            ranks_[i][codes[j]] = j;
+        }
+    }
+}
+
+template<typename T>
+void RowOrder::EncodeKey(size_t key, const size_t* rows, size_t count, uint64_t* words, size_t stride) const {
+    const Column& column = *columns_[key];
+    uint64_t flip = keys_[key].is_descending ? ~uint64_t(0) : 0;
+    for (size_t i = 0; i < count; ++i) {
+        size_t row = rows[i];
+        uint64_t word = kNullWord;
+        if (row != Column::kNullRow && !column.IsNull(row)) {
+            if constexpr (std::is_same_v<T, std::string_view>) {
+                word = ranks_[key][column.Code(row)];
+            } else {
+                word = Word<T>(column, row);
+            }
+        }
+        words[i * stride] = word ^ flip;
+    }
+}
+
+void RowOrder::Encode(const size_t* const* rows, size_t count, uint64_t* words, size_t stride) const {
+    for (size_t i = 0; i < keys_.size(); ++i) {
+        const size_t* key_rows = rows[keys_[i].column.source];
+        switch (columns_[i]->Type()) {
+            case TYPE::INT:
+                EncodeKey<int>(i, key_rows, count, words + i, stride);
+                break;
+            case TYPE::FLOAT:
+                EncodeKey<float>(i, key_rows, count, words + i, stride);
+                break;
+            case TYPE::DOUBLE:
+                EncodeKey<double>(i, key_rows, count, words + i, stride);
+                break;
+            case TYPE::BOOL:
+                EncodeKey<bool>(i, key_rows, count, words + i, stride);
+                break;
+            default:
+                EncodeKey<std::string_view>(i, key_rows, count, words + i, stride);
+                break;
+        }
+    }
+}
+
+RowSorter::RowSorter(const RowOrder& order, size_t limit) :
+        order_(order), stride_(order.Keys() + 1), limit_(limit) {}
+
+void RowSorter::Push(const uint64_t* words, size_t left, size_t right) {
+    auto less = [this](size_t first, size_t second) {
+        return Less(Words(first), Words(second));
+    };
+    size_t slot;
+    if (limit_ == kUnbounded || heap_.size() < limit_) {
+        slot = rows_.size() / 2;
+        words_.insert(words_.end(), words, words + stride_);
+        rows_.push_back(left);
+        rows_.push_back(right);
+    } else if (limit_ != 0 && Less(words, Words(heap_.front()))) {
+        std::pop_heap(heap_.begin(), heap_.end(), less);
+        slot = heap_.back();
+        heap_.pop_back();
+        std::copy(words, words + stride_, words_.begin() + static_cast<std::ptrdiff_t>(slot * stride_));
+        rows_[slot * 2] = left;
+        rows_[slot * 2 + 1] = right;
+    } else {
+        return;
+    }
+    if (limit_ != kUnbounded) {
+        heap_.push_back(slot);
+        std::push_heap(heap_.begin(), heap_.end(), less);
+    }
+}
+
+void RowSorter::Add(const size_t* const* rows, size_t count, uint64_t sequence) {
+    has_right_ = has_right_ || rows[1] != nullptr;
+    if (limit_ == kUnbounded) {
+        size_t size = rows_.size() / 2;
+        Resize(count);
+        Fill(size, rows, count, sequence);
+        return;
+    }
+    batch_.resize(count * stride_);
+    order_.Encode(rows, count, batch_.data(), stride_);
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t* words = batch_.data() + i * stride_;
+        words[stride_ - 1] = sequence + i;
+        Push(words, rows[0][i], rows[1] == nullptr ? Column::kNullRow : rows[1][i]);
+    }
+}
+
+void RowSorter::Resize(size_t rows) {
+    words_.resize(words_.size() + rows * stride_);
+    rows_.resize(rows_.size() + rows * 2, Column::kNullRow);
+}
+
+void RowSorter::Fill(size_t slot, const size_t* const* rows, size_t count, uint64_t sequence) {
+    if (rows[1] != nullptr) {
+        has_right_ = true;
+    }
+    order_.Encode(rows, count, words_.data() + slot * stride_, stride_);
+    for (size_t i = 0; i < count; ++i) {
+        words_[(slot + i) * stride_ + stride_ - 1] = sequence + i;
+        rows_[(slot + i) * 2] = rows[0][i];
+        rows_[(slot + i) * 2 + 1] = rows[1] == nullptr ? Column::kNullRow : rows[1][i];
+    }
+}
+
+void RowSorter::Merge(const RowSorter& other) {
+    has_right_ = has_right_ || other.has_right_;
+    if (limit_ == kUnbounded) {
+        words_.insert(words_.end(), other.words_.begin(), other.words_.end());
+        rows_.insert(rows_.end(), other.rows_.begin(), other.rows_.end());
+        return;
+    }
+    for (size_t i = 0; i < other.rows_.size() / 2; ++i) {
+        Push(other.Words(i), other.rows_[i * 2], other.rows_[i * 2 + 1]);
+    }
+}
+
+std::vector<std::pair<size_t, size_t>> RowSorter::Finish(ThreadPool& pool) const {
+    // The first key is copied next to the slot, so only rows with equal first keys look at the rest.
+    // A radix sort on a single key of a single table never looks at the slots, so they hold the rows.
+    struct Entry {
+        uint64_t word;
+        size_t slot;
+    };
+
+    bool holds_rows = limit_ == kUnbounded && stride_ == 2 && !has_right_;
+    std::vector<Entry> entries;
+    entries.reserve(rows_.size() / 2);
+    for (size_t i = 0; i < rows_.size() / 2; ++i) {
+        if (rows_[i * 2] != Column::kNullRow || rows_[i * 2 + 1] != Column::kNullRow) {
+            entries.push_back({Words(i)[0], holds_rows ? rows_[i * 2] : i});
+        }
+    }
+    size_t size = entries.size();
+    // Without the words of the slots equal keys are left to the stable sorts and merges.
+    auto less = [this, holds_rows](const Entry& first, const Entry& second) {
+        if (first.word != second.word) {
+            return first.word < second.word;
+        }
+        return !holds_rows && Less(Words(first.slot), Words(second.slot));
+    };
+    if (limit_ != kUnbounded) {
+        std::sort(entries.begin(), entries.end(), less);
+    } else {
+        // Slots are in sequence order, so a stable sort on the first key only leaves the runs of equal
+        // first keys to be ordered on the other keys.
+        auto sort = [this, &less](Entry* begin, Entry* end) {
+            if (static_cast<size_t>(end - begin) < kRadixRows) {
+                std::stable_sort(begin, end, less);
+                return;
+            }
+            std::vector<Entry> buffer(end - begin);
+            RadixSort(begin, end, buffer.data());
+            for (Entry* run = begin; stride_ > 2 && run != end;) {
+                Entry* next = std::find_if(run, end, [run](const Entry& entry) {
+                    return entry.word != run->word;
+                });
+                if (!std::is_sorted(run, next, less)) {
+                    std::sort(run, next, less);
+                }
+                run = next;
+            }
+        };
+        ParallelSort(entries.data(), entries.data() + size, less, sort, pool);
+    }
+
+    constexpr size_t kPrefetch = 16;
+    std::vector<std::pair<size_t, size_t>> rows(size);
+    if (holds_rows) {
+        for (size_t i = 0; i < size; ++i) {
+            rows[i] = {entries[i].slot, Column::kNullRow};
+        }
+        return rows;
+    }
+    for (size_t i = 0; i < size; ++i) {
+        if (i + kPrefetch < size) {
+            __builtin_prefetch(rows_.data() + entries[i + kPrefetch].slot * 2);
+        }
+        rows[i] = {rows_[entries[i].slot * 2], rows_[entries[i].slot * 2 + 1]};
+    }
+    return rows;
+}
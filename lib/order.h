@@ -0,0 +1,85 @@
+#pragma once
+
+#include "aggregate.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+
+struct SortKey {
+    SourceColumn column;
+    bool is_descending = false;
+};
+
+// Turns the sort keys of rows into words that compare as unsigned integers in the order of the keys.
+// NULL is greater than every value, so it comes last in ascending order and first in descending
+// order; descending keys invert their words. Strings are ranked by their dictionary entries once, so
+// rows never compare strings.
+class RowOrder {
+private:
+    const std::vector<SortKey>& keys_;
+    std::vector<const Column*> columns_;
+    // Rank of every dictionary code of a string key.
+    std::vector<std::vector<uint64_t>> ranks_;
+
+    template<typename T>
+    void EncodeKey(size_t key, const size_t* rows, size_t count, uint64_t* words, size_t stride) const;
+
+public:
+    // `columns` holds the column of every key.
+    RowOrder(const std::vector<SortKey>& keys, std::vector<const Column*> columns);
+
+    [[nodiscard]] size_t Keys() const noexcept {
+        return keys_.size();
+    }
+
+    // Writes the words of key k of the i-th row to words[i * stride + k]; rows[s][i] is the row of
+    // source s, or kNullRow when an outer join did not match it.
+    void Encode(const size_t* const* rows, size_t count, uint64_t* words, size_t stride) const;
+};
+
+// Collects rows with their sort words and hands them out sorted; rows with equal keys keep the order
+// of their sequence numbers. With a limit only that many least rows are kept, on a heap whose top is
+// the greatest of them, so memory stays proportional to the limit. Without one the rows have to come
+// in sequence order, also across merged sorters, and they are radix sorted on their first key.
+class RowSorter {
+private:
+    const RowOrder& order_;
+    // Words of a kept row: one per key and its sequence number.
+    size_t stride_;
+    size_t limit_;
+    std::vector<uint64_t> words_;
+    // Left and right row of every kept row.
+    std::vector<size_t> rows_;
+    bool has_right_ = false;
+    std::vector<size_t> heap_;
+    std::vector<uint64_t> batch_;
+
+    [[nodiscard]] const uint64_t* Words(size_t slot) const {
+        return words_.data() + slot * stride_;
+    }
+
+    [[nodiscard]] bool Less(const uint64_t* first, const uint64_t* second) const {
+        return std::lexicographical_compare(first, first + stride_, second, second + stride_);
+    }
+
+    void Push(const uint64_t* words, size_t left, size_t right);
+
+public:
+    RowSorter(const RowOrder& order, size_t limit);
+
+    // Adds `count` rows as in RowOrder::Encode, numbered from `sequence` on.
+    void Add(const size_t* const* rows, size_t count, uint64_t sequence);
+
+    // Without a limit: makes room for `rows` more rows, which Fill writes from any thread. Slots left
+    // with a pair of kNullRow rows are skipped.
+    void Resize(size_t rows);
+
+    // Writes `count` rows as in Add from `slot` on. Fills that run at once must agree on having right rows.
+    void Fill(size_t slot, const size_t* const* rows, size_t count, uint64_t sequence);
+
+    // Without a limit the rows of `other` have to follow the rows of this sorter.
+    void Merge(const RowSorter& other);
+
+    // Pairs of left and right rows in order; large inputs are sorted on the pool.
+    [[nodiscard]] std::vector<std::pair<size_t, size_t>> Finish(ThreadPool& pool) const;
+};
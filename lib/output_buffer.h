@@ -0,0 +1,86 @@
+#pragma once
+
+#include <charconv>
+#include <cstring>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+class OutputBuffer {
+private:
+    std::ostream& output_;
+    std::vector<char> buffer_;
+    size_t size_ = 0;
+
+    char* Reserve(size_t size) {
+        if (size_ + size > buffer_.size()) {
+            Flush();
+            if (size > buffer_.size()) {
+                buffer_.resize(size);
+            }
+        }
+        return buffer_.data() + size_;
+    }
+
+public:
+    explicit OutputBuffer(std::ostream& output, size_t capacity = 1 << 16) : output_(output), buffer_(capacity) {}
+
+    OutputBuffer(const OutputBuffer&) = delete;
+
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    ~OutputBuffer() {
+        Flush();
+    }
+
+    void Flush() {
+        if (size_ != 0) {
+            output_.write(buffer_.data(), static_cast<std::streamsize>(size_));
+            size_ = 0;
+        }
+    }
+
+    void Append(char value) {
+        *Reserve(1) = value;
+        ++size_;
+    }
+
+    void Append(std::string_view value) {
+        if (value.empty()) {
+            return;
+        }
+        std::memcpy(Reserve(value.size()), value.data(), value.size());
+        size_ += value.size();
+    }
+
+    // `value` may be null when `size` is 0, as the data of an empty vector is.
+    void AppendBytes(const void* value, size_t size) {
+        if (size == 0) {
+            return;
+        }
+        std::memcpy(Reserve(size), value, size);
+        size_ += size;
+    }
+
+    // Shortest representation that reads back to the same value.
+    template<typename T>
+    void AppendNumber(T value) {
+        constexpr size_t kMaxLength = 32;
+        char* begin = Reserve(kMaxLength);
+        size_ += static_cast<size_t>(std::to_chars(begin, begin + kMaxLength, value).ptr - begin);
+    }
+
+    // Same digits as an iostream with the given precision.
+    template<typename T>
+    void AppendNumber(T value, int precision) {
+        constexpr size_t kMaxLength = 32;
+        char* begin = Reserve(kMaxLength);
+        std::to_chars_result result;
+        if constexpr (std::is_floating_point_v<T>) {
+            result = std::to_chars(begin, begin + kMaxLength, value, std::chars_format::general, precision);
+        } else {
+            result = std::to_chars(begin, begin + kMaxLength, value);
+        }
+        size_ += static_cast<size_t>(result.ptr - begin);
+    }
+};
@@ -1 +1,28 @@
 #include "parameter.h"
+
+Parameter CastParameter(const Parameter& value, TYPE type) {
+    if (value.Type() == type || value.Type() == TYPE::NONE) {
+        return value;
+    }
+    Parameter result;
+    if (value.Type() == TYPE::INT) {
+        if (type == TYPE::FLOAT) {
+            result = static_cast<float>(value.GetValue<int>());
+            return result;
+        } else if (type == TYPE::DOUBLE) {
+            result = static_cast<double>(value.GetValue<int>());
+            return result;
+        }
+    } else if (value.Type() == TYPE::DOUBLE) {
+        if (type == TYPE::FLOAT) {
+            result = static_cast<float>(value.GetValue<double>());
+            return result;
+        }
+    } else if (value.Type() == TYPE::FLOAT) {
+        if (type == TYPE::DOUBLE) {
+            result = static_cast<double>(value.GetValue<float>());
+            return result;
+        }
+    }
+    throw std::logic_error("Different types of parameters");
+}
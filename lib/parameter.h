@@ -1,4 +1,8 @@
+#pragma once
+
 #include <iostream>
+#include <stdexcept>
+#include <string>
 #include <variant>
 
 enum class TYPE {
@@ -50,10 +54,19 @@ public:
         return std::get<T>(value_);
     }
 
+    template<typename T>
+    [[nodiscard]] const T& GetValue() const noexcept {
+        return std::get<T>(value_);
+    }
+
     TYPE& Type() noexcept {
         return type_;
     }
 
+    [[nodiscard]] TYPE Type() const noexcept {
+        return type_;
+    }
+
     template<typename T> requires (std::is_same<T, int>::value)
     Parameter& operator=(T value) {
         value_ = value;
@@ -109,7 +122,7 @@ public:
         if (type_ != other.type_) {
             throw std::logic_error("Comparing different types");
         } else {
-            return !(value_ >= other.value_);
+            return value_ >= other.value_;
         }
     }
 
@@ -117,7 +130,7 @@ public:
         if (type_ != other.type_) {
             throw std::logic_error("Comparing different types");
         } else {
-            return !(value_ <= other.value_);
+            return value_ <= other.value_;
         }
     }
 
@@ -129,7 +142,11 @@ public:
         }
     }
 
-    void Print() {
+    [[nodiscard]] size_t Hash() const {
+        return std::hash<value_type>()(value_);
+    }
+
+    void Print() const {
         if (type_ == TYPE::INT) {
             std::cout << GetValue<int>();
         } else if (type_ == TYPE::BOOL) {
@@ -145,4 +162,13 @@ public:
         }
     }
 
-};
\ No newline at end of file
+};
+
+template<>
+struct std::hash<Parameter> {
+    size_t operator()(const Parameter& parameter) const {
+        return parameter.Hash();
+    }
+};
+
+Parameter CastParameter(const Parameter& value, TYPE type);
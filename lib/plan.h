@@ -0,0 +1,78 @@
+#pragma once
+
+#include "order.h"
+#include "predicate.h"
+
+#include <limits>
+
+struct Access {
+    enum class Kind {
+        SCAN,
+        PRIMARY_KEY,
+        INDEX
+    };
+
+    Kind kind = Kind::SCAN;
+    size_t column = 0;
+};
+
+enum class JoinMethod {
+    NESTED_LOOP,
+    HASH,
+    MERGE
+};
+
+struct InsertPlan {
+    std::string table;
+    std::vector<size_t> columns;
+    std::vector<TYPE> types;
+    std::vector<std::vector<Literal>> values;
+};
+
+struct SelectPlan {
+    std::string table;
+    std::optional<JoinClause> join;
+    size_t left_column = 0;
+    size_t right_column = 0;
+    JoinMethod join_method = JoinMethod::NESTED_LOOP;
+    std::vector<size_t> columns;
+    std::vector<std::pair<bool, size_t>> columns_list;
+    bool has_where = false;
+    Access access;
+    Predicate predicate;
+    // Aggregating selects output group keys and aggregates: (true, k) is key k, (false, k) aggregate k.
+    bool is_aggregate = false;
+    std::vector<SourceColumn> group_by;
+    std::vector<Aggregate> aggregates;
+    std::vector<std::pair<bool, size_t>> outputs;
+    std::vector<std::string> names;
+    // Sort keys are table columns, or outputs of an aggregating select. An ascending key with an index
+    // is read from the index in order.
+    std::vector<SortKey> order_by;
+    bool is_index_order = false;
+    std::optional<Literal> limit;
+    std::optional<Literal> offset;
+    // Rows to skip and to return, set from the literals on every execution.
+    size_t offset_rows = 0;
+    size_t limit_rows = std::numeric_limits<size_t>::max();
+};
+
+struct UpdatePlan {
+    std::string table;
+    std::vector<size_t> columns;
+    std::vector<TYPE> types;
+    std::vector<Literal> values;
+    bool has_where = false;
+    Access access;
+    Predicate predicate;
+};
+
+struct DeletePlan {
+    std::string table;
+    bool has_where = false;
+    Access access;
+    Predicate predicate;
+};
+
+using Plan = std::variant<CreateTableStatement, DropTableStatement, InsertPlan, SelectPlan, UpdatePlan, DeletePlan,
+        CreateIndexStatement, DropIndexStatement, CopyStatement>;
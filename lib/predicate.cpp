@@ -0,0 +1,533 @@
+#include "predicate.h"
+#include "filter.h"
+
+bool Compare(const Parameter& first, CompareOperator sign, const Parameter& second) {
+    switch (sign) {
+        case CompareOperator::EQUAL:
+            return first == second;
+        case CompareOperator::NOT_EQUAL:
+            return !(first == second);
+        case CompareOperator::LESS:
+            return first < second;
+        case CompareOperator::GREATER:
+            return first > second;
+        case CompareOperator::LESS_EQUAL:
+            return first <= second;
+        case CompareOperator::GREATER_EQUAL:
+            return first >= second;
+    }
+    throw std::logic_error("Such symbol does not exist");
+}
+
+namespace {
+
+template<typename T>
+bool CompareValues(const T& first, CompareOperator sign, const T& second) {
+    switch (sign) {
+        case CompareOperator::EQUAL:
+            return first == second;
+        case CompareOperator::NOT_EQUAL:
+            return first != second;
+        case CompareOperator::LESS:
+            return first < second;
+        case CompareOperator::GREATER:
+            return first > second;
+        case CompareOperator::LESS_EQUAL:
+            return first <= second;
+        case CompareOperator::GREATER_EQUAL:
+            return first >= second;
+    }
+    return false;
+}
+
+template<typename T>
+T Constant(const Parameter& value) {
+    return value.GetValue<T>();
+}
+
+template<>
+std::string_view Constant<std::string_view>(const Parameter& value) {
+    return value.GetValue<std::string>();
+}
+
+}
+
+bool Compare(const Column& first, size_t first_row, CompareOperator sign, const Column& second, size_t second_row) {
+    if (first.IsNull(first_row) || second.IsNull(second_row)) {
+        return false;
+    }
+    switch (first.Type()) {
+        case TYPE::INT:
+            return CompareValues(first.Value<int>(first_row), sign, second.Value<int>(second_row));
+        case TYPE::FLOAT:
+            return CompareValues(first.Value<float>(first_row), sign, second.Value<float>(second_row));
+        case TYPE::DOUBLE:
+            return CompareValues(first.Value<double>(first_row), sign, second.Value<double>(second_row));
+        case TYPE::BOOL:
+            return CompareValues(first.Value<bool>(first_row), sign, second.Value<bool>(second_row));
+        case TYPE::STRING:
+            return CompareValues(first.Value<std::string_view>(first_row), sign,
+                                 second.Value<std::string_view>(second_row));
+        default:
+            return false;
+    }
+}
+
+CompareOperator Mirror(CompareOperator sign) {
+    switch (sign) {
+        case CompareOperator::LESS:
+            return CompareOperator::GREATER;
+        case CompareOperator::GREATER:
+            return CompareOperator::LESS;
+        case CompareOperator::LESS_EQUAL:
+            return CompareOperator::GREATER_EQUAL;
+        case CompareOperator::GREATER_EQUAL:
+            return CompareOperator::LESS_EQUAL;
+        default:
+            return sign;
+    }
+}
+
+Predicate::Predicate(const Condition& condition, const std::vector<Source>& sources) :
+        root_(Compile(condition, sources)) {}
+
+Predicate::Slot Predicate::Resolve(const Operand& operand, const std::vector<Source>& sources) {
+    Slot slot;
+    if (!operand.is_column) {
+        slot.value = operand.literal.value;
+        slot.type = operand.literal.value.Type();
+        slot.is_placeholder = operand.literal.is_placeholder;
+        slot.index = operand.literal.index;
+        return slot;
+    }
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (!operand.column.table.empty() && operand.column.table != sources[i].first) {
+            continue;
+        }
+        Schema& schema = sources[i].second->GetSchema();
+        if (schema.Contains(operand.column.column)) {
+            slot.is_column = true;
+            slot.source = i;
+            slot.ordinal = schema.Ordinal(operand.column.column);
+            slot.type = schema.Type(slot.ordinal);
+            return slot;
+        }
+    }
+    throw std::logic_error("This parameter does not exist");
+}
+
+Predicate::Node Predicate::Compile(const Condition& condition, const std::vector<Source>& sources) {
+    Node node;
+    if (condition.kind == Condition::Kind::IS_NULL || condition.kind == Condition::Kind::IS_NOT_NULL) {
+        bool is_null = condition.kind == Condition::Kind::IS_NULL;
+        Slot operand = Resolve(condition.left, sources);
+        if (operand.is_placeholder) {
+            throw std::logic_error("Parameter type can not be deduced");
+        }
+        if (!operand.is_column) {
+            node.value = (operand.value.Type() == TYPE::NONE) == is_null;
+            return node;
+        }
+        node.kind = is_null ? Node::Kind::IS_NULL : Node::Kind::IS_NOT_NULL;
+        node.left = std::move(operand);
+        return node;
+    }
+    if (condition.kind != Condition::Kind::COMPARISON) {
+        bool is_and = condition.kind == Condition::Kind::AND;
+        node.kind = is_and ? Node::Kind::AND : Node::Kind::OR;
+        for (const auto& i: condition.children) {
+            Node child = Compile(i, sources);
+            if (child.kind != Node::Kind::CONSTANT) {
+                node.children.push_back(std::move(child));
+            } else if (child.value != is_and) {
+                node = Node();
+                node.value = !is_and;
+                return node;
+            }
+        }
+        if (node.children.empty()) {
+            node.kind = Node::Kind::CONSTANT;
+            node.value = is_and;
+        } else if (node.children.size() == 1) {
+            return std::move(node.children[0]);
+        }
+        return node;
+    }
+
+    node.kind = Node::Kind::COMPARISON;
+    node.sign = condition.sign;
+    node.left = Resolve(condition.left, sources);
+    node.right = Resolve(condition.right, sources);
+
+    if (node.left.is_column && node.right.is_column) {
+        if (node.left.type != node.right.type) {
+            throw std::logic_error("Different types of parameters");
+        }
+        return node;
+    }
+    if (node.left.is_placeholder || node.right.is_placeholder) {
+        if (node.left.is_column) {
+            node.right.type = node.left.type;
+        } else if (node.right.is_column) {
+            node.left.type = node.right.type;
+        } else {
+            throw std::logic_error("Parameter type can not be deduced");
+        }
+        return node;
+    }
+    if ((!node.left.is_column && node.left.value.Type() == TYPE::NONE) ||
+        (!node.right.is_column && node.right.value.Type() == TYPE::NONE)) {
+        node = Node();
+        node.value = false;
+        return node;
+    }
+    if (node.left.is_column) {
+        node.right.value = CastParameter(node.right.value, node.left.type);
+    } else if (node.right.is_column) {
+        node.left.value = CastParameter(node.left.value, node.right.type);
+    } else {
+        if (node.left.value.Type() != node.right.value.Type()) {
+            node.left.value = CastParameter(node.left.value, TYPE::DOUBLE);
+            node.right.value = CastParameter(node.right.value, TYPE::DOUBLE);
+        }
+        bool value = ::Compare(node.left.value, node.sign, node.right.value);
+        node = Node();
+        node.value = value;
+    }
+    return node;
+}
+
+void Predicate::Attach(std::vector<const TableSnapshot*> snapshots) {
+    snapshots_ = std::move(snapshots);
+    Decode(root_);
+}
+
+void Predicate::Decode(Node& node) {
+    node.is_encoded = false;
+    for (auto& i: node.children) {
+        Decode(i);
+    }
+}
+
+void Predicate::Encode(Node& node) {
+    for (auto& i: node.children) {
+        Encode(i);
+    }
+    if (node.kind != Node::Kind::COMPARISON || node.left.type != TYPE::STRING ||
+        (node.sign != CompareOperator::EQUAL && node.sign != CompareOperator::NOT_EQUAL) ||
+        node.left.is_column == node.right.is_column) {
+        return;
+    }
+    const Slot& column = node.left.is_column ? node.left : node.right;
+    const Slot& constant = node.left.is_column ? node.right : node.left;
+    if (constant.value.Type() != TYPE::STRING) {
+        return;
+    }
+    node.code = snapshots_[column.source]->GetColumn(column.ordinal).Find(constant.value.GetValue<std::string>());
+    node.is_encoded = true;
+}
+
+template<typename T>
+T Predicate::Get(const Slot& slot, const size_t* rows) const {
+    if (slot.is_column) {
+        return snapshots_[slot.source]->GetColumn(slot.ordinal).Value<T>(rows[slot.source]);
+    }
+    return Constant<T>(slot.value);
+}
+
+template<typename T>
+bool Predicate::Compare(const Node& node, const size_t* rows) const {
+    return CompareValues(Get<T>(node.left, rows), node.sign, Get<T>(node.right, rows));
+}
+
+bool Predicate::IsNull(const Slot& slot, const size_t* rows) const {
+    if (!slot.is_column) {
+        return slot.value.Type() == TYPE::NONE;
+    }
+    return rows[slot.source] == Column::kNullRow || snapshots_[slot.source]->GetColumn(slot.ordinal).IsNull(rows[slot.source]);
+}
+
+bool Predicate::Evaluate(const Node& node, const size_t* rows) const {
+    switch (node.kind) {
+        case Node::Kind::AND:
+            for (const auto& i: node.children) {
+                if (!Evaluate(i, rows)) {
+                    return false;
+                }
+            }
+            return true;
+        case Node::Kind::OR:
+            for (const auto& i: node.children) {
+                if (Evaluate(i, rows)) {
+                    return true;
+                }
+            }
+            return false;
+        case Node::Kind::COMPARISON:
+            if (IsNull(node.left, rows) || IsNull(node.right, rows)) {
+                return false;
+            }
+            if (node.is_encoded) {
+                const Slot& column = node.left.is_column ? node.left : node.right;
+                uint32_t code = snapshots_[column.source]->GetColumn(column.ordinal).Code(rows[column.source]);
+                return (code == node.code) == (node.sign == CompareOperator::EQUAL);
+            }
+            switch (node.left.type) {
+                case TYPE::INT:
+                    return Compare<int>(node, rows);
+                case TYPE::FLOAT:
+                    return Compare<float>(node, rows);
+                case TYPE::DOUBLE:
+                    return Compare<double>(node, rows);
+                case TYPE::BOOL:
+                    return Compare<bool>(node, rows);
+                case TYPE::STRING:
+                    return Compare<std::string_view>(node, rows);
+                default:
+                    return false;
+            }
+        case Node::Kind::IS_NULL:
+            return IsNull(node.left, rows);
+        case Node::Kind::IS_NOT_NULL:
+            return !IsNull(node.left, rows);
+        default:
+            return node.value;
+    }
+}
+
+template<typename T>
+void Predicate::SelectValues(const Node& node, size_t begin, size_t count, uint64_t* bits) const {
+    auto values = [&](const Slot& slot) {
+        return snapshots_[slot.source]->GetColumn(slot.ordinal).Values<T>(begin);
+    };
+    if (node.left.is_column && node.right.is_column) {
+        CompareColumns(values(node.left), values(node.right), count, node.sign, bits);
+    } else if (node.left.is_column) {
+        CompareToConstant(values(node.left), count, node.sign, Constant<T>(node.right.value), bits);
+    } else {
+        CompareToConstant(values(node.right), count, Mirror(node.sign), Constant<T>(node.left.value), bits);
+    }
+}
+
+void Predicate::SelectBools(const Node& node, size_t begin, size_t count, uint64_t* bits) const {
+    auto word = [&](const Slot& slot, size_t index) -> uint64_t {
+        if (slot.is_column) {
+            return snapshots_[slot.source]->GetColumn(slot.ordinal).BoolWord(begin / 64 + index);
+        }
+        return Constant<bool>(slot.value) ? ~uint64_t(0) : 0;
+    };
+    for (size_t i = 0; i < (count + 63) / 64; ++i) {
+        bits[i] = CompareBits(word(node.left, i), node.sign, word(node.right, i));
+    }
+}
+
+void Predicate::Select(const Node& node, size_t begin, size_t count, uint64_t* bits) const {
+    size_t words = (count + 63) / 64;
+    switch (node.kind) {
+        case Node::Kind::AND:
+        case Node::Kind::OR: {
+            Select(node.children[0], begin, count, bits);
+            std::vector<uint64_t> child(words);
+            for (size_t i = 1; i < node.children.size(); ++i) {
+                Select(node.children[i], begin, count, child.data());
+                for (size_t j = 0; j < words; ++j) {
+                    bits[j] = node.kind == Node::Kind::AND ? bits[j] & child[j] : bits[j] | child[j];
+                }
+            }
+            return;
+        }
+        case Node::Kind::COMPARISON:
+            if ((!node.left.is_column && node.left.value.Type() == TYPE::NONE) ||
+                (!node.right.is_column && node.right.value.Type() == TYPE::NONE)) {
+                std::fill(bits, bits + words, 0);
+                return;
+            }
+            switch (node.left.type) {
+                case TYPE::INT:
+                    SelectValues<int>(node, begin, count, bits);
+                    break;
+                case TYPE::FLOAT:
+                    SelectValues<float>(node, begin, count, bits);
+                    break;
+                case TYPE::DOUBLE:
+                    SelectValues<double>(node, begin, count, bits);
+                    break;
+                case TYPE::BOOL:
+                    SelectBools(node, begin, count, bits);
+                    break;
+                case TYPE::STRING:
+                    if (node.is_encoded) {
+                        const Slot& slot = node.left.is_column ? node.left : node.right;
+                        const uint32_t* codes = snapshots_[slot.source]->GetColumn(slot.ordinal).Codes(begin);
+                        // kNoCode is -1 as an int and matches no row.
+                        CompareToConstant(reinterpret_cast<const int*>(codes), count, node.sign,
+                                          static_cast<int>(node.code), bits);
+                        break;
+                    }
+                    [[fallthrough]];
+                default:
+                    std::fill(bits, bits + words, 0);
+                    for (size_t i = 0; i < count; ++i) {
+                        size_t row = begin + i;
+                        bits[i / 64] |= uint64_t(Evaluate(node, &row)) << (i % 64);
+                    }
+                    return;
+            }
+            for (const Slot* slot: {&node.left, &node.right}) {
+                if (slot->is_column) {
+                    const Column& column = snapshots_[slot->source]->GetColumn(slot->ordinal);
+                    for (size_t i = 0; i < words; ++i) {
+                        bits[i] &= ~column.NullWord(begin / 64 + i);
+                    }
+                }
+            }
+            break;
+        case Node::Kind::IS_NULL:
+        case Node::Kind::IS_NOT_NULL: {
+            const Column& column = snapshots_[node.left.source]->GetColumn(node.left.ordinal);
+            uint64_t flip = node.kind == Node::Kind::IS_NULL ? 0 : ~uint64_t(0);
+            for (size_t i = 0; i < words; ++i) {
+                bits[i] = column.NullWord(begin / 64 + i) ^ flip;
+            }
+            break;
+        }
+        default:
+            std::fill(bits, bits + words, node.value ? ~uint64_t(0) : 0);
+            break;
+    }
+    if (count % 64 != 0) {
+        bits[words - 1] &= (uint64_t(1) << (count % 64)) - 1;
+    }
+}
+
+void Predicate::Select(size_t begin, size_t end, std::vector<uint64_t>& bits) const {
+    bits.resize((end - begin + 63) / 64);
+    Select(root_, begin, end - begin, bits.data());
+}
+
+void Predicate::Bind(Node& node, const std::vector<Parameter>& parameters) {
+    node.is_encoded = false;
+    if (node.kind == Node::Kind::COMPARISON) {
+        for (Slot* slot: {&node.left, &node.right}) {
+            if (slot->is_placeholder) {
+                if (slot->index >= parameters.size()) {
+                    throw std::logic_error("Parameter is not bound");
+                }
+                slot->value = parameters[slot->index];
+            }
+        }
+    }
+    for (auto& i: node.children) {
+        Bind(i, parameters);
+    }
+}
+
+void Predicate::Placeholders(const Node& node, std::vector<TYPE>& types) {
+    if (node.kind == Node::Kind::COMPARISON) {
+        for (const Slot* slot: {&node.left, &node.right}) {
+            if (slot->is_placeholder) {
+                if (slot->index >= types.size()) {
+                    types.resize(slot->index + 1, TYPE::NONE);
+                }
+                types[slot->index] = slot->type;
+            }
+        }
+    }
+    for (const auto& i: node.children) {
+        Placeholders(i, types);
+    }
+}
+
+const Parameter* Predicate::Equality(const Node& node, size_t source, size_t ordinal) {
+    if (node.kind == Node::Kind::AND) {
+        for (const auto& i: node.children) {
+            if (const Parameter* value = Equality(i, source, ordinal)) {
+                return value;
+            }
+        }
+    } else if (node.kind == Node::Kind::COMPARISON && node.sign == CompareOperator::EQUAL) {
+        auto is_key = [&](const Slot& slot) {
+            return slot.is_column && slot.source == source && slot.ordinal == ordinal;
+        };
+        if (is_key(node.left) && !node.right.is_column) {
+            return &node.right.value;
+        }
+        if (is_key(node.right) && !node.left.is_column) {
+            return &node.left.value;
+        }
+    }
+    return nullptr;
+}
+
+bool Predicate::Restriction(const Node& node, size_t source, size_t ordinal, CompareOperator& sign,
+                            const Parameter*& value) {
+    if (node.kind != Node::Kind::COMPARISON || node.sign == CompareOperator::NOT_EQUAL) {
+        return false;
+    }
+    auto is_key = [&](const Slot& slot) {
+        return slot.is_column && slot.source == source && slot.ordinal == ordinal;
+    };
+    if (is_key(node.left) && !node.right.is_column) {
+        sign = node.sign;
+        value = &node.right.value;
+        return true;
+    }
+    if (is_key(node.right) && !node.left.is_column) {
+        sign = Mirror(node.sign);
+        value = &node.left.value;
+        return true;
+    }
+    return false;
+}
+
+std::vector<const Predicate::Node*> Predicate::Conjuncts() const {
+    std::vector<const Node*> conjuncts;
+    if (root_.kind == Node::Kind::AND) {
+        for (const auto& i: root_.children) {
+            conjuncts.push_back(&i);
+        }
+    } else {
+        conjuncts.push_back(&root_);
+    }
+    return conjuncts;
+}
+
+bool Predicate::Restricts(size_t source, size_t ordinal) const {
+    CompareOperator sign;
+    const Parameter* value;
+    for (const Node* i: Conjuncts()) {
+        if (Restriction(*i, source, ordinal, sign, value)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Predicate::Range(size_t source, size_t ordinal, Bound& low, Bound& high) const {
+    auto tighten = [](Bound& bound, const Parameter* value, bool inclusive, bool is_low) {
+        if (bound.value == nullptr || (is_low ? *bound.value < *value : *value < *bound.value)) {
+            bound = {value, inclusive};
+        } else if (*bound.value == *value) {
+            bound.inclusive = bound.inclusive && inclusive;
+        }
+    };
+    CompareOperator sign;
+    const Parameter* value;
+    for (const Node* i: Conjuncts()) {
+        if (!Restriction(*i, source, ordinal, sign, value)) {
+            continue;
+        }
+        if (value->Type() == TYPE::NONE) {
+            return false;
+        }
+        if (sign == CompareOperator::EQUAL || sign == CompareOperator::GREATER ||
+            sign == CompareOperator::GREATER_EQUAL) {
+            tighten(low, value, sign != CompareOperator::GREATER, true);
+        }
+        if (sign == CompareOperator::EQUAL || sign == CompareOperator::LESS ||
+            sign == CompareOperator::LESS_EQUAL) {
+            tighten(high, value, sign != CompareOperator::LESS, false);
+        }
+    }
+    return true;
+}
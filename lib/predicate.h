@@ -0,0 +1,135 @@
+#pragma once
+
+#include "table.h"
+#include "Parser.h"
+
+bool Compare(const Parameter& first, CompareOperator sign, const Parameter& second);
+
+bool Compare(const Column& first, size_t first_row, CompareOperator sign, const Column& second, size_t second_row);
+
+CompareOperator Mirror(CompareOperator sign);
+
+class Predicate {
+public:
+    using Source = std::pair<std::string, Table*>;
+
+    struct Bound {
+        const Parameter* value = nullptr;
+        bool inclusive = true;
+    };
+private:
+    struct Slot {
+        bool is_column = false;
+        bool is_placeholder = false;
+        size_t source = 0;
+        size_t index = 0;
+        size_t ordinal = 0;
+        TYPE type = TYPE::NONE;
+        Parameter value;
+    };
+
+    struct Node {
+        enum class Kind {
+            AND,
+            OR,
+            COMPARISON,
+            IS_NULL,
+            IS_NOT_NULL,
+            CONSTANT
+        };
+
+        Kind kind = Kind::CONSTANT;
+        std::vector<Node> children;
+        Slot left;
+        CompareOperator sign = CompareOperator::EQUAL;
+        Slot right;
+        bool value = true;
+        // A string (in)equality with a constant compares dictionary codes once the constant is encoded.
+        bool is_encoded = false;
+        uint32_t code = Column::kNoCode;
+    };
+
+    Node root_;
+    std::vector<const TableSnapshot*> snapshots_;
+
+    static Slot Resolve(const Operand& operand, const std::vector<Source>& sources);
+
+    static Node Compile(const Condition& condition, const std::vector<Source>& sources);
+
+    template<typename T>
+    T Get(const Slot& slot, const size_t* rows) const;
+
+    template<typename T>
+    bool Compare(const Node& node, const size_t* rows) const;
+
+    bool IsNull(const Slot& slot, const size_t* rows) const;
+
+    bool Evaluate(const Node& node, const size_t* rows) const;
+
+    template<typename T>
+    void SelectValues(const Node& node, size_t begin, size_t count, uint64_t* bits) const;
+
+    void SelectBools(const Node& node, size_t begin, size_t count, uint64_t* bits) const;
+
+    void Select(const Node& node, size_t begin, size_t count, uint64_t* bits) const;
+
+    static void Decode(Node& node);
+
+    void Encode(Node& node);
+
+    static void Bind(Node& node, const std::vector<Parameter>& parameters);
+
+    static void Placeholders(const Node& node, std::vector<TYPE>& types);
+
+    static const Parameter* Equality(const Node& node, size_t source, size_t ordinal);
+
+    static bool Restriction(const Node& node, size_t source, size_t ordinal, CompareOperator& sign,
+                            const Parameter*& value);
+
+    [[nodiscard]] std::vector<const Node*> Conjuncts() const;
+
+public:
+    Predicate() = default;
+
+    Predicate(const Condition& condition, const std::vector<Source>& sources);
+
+    // Rows are read from `snapshots`, one per source, until the next call.
+    void Attach(std::vector<const TableSnapshot*> snapshots);
+
+    // Looks the string constants of equalities up in the dictionaries of the attached snapshots, so
+    // that rows compare codes instead of strings. It reads whole dictionaries, so it pays off for scans.
+    void Encode() {
+        Encode(root_);
+    }
+
+    void Bind(const std::vector<Parameter>& parameters) {
+        Bind(root_, parameters);
+    }
+
+    void Placeholders(std::vector<TYPE>& types) const {
+        Placeholders(root_, types);
+    }
+
+    [[nodiscard]] const Parameter* Equality(size_t source, size_t ordinal) const {
+        return Equality(root_, source, ordinal);
+    }
+
+    [[nodiscard]] bool Restricts(size_t source, size_t ordinal) const;
+
+    [[nodiscard]] bool Range(size_t source, size_t ordinal, Bound& low, Bound& high) const;
+
+    // Sets bit i of `bits` when the predicate holds for row `begin + i` of its only source, for the rows
+    // below `end`. Numeric comparisons run on the filter kernels and null tests on the null bitmaps;
+    // visibility is not checked. `begin` is a multiple of 64.
+    void Select(size_t begin, size_t end, std::vector<uint64_t>& bits) const;
+
+    bool operator()(size_t row) const {
+        size_t rows[] = {row};
+        return Evaluate(root_, rows);
+    }
+
+    bool operator()(size_t left, size_t right) const {
+        size_t rows[] = {left, right};
+        return Evaluate(root_, rows);
+    }
+};
@@ -0,0 +1,24 @@
+#include "result.h"
+#include "formatter.h"
+
+bool ResultSet::Next() {
+    if (!producer_) {
+        return false;
+    }
+    if (!producer_(left_row_, right_row_)) {
+        producer_ = nullptr;
+        left_row_ = Column::kNullRow;
+        right_row_ = Column::kNullRow;
+        return false;
+    }
+    return true;
+}
+
+Parameter ResultSet::GetParameter(size_t column) const {
+    size_t row = Row(column);
+    return row == Column::kNullRow ? Parameter() : sources_[column].column->Get(row);
+}
+
+void ResultSet::Print() {
+    Write(*this, std::cout);
+}
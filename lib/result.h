@@ -0,0 +1,65 @@
+#pragma once
+
+#include "column.h"
+
+#include <functional>
+#include <memory>
+
+class ResultSet {
+public:
+    struct ColumnInfo {
+        std::string name;
+        TYPE type = TYPE::NONE;
+    };
+
+    // Pulls the next pair of (left, right) row positions; right is unused for single-table results.
+    using Producer = std::function<bool(size_t&, size_t&)>;
+
+    struct Source {
+        bool is_left = true;
+        const Column* column = nullptr;
+    };
+private:
+    std::vector<ColumnInfo> columns_;
+    std::vector<Source> sources_;
+    Producer producer_;
+    std::shared_ptr<void> guard_;
+    size_t left_row_ = Column::kNullRow;
+    size_t right_row_ = Column::kNullRow;
+
+    [[nodiscard]] size_t Row(size_t column) const {
+        return sources_[column].is_left ? left_row_ : right_row_;
+    }
+
+public:
+    ResultSet() = default;
+
+    ResultSet(std::vector<ColumnInfo> columns, std::vector<Source> sources, Producer producer) :
+            columns_(std::move(columns)), sources_(std::move(sources)), producer_(std::move(producer)) {}
+
+    [[nodiscard]] const std::vector<ColumnInfo>& GetColumns() const {
+        return columns_;
+    }
+
+    bool Next();
+
+    [[nodiscard]] bool IsNull(size_t column) const {
+        size_t row = Row(column);
+        return row == Column::kNullRow || sources_[column].column->IsNull(row);
+    }
+
+    template<typename T>
+    [[nodiscard]] T Get(size_t column) const {
+        return sources_[column].column->Value<T>(Row(column));
+    }
+
+    [[nodiscard]] Parameter GetParameter(size_t column) const;
+
+    // Keeps `guard` alive while the rows are read; the database passes the snapshots of the source
+    // tables here, so a result keeps showing the rows as they were when it was built.
+    void Hold(std::shared_ptr<void> guard) {
+        guard_ = std::move(guard);
+    }
+
+    void Print();
+};
@@ -0,0 +1,28 @@
+#include "schema.h"
+
+void Schema::AddColumn(const std::string& name, TYPE type, bool is_not_null) {
+    if (Contains(name)) {
+        throw std::logic_error("This parameter already exists in this table");
+    }
+    ordinals_[name] = names_.size();
+    names_.push_back(name);
+    types_.push_back(type);
+    not_null_.push_back(is_not_null);
+}
+
+size_t Schema::Ordinal(const std::string& name) const {
+    auto ordinal = ordinals_.find(name);
+    if (ordinal == ordinals_.end()) {
+        throw std::logic_error("This parameter does not exist in this table");
+    }
+    return ordinal->second;
+}
+
+void Schema::SetPrimary(const std::string& name) {
+    if (HasPrimary()) {
+        throw std::logic_error("This table already has a primary key");
+    }
+    primary_ordinal_ = Ordinal(name);
+    primary_key_ = name;
+    not_null_[primary_ordinal_] = true;
+}
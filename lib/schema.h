@@ -0,0 +1,61 @@
+#pragma once
+
+#include "parameter.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Schema {
+private:
+    std::string primary_key_;
+    size_t primary_ordinal_ = 0;
+    std::vector<std::string> names_;
+    std::vector<TYPE> types_;
+    std::vector<bool> not_null_;
+    std::unordered_map<std::string, size_t> ordinals_;
+public:
+    Schema() = default;
+
+    void AddColumn(const std::string& name, TYPE type, bool is_not_null);
+
+    [[nodiscard]] size_t Size() const noexcept {
+        return names_.size();
+    }
+
+    [[nodiscard]] bool Contains(const std::string& name) const {
+        return ordinals_.find(name) != ordinals_.end();
+    }
+
+    [[nodiscard]] size_t Ordinal(const std::string& name) const;
+
+    [[nodiscard]] const std::string& Name(size_t ordinal) const {
+        return names_[ordinal];
+    }
+
+    [[nodiscard]] TYPE Type(size_t ordinal) const {
+        return types_[ordinal];
+    }
+
+    [[nodiscard]] bool IsNotNull(size_t ordinal) const {
+        return not_null_[ordinal];
+    }
+
+    void SetPrimary(const std::string& name);
+
+    std::string& GetPrimary() {
+        return primary_key_;
+    }
+
+    [[nodiscard]] bool HasPrimary() const noexcept {
+        return !primary_key_.empty();
+    }
+
+    [[nodiscard]] size_t PrimaryOrdinal() const noexcept {
+        return primary_ordinal_;
+    }
+
+    const std::vector<std::string>& GetOrder() const {
+        return names_;
+    }
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "output_buffer.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+constexpr char kSnapshotMagic[8] = {'S', 'Q', 'L', 'S', 'N', 'A', 'P', '\0'};
+constexpr uint32_t kSnapshotVersion = 2;
+
+// Values are stored in native byte order; blocks of values start at an 8-byte aligned offset
+// so that a mapped file can be read in place.
+class SnapshotWriter {
+private:
+    OutputBuffer buffer_;
+    size_t offset_ = 0;
+
+public:
+    explicit SnapshotWriter(std::ostream& output) : buffer_(output, 1 << 20) {}
+
+    void WriteBytes(const void* data, size_t size) {
+        buffer_.AppendBytes(data, size);
+        offset_ += size;
+    }
+
+    template<typename T>
+    void Write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        WriteBytes(&value, sizeof(T));
+    }
+
+    void WriteString(std::string_view value) {
+        Write(static_cast<uint64_t>(value.size()));
+        WriteBytes(value.data(), value.size());
+    }
+
+    void Align() {
+        constexpr char kPadding[8] = {};
+        WriteBytes(kPadding, (8 - offset_ % 8) % 8);
+    }
+
+    void Flush() {
+        buffer_.Flush();
+    }
+};
+
+class SnapshotReader {
+private:
+    std::string_view data_;
+    size_t position_ = 0;
+
+public:
+    explicit SnapshotReader(std::string_view data) : data_(data) {}
+
+    const char* ReadBytes(size_t size) {
+        if (size > data_.size() - position_) {
+            throw std::runtime_error("Bad snapshot");
+        }
+        const char* result = data_.data() + position_;
+        position_ += size;
+        return result;
+    }
+
+    template<typename T>
+    T Read() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value;
+        std::memcpy(&value, ReadBytes(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    std::string ReadString() {
+        auto size = Read<uint64_t>();
+        return {ReadBytes(size), size};
+    }
+
+    void Align() {
+        ReadBytes((8 - position_ % 8) % 8);
+    }
+
+    [[nodiscard]] bool AtEnd() const noexcept {
+        return position_ == data_.size();
+    }
+};
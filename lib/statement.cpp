@@ -0,0 +1,69 @@
+#include "statement.h"
+#include "db.h"
+
+PreparedStatement::PreparedStatement(DataBase& data_base, std::string request, Statement statement,
+                                     size_t placeholders) :
+        data_base_(&data_base), request_(std::move(request)), statement_(std::move(statement)), types_(placeholders, TYPE::NONE),
+        values_(placeholders), parameters_(placeholders), bound_(placeholders, false) {
+    Prepare();
+}
+
+void PreparedStatement::Prepare() {
+    plan_ = data_base_->MakePlan(statement_);
+    schema_version_ = data_base_->schema_version_;
+
+    std::fill(types_.begin(), types_.end(), TYPE::NONE);
+    if (auto* insert = std::get_if<InsertPlan>(&plan_)) {
+        for (const auto& row: insert->values) {
+            for (size_t i = 0; i < row.size(); ++i) {
+                if (row[i].is_placeholder) {
+                    types_[row[i].index] = insert->types[i];
+                }
+            }
+        }
+    } else if (auto* update = std::get_if<UpdatePlan>(&plan_)) {
+        for (size_t i = 0; i < update->values.size(); ++i) {
+            if (update->values[i].is_placeholder) {
+                types_[update->values[i].index] = update->types[i];
+            }
+        }
+        update->predicate.Placeholders(types_);
+    } else if (auto* select = std::get_if<SelectPlan>(&plan_)) {
+        select->predicate.Placeholders(types_);
+        for (const auto* i: {&select->limit, &select->offset}) {
+            if (i->has_value() && (*i)->is_placeholder) {
+                types_[(*i)->index] = TYPE::INT;
+            }
+        }
+    } else if (auto* remove = std::get_if<DeletePlan>(&plan_)) {
+        remove->predicate.Placeholders(types_);
+    }
+
+    for (size_t i = 0; i < values_.size(); ++i) {
+        if (bound_[i]) {
+            parameters_[i] = types_[i] == TYPE::NONE ? values_[i] : CastParameter(values_[i], types_[i]);
+        }
+    }
+}
+
+void PreparedStatement::Bind(size_t index, const Parameter& value) {
+    if (index >= types_.size()) {
+        throw std::logic_error("Wrong parameter index");
+    }
+    parameters_[index] = types_[index] == TYPE::NONE ? value : CastParameter(value, types_[index]);
+    values_[index] = value;
+    bound_[index] = true;
+}
+
+ResultSet PreparedStatement::Execute() {
+    auto locks = data_base_->Lock(statement_);
+    if (schema_version_ != data_base_->schema_version_) {
+        Prepare();
+    }
+    for (bool i: bound_) {
+        if (!i) {
+            throw std::logic_error("Parameter is not bound");
+        }
+    }
+    return data_base_->ExecuteLogged(plan_, request_, parameters_);
+}
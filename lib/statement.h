@@ -0,0 +1,41 @@
+#pragma once
+
+#include "plan.h"
+#include "result.h"
+
+class DataBase;
+
+class PreparedStatement {
+private:
+    DataBase* data_base_;
+    std::string request_;
+    Statement statement_;
+    Plan plan_;
+    size_t schema_version_ = 0;
+    std::vector<TYPE> types_;
+    std::vector<Parameter> values_;
+    std::vector<Parameter> parameters_;
+    std::vector<bool> bound_;
+
+    void Prepare();
+
+public:
+    PreparedStatement(DataBase& data_base, std::string request, Statement statement, size_t placeholders);
+
+    [[nodiscard]] size_t ParameterCount() const noexcept {
+        return types_.size();
+    }
+
+    void Bind(size_t index, const Parameter& value);
+
+    template<typename T>
+    void Bind(size_t index, const T& value) {
+        Bind(index, Parameter(value));
+    }
+
+    void Bind(size_t index, const char* value) {
+        Bind(index, Parameter(std::string(value)));
+    }
+
+    ResultSet Execute();
+};
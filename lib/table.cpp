@@ -1 +1,548 @@
 #include "table.h"
+
+#include <algorithm>
+#include <atomic>
+
+void Table::AddColumn(const std::string& name, TYPE type, bool is_not_null) {
+    Touch();
+    schema_->AddColumn(name, type, is_not_null);
+    auto data = Copy(data_->capacity, 0, std::vector<size_t>(data_->columns.size()));
+    Column column(type);
+    column.Reserve(data->capacity);
+    for (size_t i = 0; i < Size(); ++i) {
+        column.Append(Parameter());
+    }
+    data->columns.push_back(std::move(column));
+    Publish(std::move(data));
+}
+
+void Table::SetPrimary(const std::string& name) {
+    Touch();
+    schema_->SetPrimary(name);
+    IndexPrimary();
+}
+
+void Table::IndexPrimary() {
+    primary_index_.clear();
+    if (!schema_->HasPrimary()) {
+        return;
+    }
+    const Column& column = data_->columns[schema_->PrimaryOrdinal()];
+    primary_index_.reserve(Size());
+    for (size_t i = 0; i < Size(); ++i) {
+        if (IsLive(i) && !primary_index_.emplace(column.Get(i), i).second) {
+            throw std::logic_error("This primary key already exists");
+        }
+    }
+}
+
+std::optional<size_t> Table::Find(const Parameter& key) const {
+    auto row = primary_index_.find(key);
+    if (row == primary_index_.end() || !IsLive(row->second)) {
+        return std::nullopt;
+    }
+    return row->second;
+}
+
+void Table::BuildIndex(Index& index) {
+    const Column& column = data_->columns[index.column];
+    std::vector<BTree<Parameter, size_t>::Entry> entries;
+    entries.reserve(Size());
+    for (size_t i = 0; i < Size(); ++i) {
+        if (IsLive(i) && !column.IsNull(i)) {
+            entries.emplace_back(column.Get(i), i);
+        }
+    }
+    index.tree.Build(std::move(entries));
+}
+
+void Table::CreateIndex(const std::string& name, size_t column) {
+    Touch();
+    if (HasIndex(name)) {
+        throw std::logic_error("This index already exists");
+    }
+    Index index;
+    index.name = name;
+    index.column = column;
+    BuildIndex(index);
+    indexes_.push_back(std::move(index));
+}
+
+bool Table::DropIndex(const std::string& name) {
+    Touch();
+    for (auto i = indexes_.begin(); i != indexes_.end(); ++i) {
+        if (i->name == name) {
+            indexes_.erase(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Table::HasIndex(const std::string& name) const {
+    return std::any_of(indexes_.begin(), indexes_.end(), [&](const Index& index) {
+        return index.name == name;
+    });
+}
+
+const BTree<Parameter, size_t>* Table::FindIndex(size_t column) const {
+    for (const auto& i: indexes_) {
+        if (i.column == column) {
+            return &i.tree;
+        }
+    }
+    return nullptr;
+}
+
+void Table::Publish(std::shared_ptr<TableData> data) {
+    data_ = std::move(data);
+    published_->store(data_);
+}
+
+std::shared_ptr<TableData> Table::Copy(size_t capacity, size_t rows, const std::vector<size_t>& bytes) const {
+    size_t size = Size();
+    auto data = std::make_shared<TableData>(capacity);
+    data->horizon = data_->horizon;
+    for (size_t i = 0; i < data_->columns.size(); ++i) {
+        const Column& source = data_->columns[i];
+        Column column(source.Type());
+        column.Reserve(capacity, (source.Bytes() + bytes[i]) * capacity / std::max<size_t>(size + rows, 1));
+        column.Append(source, 0, size);
+        data->columns.push_back(std::move(column));
+    }
+    for (size_t i = 0; i < size; ++i) {
+        data->begin[i].store(data_->begin[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        data->end[i].store(data_->end[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    data->size.store(size, std::memory_order_relaxed);
+    return data;
+}
+
+void Table::Grow(size_t rows, const std::vector<size_t>& bytes) {
+    bool fits = Size() + rows <= data_->capacity;
+    for (size_t i = 0; fits && i < data_->columns.size(); ++i) {
+        fits = data_->columns[i].Fits(rows, bytes[i]);
+    }
+    if (!fits) {
+        Publish(Copy(std::max(Size() + rows, data_->capacity * 2), rows, bytes));
+    }
+}
+
+void Table::Reserve(size_t rows) {
+    if (rows > Size()) {
+        Grow(rows - Size(), std::vector<size_t>(data_->columns.size()));
+    }
+    if (schema_->HasPrimary()) {
+        primary_index_.reserve(rows);
+    }
+}
+
+void Table::IndexKey(size_t row, size_t replaced) {
+    auto [position, inserted] = primary_index_.try_emplace(data_->columns[schema_->PrimaryOrdinal()].Get(row), row);
+    if (!inserted) {
+        if (position->second != replaced && IsLive(position->second)) {
+            throw std::logic_error("This primary key already exists");
+        }
+        position->second = row;
+    }
+}
+
+void Table::UnindexKeys(size_t begin, size_t end, const std::vector<size_t>& ended, bool replace) {
+    const Column& column = data_->columns[schema_->PrimaryOrdinal()];
+    for (size_t i = begin; i < end; ++i) {
+        Parameter key = column.Get(i);
+        auto position = primary_index_.find(key);
+        if (position == primary_index_.end() || position->second != i) {
+            continue;
+        }
+        size_t replaced = replace ? ended[i - begin] : Column::kNullRow;
+        if (replaced != Column::kNullRow && column.Get(replaced) == key) {
+            position->second = replaced;
+        } else {
+            primary_index_.erase(position);
+        }
+    }
+}
+
+void Table::Stamp(size_t size, const std::vector<size_t>& ended, bool replace) {
+    TableData& data = *data_;
+    size_t begin = Size();
+    size_t indexed = begin;
+    try {
+        for (; schema_->HasPrimary() && indexed < size; ++indexed) {
+            IndexKey(indexed, replace ? ended[indexed - begin] : Column::kNullRow);
+        }
+        if (commit_hook_) {
+            commit_hook_(begin, size);
+        }
+    } catch (...) {
+        if (schema_->HasPrimary()) {
+            UnindexKeys(begin, indexed, ended, replace);
+        }
+        for (auto& i: data.columns) {
+            i.Truncate(begin);
+        }
+        throw;
+    }
+    for (auto& i: indexes_) {
+        const Column& column = data.columns[i.column];
+        for (size_t j = begin; j < size; ++j) {
+            if (!column.IsNull(j)) {
+                i.tree.Insert(column.Get(j), j);
+            }
+        }
+    }
+    ::Commit([&](Timestamp timestamp) {
+        for (size_t i = begin; i < size; ++i) {
+            data.begin[i].store(timestamp, std::memory_order_relaxed);
+        }
+        for (auto i: ended) {
+            data.end[i].store(timestamp, std::memory_order_relaxed);
+        }
+        data.size.store(size, std::memory_order_release);
+    });
+    dead_ += ended.size();
+}
+
+void Table::AppendRows(const std::vector<Parameter>* rows, size_t count) {
+    Touch();
+    std::vector<size_t> bytes(data_->columns.size());
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        for (size_t j = 0; j < count && schema_->Type(i) == TYPE::STRING; ++j) {
+            if (rows[j][i].Type() == TYPE::STRING) {
+                bytes[i] += rows[j][i].GetValue<std::string>().size();
+            }
+        }
+    }
+    Grow(count, bytes);
+    size_t size = Size();
+    for (size_t i = 0; i < data_->columns.size(); ++i) {
+        for (size_t j = 0; j < count; ++j) {
+            data_->columns[i].Append(schema_->HasPrimary() && i == schema_->PrimaryOrdinal() ?
+                                     CastParameter(rows[j][i], schema_->Type(i)) : rows[j][i]);
+        }
+    }
+    for (size_t i = size; i < size + count; ++i) {
+        data_->begin[i].store(kInfinity, std::memory_order_relaxed);
+        data_->end[i].store(kInfinity, std::memory_order_relaxed);
+    }
+    Stamp(size + count, {}, false);
+}
+
+void Table::Append(const std::vector<Parameter>& row) {
+    AppendRows(&row, 1);
+}
+
+void Table::Append(const std::vector<std::vector<Parameter>>& rows) {
+    AppendRows(rows.data(), rows.size());
+}
+
+void Table::Append(std::vector<Column> columns) {
+    Touch();
+    size_t count = columns.empty() ? 0 : columns[0].Size();
+    std::vector<size_t> bytes;
+    for (const auto& i: columns) {
+        bytes.push_back(i.Bytes());
+    }
+    Grow(count, bytes);
+    size_t size = Size();
+    for (size_t i = 0; i < columns.size(); ++i) {
+        data_->columns[i].Append(columns[i], 0, count);
+    }
+    for (size_t i = size; i < size + count; ++i) {
+        data_->begin[i].store(kInfinity, std::memory_order_relaxed);
+        data_->end[i].store(kInfinity, std::memory_order_relaxed);
+    }
+    Stamp(size + count, {}, false);
+}
+
+void Table::Update(const std::vector<size_t>& rows, const std::vector<std::pair<size_t, Parameter>>& values) {
+    if (rows.empty()) {
+        return;
+    }
+    Touch();
+    std::vector<const Parameter*> assigned(data_->columns.size(), nullptr);
+    for (const auto& i: values) {
+        assigned[i.first] = &i.second;
+    }
+    if (schema_->HasPrimary() && assigned[schema_->PrimaryOrdinal()] != nullptr && rows.size() > 1) {
+        throw std::logic_error("This primary key already exists");
+    }
+    std::vector<size_t> bytes(data_->columns.size());
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        if (schema_->Type(i) != TYPE::STRING) {
+            continue;
+        }
+        if (assigned[i] != nullptr) {
+            bytes[i] = assigned[i]->Type() == TYPE::STRING ? rows.size() * assigned[i]->GetValue<std::string>().size() : 0;
+            continue;
+        }
+        for (auto row: rows) {
+            bytes[i] += data_->columns[i].Value<std::string_view>(row).size();
+        }
+    }
+    Grow(rows.size(), bytes);
+    size_t size = Size();
+    for (size_t i = 0; i < data_->columns.size(); ++i) {
+        Column& column = data_->columns[i];
+        for (auto row: rows) {
+            if (assigned[i] != nullptr) {
+                column.Append(*assigned[i]);
+            } else {
+                column.Append(column, row, row + 1);
+            }
+        }
+    }
+    for (size_t i = size; i < size + rows.size(); ++i) {
+        data_->begin[i].store(kInfinity, std::memory_order_relaxed);
+        data_->end[i].store(kInfinity, std::memory_order_relaxed);
+    }
+    Stamp(size + rows.size(), rows, true);
+}
+
+void Table::Erase(const std::vector<size_t>& rows) {
+    if (rows.empty()) {
+        return;
+    }
+    Touch();
+    Stamp(Size(), rows, false);
+}
+
+void Table::Clear() {
+    std::vector<size_t> rows;
+    for (size_t i = 0; i < Size(); ++i) {
+        if (IsLive(i)) {
+            rows.push_back(i);
+        }
+    }
+    Erase(rows);
+}
+
+void Table::Collect() {
+    Timestamp horizon = LastCommit();
+    size_t size = Size();
+    std::vector<std::pair<size_t, size_t>> runs;
+    // New position of every kept version; a dropped one gets the position of the next kept version
+    // and the kDropped bit.
+    constexpr size_t kDropped = size_t(1) << (sizeof(size_t) * 8 - 1);
+    std::vector<size_t> moved(size);
+    size_t kept = 0;
+    for (size_t i = 0; i < size; ++i) {
+        moved[i] = kept | kDropped;
+        if (data_->end[i].load(std::memory_order_relaxed) > horizon) {
+            moved[i] = kept;
+            if (!runs.empty() && runs.back().second == i) {
+                ++runs.back().second;
+            } else {
+                runs.emplace_back(i, i + 1);
+            }
+            ++kept;
+        }
+    }
+    if (kept == size) {
+        return;
+    }
+
+    auto data = std::make_shared<TableData>(kept + kept / 2);
+    data->horizon = horizon;
+    for (const auto& source: data_->columns) {
+        size_t bytes = 0;
+        if (source.Type() == TYPE::STRING) {
+            for (const auto& i: runs) {
+                for (size_t j = i.first; j < i.second; ++j) {
+                    bytes += source.Value<std::string_view>(j).size();
+                }
+            }
+        }
+        Column column(source.Type());
+        column.Reserve(data->capacity, bytes + bytes / 2);
+        for (const auto& i: runs) {
+            column.Append(source, i.first, i.second);
+        }
+        data->columns.push_back(std::move(column));
+    }
+    dead_ = 0;
+    size_t row = 0;
+    for (const auto& i: runs) {
+        for (size_t j = i.first; j < i.second; ++j, ++row) {
+            Timestamp end = data_->end[j].load(std::memory_order_relaxed);
+            data->begin[row].store(data_->begin[j].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            data->end[row].store(end, std::memory_order_relaxed);
+            dead_ += end != kInfinity;
+        }
+    }
+    data->size.store(kept, std::memory_order_relaxed);
+
+    // Versions keep their order, so the indexes are remapped instead of rebuilt.
+    auto remap = [&moved](size_t& row) {
+        row = moved[row];
+        bool is_kept = (row & kDropped) == 0;
+        row &= ~kDropped;
+        return is_kept;
+    };
+    for (auto i = primary_index_.begin(); i != primary_index_.end();) {
+        i = remap(i->second) ? std::next(i) : primary_index_.erase(i);
+    }
+    for (auto& i: indexes_) {
+        i.tree.Remap(remap);
+    }
+    Publish(std::move(data));
+}
+
+std::vector<TableSnapshot> Table::Read(const std::vector<const Table*>& tables) {
+    while (true) {
+        Timestamp timestamp = LastCommit();
+        std::vector<TableSnapshot> snapshots;
+        for (auto i: tables) {
+            auto data = i->published_->load();
+            if (data->horizon > timestamp) {
+                break;
+            }
+            snapshots.emplace_back(std::move(data), timestamp);
+        }
+        if (snapshots.size() == tables.size()) {
+            return snapshots;
+        }
+    }
+}
+
+namespace {
+
+std::atomic<size_t> versions{0};
+
+void SaveTable(SnapshotWriter& writer, const Schema& schema, const TableSnapshot& rows,
+               const std::vector<std::pair<std::string, size_t>>& indexes) {
+    writer.Write(static_cast<uint32_t>(schema.Size()));
+    for (size_t i = 0; i < schema.Size(); ++i) {
+        writer.WriteString(schema.Name(i));
+        writer.Write(static_cast<uint8_t>(schema.Type(i)));
+        writer.Write(static_cast<uint8_t>(schema.IsNotNull(i)));
+    }
+    writer.Write(static_cast<uint8_t>(schema.HasPrimary()));
+    writer.Write(static_cast<uint32_t>(schema.PrimaryOrdinal()));
+    writer.Write(static_cast<uint32_t>(indexes.size()));
+    for (const auto& i: indexes) {
+        writer.WriteString(i.first);
+        writer.Write(static_cast<uint32_t>(i.second));
+    }
+
+    std::vector<std::pair<size_t, size_t>> runs;
+    size_t size = 0;
+    for (size_t i = 0; i < rows.Size(); ++i) {
+        if (rows.Visible(i)) {
+            if (!runs.empty() && runs.back().second == i) {
+                ++runs.back().second;
+            } else {
+                runs.emplace_back(i, i + 1);
+            }
+            ++size;
+        }
+    }
+    writer.Write(static_cast<uint64_t>(size));
+    for (size_t i = 0; i < schema.Size(); ++i) {
+        const Column& column = rows.GetColumn(i);
+        if (runs.size() <= 1 && (runs.empty() || runs[0].first == 0)) {
+            column.Save(writer, size);
+            continue;
+        }
+        Column visible(column.Type());
+        visible.Reserve(size);
+        for (const auto& j: runs) {
+            visible.Append(column, j.first, j.second);
+        }
+        visible.Save(writer, size);
+    }
+}
+
+}
+
+void Table::Touch() {
+    version_ = ++versions;
+}
+
+void TableImage::Save(SnapshotWriter& writer) const {
+    SaveTable(writer, *schema, rows, indexes);
+}
+
+TableImage Table::Image() const {
+    return Image(Read({this}).front());
+}
+
+TableImage Table::Image(TableSnapshot rows) const {
+    TableImage image;
+    image.schema = schema_;
+    image.rows = std::move(rows);
+    for (const auto& i: indexes_) {
+        image.indexes.emplace_back(i.name, i.column);
+    }
+    return image;
+}
+
+Table Table::Load(SnapshotReader& reader) {
+    Table table;
+    auto columns = reader.Read<uint32_t>();
+    std::vector<TYPE> types;
+    for (uint32_t i = 0; i < columns; ++i) {
+        std::string name = reader.ReadString();
+        auto type = static_cast<TYPE>(reader.Read<uint8_t>());
+        table.schema_->AddColumn(name, type, reader.Read<uint8_t>() != 0);
+        types.push_back(type);
+    }
+    bool has_primary = reader.Read<uint8_t>() != 0;
+    auto primary = reader.Read<uint32_t>();
+    if (has_primary) {
+        if (primary >= columns) {
+            throw std::runtime_error("Bad snapshot");
+        }
+        table.schema_->SetPrimary(table.schema_->Name(primary));
+    }
+    std::vector<std::pair<std::string, size_t>> indexes(reader.Read<uint32_t>());
+    for (auto& i: indexes) {
+        i.first = reader.ReadString();
+        i.second = reader.Read<uint32_t>();
+        if (i.second >= columns) {
+            throw std::runtime_error("Bad snapshot");
+        }
+    }
+    auto size = reader.Read<uint64_t>();
+    auto data = std::make_shared<TableData>(size);
+    for (auto i: types) {
+        data->columns.push_back(Column::Load(reader, i, size));
+    }
+    for (size_t i = 0; i < size; ++i) {
+        data->end[i].store(kInfinity, std::memory_order_relaxed);
+    }
+    data->size.store(size, std::memory_order_relaxed);
+    table.Publish(std::move(data));
+    table.IndexPrimary();
+    for (const auto& i: indexes) {
+        table.CreateIndex(i.first, i.second);
+    }
+    return table;
+}
+
+Element Table::GetRow(size_t row) const {
+    Element::Row values;
+    values.reserve(data_->columns.size());
+    for (const auto& i: data_->columns) {
+        values.push_back(i.Get(row));
+    }
+    return {*schema_, std::move(values)};
+}
+
+std::vector<Element> Table::GetElement() const {
+    TableSnapshot rows = Read({this}).front();
+    std::vector<Element> elements;
+    for (size_t i = 0; i < rows.Size(); ++i) {
+        if (!rows.Visible(i)) {
+            continue;
+        }
+        Element::Row values;
+        values.reserve(schema_->Size());
+        for (size_t j = 0; j < schema_->Size(); ++j) {
+            values.push_back(rows.GetColumn(j).Get(i));
+        }
+        elements.emplace_back(*schema_, std::move(values));
+    }
+    return elements;
+}
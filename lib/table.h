@@ -1,5 +1,16 @@
+#pragma once
+
+#include "btree.h"
+#include "column.h"
 #include "element.h"
-#include "unordered_set"
+#include "mvcc.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
 
 class Table;
 
@@ -12,52 +23,235 @@ public:
     Connection() = default;
 
     Connection(const std::pair<std::string, std::string>& link, const std::string& foreign_key) :
-    foreign_key_(foreign_key), link_(link) {}
+    link_(link), foreign_key_(foreign_key) {}
 
     std::string& GetKey() {
         return foreign_key_;
     }
 
+    [[nodiscard]] const std::string& GetKey() const {
+        return foreign_key_;
+    }
+
     std::pair<std::string, std::string>& GetLink() {
         return link_;
     }
+
+    [[nodiscard]] const std::pair<std::string, std::string>& GetLink() const {
+        return link_;
+    }
 };
 
-class Table {
+// One generation of a table's storage. Every row is a version that is visible at timestamp t when
+// begin <= t < end. The writer appends and stamps versions in place while they fit in the capacity
+// and otherwise copies the table into a new generation; readers keep using the one they pinned.
+struct TableData {
+    std::vector<Column> columns;
+    std::vector<std::atomic<Timestamp>> begin;
+    std::vector<std::atomic<Timestamp>> end;
+    size_t capacity = 0;
+    std::atomic<size_t> size{0};
+    // Versions that ended at or before the horizon were dropped from this generation.
+    Timestamp horizon = 0;
+
+    explicit TableData(size_t capacity) : begin(capacity), end(capacity), capacity(capacity) {}
+};
+
+// Rows of one table as they were at a timestamp; keeps the generation it reads alive.
+class TableSnapshot {
 private:
-    std::string primary_key_;
-    std::unordered_set<std::string> null_parameters;
-    std::vector<Element> elements_;
-    std::unordered_map<std::string, TYPE> parameter_list_;
-    std::vector <std::string> parameters_;
+    std::shared_ptr<const TableData> data_;
+    size_t size_ = 0;
+    Timestamp timestamp_ = 0;
+
 public:
+    TableSnapshot() = default;
+
+    TableSnapshot(std::shared_ptr<const TableData> data, Timestamp timestamp) :
+            data_(std::move(data)), size_(data_->size.load(std::memory_order_acquire)), timestamp_(timestamp) {}
+
+    // Versions stored up to the snapshot, visible or not.
+    [[nodiscard]] size_t Size() const noexcept {
+        return size_;
+    }
+
+    [[nodiscard]] Timestamp GetTimestamp() const noexcept {
+        return timestamp_;
+    }
+
+    [[nodiscard]] bool Visible(size_t row) const {
+        return data_->begin[row].load(std::memory_order_relaxed) <= timestamp_ &&
+               timestamp_ < data_->end[row].load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] const Column& GetColumn(size_t ordinal) const {
+        return data_->columns[ordinal];
+    }
+};
+
+// Copy of everything a snapshot stores about a table, detached from later changes to it.
+struct TableImage {
+    std::shared_ptr<const Schema> schema;
+    TableSnapshot rows;
+    std::vector<std::pair<std::string, size_t>> indexes;
+
+    void Save(SnapshotWriter& writer) const;
+};
+
+struct Index {
+    std::string name;
+    size_t column = 0;
+    BTree<Parameter, size_t> tree;
+};
+
+// Readers never lock a table: they pin its published generation and read it at a timestamp. Writers
+// hold the table lock, create new versions instead of changing rows and stamp them on commit. The
+// indexes only know the rows of the latest generation, so probing them needs the shared lock.
+class Table {
+private:
+    std::shared_ptr<Schema> schema_ = std::make_shared<Schema>();
+    std::shared_ptr<TableData> data_ = std::make_shared<TableData>(0);
+    std::unique_ptr<std::atomic<std::shared_ptr<const TableData>>> published_ =
+            std::make_unique<std::atomic<std::shared_ptr<const TableData>>>(data_);
+    size_t dead_ = 0;
+    size_t version_ = 0;
+    std::unique_ptr<std::shared_mutex> mutex_ = std::make_unique<std::shared_mutex>();
+    // Newest version of every key; the key is taken only while that version is live.
+    std::unordered_map<Parameter, size_t> primary_index_;
+    std::vector<Index> indexes_;
+    std::function<void(size_t, size_t)> commit_hook_;
+
+    [[nodiscard]] bool IsLive(size_t row) const {
+        return data_->end[row].load(std::memory_order_relaxed) == kInfinity;
+    }
+
+    void IndexPrimary();
+
+    void BuildIndex(Index& index);
+
+    void Touch();
+
+    void Publish(std::shared_ptr<TableData> data);
+
+    // Copies the latest generation into one with room for `capacity` versions; `rows` more versions with
+    // bytes[i] of string data in column i are about to be appended.
+    [[nodiscard]] std::shared_ptr<TableData> Copy(size_t capacity, size_t rows, const std::vector<size_t>& bytes) const;
 
-    Table() = default;
+    // Makes room for `rows` more versions with bytes[i] of string data in column i.
+    void Grow(size_t rows, const std::vector<size_t>& bytes);
 
-    explicit Table(const std::string& primary_key, const std::unordered_map<std::string, TYPE>& parameter_list) :
-    primary_key_(primary_key), parameter_list_(parameter_list) {}
+    // Takes the key of the pending version `row`, which replaces `replaced` when that is not kNullRow.
+    void IndexKey(size_t row, size_t replaced);
 
-    explicit Table(const std::unordered_map<std::string, TYPE>& parameter_list) :
-    parameter_list_(parameter_list) {}
+    // Takes the keys of the pending versions in [begin, end) back, returning them to the versions they
+    // replace, as in Stamp.
+    void UnindexKeys(size_t begin, size_t end, const std::vector<size_t>& ended, bool replace);
+
+    // Commits the pending versions below `size` and ends the `ended` ones; with `replace` the k-th
+    // pending version is the new version of ended[k]. The pending versions are dropped when their keys
+    // are taken or the commit hook throws.
+    void Stamp(size_t size, const std::vector<size_t>& ended, bool replace);
+
+    void AppendRows(const std::vector<Parameter>* rows, size_t count);
+
+public:
+
+    Table() {
+        Touch();
+    }
+
+    Schema& GetSchema() {
+        return *schema_;
+    }
 
     std::string& GetPrimary() {
-        return primary_key_;
+        return schema_->GetPrimary();
+    }
+
+    // Versions stored in the latest generation, including the ones no snapshot can see any more.
+    [[nodiscard]] size_t Size() const noexcept {
+        return data_->size.load(std::memory_order_relaxed);
     }
 
-    std::unordered_set<std::string>& GetNull() {
-        return null_parameters;
+    // Versions that ended and wait for Collect.
+    [[nodiscard]] size_t Garbage() const noexcept {
+        return dead_;
     }
 
-    std::unordered_map<std::string, TYPE>& GetParameters() {
-        return parameter_list_;
+    std::shared_mutex& Mutex() const {
+        return *mutex_;
     }
 
-    std::vector<Element>& GetElement() {
-        return elements_;
+    // Changes on every modification and is never shared by two tables.
+    [[nodiscard]] size_t Version() const noexcept {
+        return version_;
     }
 
-    std::vector<std::string>& GetOrder() {
-        return parameters_;
+    std::vector<Column>& GetColumns() {
+        return data_->columns;
     }
 
+    const Column& GetColumn(size_t ordinal) const {
+        return data_->columns[ordinal];
+    }
+
+    // Latest committed rows, for the writer holding the table lock.
+    [[nodiscard]] TableSnapshot Read() const {
+        return {data_, kLatest};
+    }
+
+    // Pins the tables at one timestamp that every one of them can still show.
+    static std::vector<TableSnapshot> Read(const std::vector<const Table*>& tables);
+
+    // `hook` is called with the range of pending versions of every change right before it commits, for
+    // the writer holding the table lock; when it throws, the change is undone.
+    void SetCommitHook(std::function<void(size_t, size_t)> hook) {
+        commit_hook_ = std::move(hook);
+    }
+
+    void AddColumn(const std::string& name, TYPE type, bool is_not_null);
+
+    void SetPrimary(const std::string& name);
+
+    // Live version with this key.
+    [[nodiscard]] std::optional<size_t> Find(const Parameter& key) const;
+
+    void CreateIndex(const std::string& name, size_t column);
+
+    bool DropIndex(const std::string& name);
+
+    [[nodiscard]] bool HasIndex(const std::string& name) const;
+
+    [[nodiscard]] const BTree<Parameter, size_t>* FindIndex(size_t column) const;
+
+    void Reserve(size_t rows);
+
+    void Append(const std::vector<Parameter>& row);
+
+    void Append(const std::vector<std::vector<Parameter>>& rows);
+
+    // Appends the rows staged in `columns`, one per column of the table.
+    void Append(std::vector<Column> columns);
+
+    // Replaces every row with a new version holding `values`, pairs of a column ordinal and its value.
+    void Update(const std::vector<size_t>& rows, const std::vector<std::pair<size_t, Parameter>>& values);
+
+    void Erase(const std::vector<size_t>& rows);
+
+    void Clear();
+
+    // Drops the versions no snapshot taken from now on can see.
+    void Collect();
+
+    [[nodiscard]] TableImage Image() const;
+
+    [[nodiscard]] TableImage Image(TableSnapshot rows) const;
+
+    static Table Load(SnapshotReader& reader);
+
+    [[nodiscard]] Element GetRow(size_t row) const;
+
+    // Latest committed rows.
+    [[nodiscard]] std::vector<Element> GetElement() const;
+
 };
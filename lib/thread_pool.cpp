@@ -0,0 +1,132 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace {
+
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+
+}
+
+size_t HardwareParallelism() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+ThreadPool::ThreadPool(size_t threads) : threads_(threads) {
+    for (size_t i = 0; i < threads_; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    stop_ = true;
+    pending_.release(static_cast<std::ptrdiff_t>(workers_.size()));
+    for (auto& i: workers_) {
+        i.join();
+    }
+}
+
+std::function<void()> ThreadPool::Take(size_t first) {
+    while (true) {
+        for (size_t i = 0; i < queues_.size(); ++i) {
+            Queue& queue = *queues_[(first + i) % queues_.size()];
+            std::lock_guard lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            std::function<void()> task;
+            if (i == 0) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            return task;
+        }
+        // The permit was taken before the task it stands for was found; someone else got there first.
+        std::this_thread::yield();
+    }
+}
+
+void ThreadPool::Work(size_t worker) {
+    current_pool = this;
+    current_worker = worker;
+    while (true) {
+        pending_.acquire();
+        if (stop_) {
+            return;
+        }
+        Take(worker)();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    if (threads_ == 0) {
+        task();
+        return;
+    }
+    std::call_once(started_, [this]() {
+        for (size_t i = 0; i < threads_; ++i) {
+            workers_.emplace_back(&ThreadPool::Work, this, i);
+        }
+    });
+    size_t queue = current_pool == this ? current_worker : next_queue_++ % queues_.size();
+    {
+        std::lock_guard lock(queues_[queue]->mutex);
+        queues_[queue]->tasks.push_back(std::move(task));
+    }
+    pending_.release();
+}
+
+bool ThreadPool::RunPending() {
+    if (threads_ == 0 || !pending_.try_acquire()) {
+        return false;
+    }
+    Take(current_pool == this ? current_worker : next_queue_++ % queues_.size())();
+    return true;
+}
+
+void ThreadPool::ForEach(size_t count, const std::function<void(size_t)>& body) {
+    struct State {
+        std::atomic<size_t> next = 0;
+        std::atomic<size_t> active = 0;
+        std::mutex mutex;
+        std::exception_ptr error;
+    };
+
+    auto state = std::make_shared<State>();
+    // A helper that starts after the last index was handed out returns without touching `body`, so
+    // the caller only waits for helpers that are still running.
+    auto run = [state, count, &body]() {
+        ++state->active;
+        for (size_t i = state->next++; i < count; i = state->next++) {
+            try {
+                body(i);
+            } catch (...) {
+                std::lock_guard lock(state->mutex);
+                if (!state->error) {
+                    state->error = std::current_exception();
+                }
+                state->next = count;
+            }
+        }
+        --state->active;
+    };
+
+    size_t helpers = std::min(threads_, count == 0 ? 0 : count - 1);
+    for (size_t i = 0; i < helpers; ++i) {
+        Submit(run);
+    }
+    run();
+    while (state->active != 0) {
+        if (!RunPending()) {
+            std::this_thread::yield();
+        }
+    }
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <thread>
+#include <vector>
+
+// Number of threads the hardware runs at once, at least one.
+[[nodiscard]] size_t HardwareParallelism();
+
+// Every worker has its own deque of tasks: it runs its newest task first and steals the oldest task of
+// another worker once its deque is empty. Workers are started by the first task.
+class ThreadPool {
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    size_t threads_;
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::once_flag started_;
+    // One permit per queued task, so a thread that acquires a permit always finds a task.
+    std::counting_semaphore<> pending_{0};
+    std::atomic<size_t> next_queue_ = 0;
+    std::atomic<bool> stop_ = false;
+
+    std::function<void()> Take(size_t first);
+
+    void Work(size_t worker);
+
+public:
+    explicit ThreadPool(size_t threads);
+
+    ThreadPool(const ThreadPool&) = delete;
+
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool();
+
+    [[nodiscard]] size_t Size() const noexcept {
+        return threads_;
+    }
+
+    // Tasks must not throw. Without workers the task runs on the calling thread.
+    void Submit(std::function<void()> task);
+
+    // Runs one queued task on the calling thread, if there is any.
+    bool RunPending();
+
+    // Calls `body` for every index below `count`, handing the indexes out one at a time to the calling
+    // thread and to every worker. Returns once all calls are done and rethrows the first error.
+    void ForEach(size_t count, const std::function<void(size_t)>& body);
+};
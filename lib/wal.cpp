@@ -0,0 +1,344 @@
+#include "wal.h"
+#include "mapped_file.h"
+
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char kLogMagic[8] = {'S', 'Q', 'L', 'W', 'A', 'L', '\0', '\0'};
+constexpr uint32_t kLogVersion = 3;
+constexpr size_t kHeaderSize = sizeof(kLogMagic) + sizeof(kLogVersion) + sizeof(uint64_t);
+constexpr size_t kRecordHeaderSize = 2 * sizeof(uint32_t);
+constexpr size_t kBufferLimit = 1 << 20;
+
+uint32_t Checksum(std::string_view data) {
+    uint32_t hash = 2166136261u;
+    for (char i: data) {
+        hash = (hash ^ static_cast<uint8_t>(i)) * 16777619u;
+    }
+    return hash;
+}
+
+template<typename T>
+T ReadValue(const char* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+template<typename T>
+void AppendValue(std::string& buffer, T value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+std::string Header(uint64_t base) {
+    std::string header(kLogMagic, sizeof(kLogMagic));
+    AppendValue(header, kLogVersion);
+    AppendValue(header, base);
+    return header;
+}
+
+#ifdef _WIN32
+int OpenFile(const std::string& path) {
+    return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_BINARY, 0644);
+}
+
+bool WriteFile(int descriptor, const char* data, size_t size) {
+    return _write(descriptor, data, static_cast<unsigned>(size)) == static_cast<int>(size);
+}
+
+bool SyncFile(int descriptor) {
+    return _commit(descriptor) == 0;
+}
+
+bool ResizeFile(int descriptor, size_t size) {
+    return _chsize_s(descriptor, static_cast<long long>(size)) == 0 && _lseeki64(descriptor, 0, SEEK_END) != -1;
+}
+
+void CloseFile(int descriptor) {
+    _close(descriptor);
+}
+#else
+int OpenFile(const std::string& path) {
+    return open(path.c_str(), O_WRONLY | O_CREAT, 0644);
+}
+
+bool WriteFile(int descriptor, const char* data, size_t size) {
+    while (size != 0) {
+        ssize_t written = write(descriptor, data, size);
+        if (written < 0) {
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool SyncFile(int descriptor) {
+#ifdef __linux__
+    return fdatasync(descriptor) == 0;
+#else
+    return fsync(descriptor) == 0;
+#endif
+}
+
+bool ResizeFile(int descriptor, size_t size) {
+    return ftruncate(descriptor, static_cast<off_t>(size)) == 0 && lseek(descriptor, 0, SEEK_END) != -1;
+}
+
+void CloseFile(int descriptor) {
+    close(descriptor);
+}
+#endif
+
+}
+
+void SyncPath(const std::string& path) {
+#ifdef _WIN32
+    if (std::filesystem::is_directory(path)) {
+        return;
+    }
+    int descriptor = _open(path.c_str(), _O_RDWR | _O_BINARY);
+#else
+    int descriptor = open(path.c_str(), O_RDONLY);
+#endif
+    if (descriptor == -1) {
+        throw std::runtime_error("Can not open file");
+    }
+#ifdef _WIN32
+    bool synced = _commit(descriptor) == 0;
+#else
+    bool synced = fsync(descriptor) == 0;
+#endif
+    CloseFile(descriptor);
+    if (!synced) {
+        throw std::runtime_error("Can not write file");
+    }
+}
+
+WriteAheadLog::WriteAheadLog(const std::string& path, WalOptions options, uint64_t base) :
+        path_(path), options_(options) {
+    std::string content;
+    if (std::filesystem::exists(path_)) {
+        MappedFile file(path_);
+        content = file.View().substr(0, kHeaderSize);
+        size_ = file.Size();
+    }
+    if (content.empty()) {
+        Create(base, {});
+    } else if (content.size() < kHeaderSize) {
+        throw std::runtime_error("Bad log");
+    } else {
+        if (std::memcmp(content.data(), kLogMagic, sizeof(kLogMagic)) != 0) {
+            throw std::runtime_error("Bad log");
+        }
+        if (ReadValue<uint32_t>(content.data() + sizeof(kLogMagic)) != kLogVersion) {
+            throw std::runtime_error("Unsupported log version");
+        }
+        base_ = ReadValue<uint64_t>(content.data() + sizeof(kLogMagic) + sizeof(kLogVersion));
+        Reopen();
+    }
+    if (options_.policy == SyncPolicy::INTERVAL) {
+        flusher_ = std::thread(&WriteAheadLog::Flusher, this);
+    }
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    if (flusher_.joinable()) {
+        flusher_.join();
+    }
+    try {
+        WriteLocked();
+        if (options_.policy != SyncPolicy::NONE) {
+            SyncLocked();
+        }
+    } catch (...) {
+    }
+    CloseFile(descriptor_);
+}
+
+void WriteAheadLog::Create(uint64_t base, std::string_view records) {
+    if (descriptor_ != -1) {
+        CloseFile(descriptor_);
+    }
+    std::string temporary = path_ + ".tmp";
+    descriptor_ = OpenFile(temporary);
+    std::string content = Header(base);
+    content += records;
+    if (descriptor_ == -1 || !ResizeFile(descriptor_, 0) || !WriteFile(descriptor_, content.data(), content.size()) ||
+        !SyncFile(descriptor_)) {
+        throw std::runtime_error("Can not write file");
+    }
+    CloseFile(descriptor_);
+    descriptor_ = -1;
+    std::filesystem::rename(temporary, path_);
+    SyncPath(std::filesystem::absolute(path_).parent_path().string());
+    base_ = base;
+    size_ = content.size();
+    Reopen();
+}
+
+void WriteAheadLog::Reopen() {
+    if (descriptor_ != -1) {
+        CloseFile(descriptor_);
+    }
+    descriptor_ = OpenFile(path_);
+    if (descriptor_ == -1 || !ResizeFile(descriptor_, size_)) {
+        throw std::runtime_error("Can not open file");
+    }
+}
+
+void WriteAheadLog::WriteLocked() {
+    if (buffer_.empty()) {
+        return;
+    }
+    if (!WriteFile(descriptor_, buffer_.data(), buffer_.size())) {
+        throw std::runtime_error("Can not write file");
+    }
+    buffer_.clear();
+}
+
+void WriteAheadLog::SyncLocked() {
+    if (!SyncFile(descriptor_)) {
+        throw std::runtime_error("Can not write file");
+    }
+    pending_ = 0;
+}
+
+void WriteAheadLog::Flusher() {
+    std::unique_lock lock(mutex_);
+    while (!stop_) {
+        wake_.wait_for(lock, options_.interval);
+        if (pending_ != 0) {
+            WriteLocked();
+            SyncLocked();
+        }
+    }
+}
+
+void WriteAheadLog::Replay(uint64_t from, const std::function<void(std::string_view)>& apply) {
+    {
+        std::lock_guard lock(mutex_);
+        if (from < base_) {
+            throw std::runtime_error("Bad log");
+        }
+        WriteLocked();
+    }
+    // `apply` runs without the lock, since it may take locks of its own that are held around Append.
+    size_t position = kHeaderSize;
+    {
+        MappedFile file(path_);
+        std::string_view data = file.View();
+        while (data.size() - position >= kRecordHeaderSize) {
+            auto size = ReadValue<uint32_t>(data.data() + position);
+            auto checksum = ReadValue<uint32_t>(data.data() + position + sizeof(uint32_t));
+            if (data.size() - position - kRecordHeaderSize < size) {
+                break;
+            }
+            std::string_view record = data.substr(position + kRecordHeaderSize, size);
+            if (Checksum(record) != checksum) {
+                break;
+            }
+            if (base_ + (position - kHeaderSize) >= from) {
+                apply(record);
+            }
+            position += kRecordHeaderSize + size;
+        }
+    }
+    std::lock_guard lock(mutex_);
+    if (base_ + (position - kHeaderSize) < from) {
+        Create(from, {});
+        return;
+    }
+    size_ = position;
+    Reopen();
+}
+
+void WriteAheadLog::Append(std::string_view record) {
+    if (record.size() > std::numeric_limits<uint32_t>::max()) {
+        throw std::logic_error("Record is too large");
+    }
+    std::lock_guard lock(mutex_);
+    size_t buffered = buffer_.size();
+    size_t written = size_ - buffered;
+    size_t size = size_;
+    AppendValue(buffer_, static_cast<uint32_t>(record.size()));
+    AppendValue(buffer_, Checksum(record));
+    buffer_.append(record);
+    size_ += kRecordHeaderSize + record.size();
+    ++pending_;
+    try {
+        switch (options_.policy) {
+            case SyncPolicy::STATEMENT:
+                WriteLocked();
+                SyncLocked();
+                break;
+            case SyncPolicy::RECORDS:
+                if (pending_ >= options_.records) {
+                    WriteLocked();
+                    SyncLocked();
+                }
+                break;
+            default:
+                if (buffer_.size() >= kBufferLimit) {
+                    WriteLocked();
+                }
+                break;
+        }
+    } catch (...) {
+        // The caller undoes the change, so the record must not reach the file later: whatever part of
+        // it was written is cut off, and the records before it stay.
+        if (buffer_.empty()) {
+            ResizeFile(descriptor_, size);
+        } else {
+            ResizeFile(descriptor_, written);
+            buffer_.resize(buffered);
+        }
+        size_ = size;
+        --pending_;
+        throw;
+    }
+}
+
+void WriteAheadLog::Sync() {
+    std::lock_guard lock(mutex_);
+    WriteLocked();
+    SyncLocked();
+}
+
+uint64_t WriteAheadLog::Position() {
+    std::lock_guard lock(mutex_);
+    return base_ + (size_ - kHeaderSize);
+}
+
+void WriteAheadLog::Truncate(uint64_t position) {
+    std::lock_guard lock(mutex_);
+    if (position <= base_) {
+        return;
+    }
+    WriteLocked();
+    SyncLocked();
+    std::string tail;
+    {
+        MappedFile file(path_);
+        tail = file.View().substr(kHeaderSize + (position - base_));
+    }
+    Create(position, tail);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+enum class SyncPolicy {
+    NONE,
+    STATEMENT,
+    RECORDS,
+    INTERVAL
+};
+
+struct WalOptions {
+    SyncPolicy policy = SyncPolicy::STATEMENT;
+    size_t records = 64;
+    std::chrono::milliseconds interval{10};
+};
+
+// Flushes a file or directory to stable storage.
+void SyncPath(const std::string& path);
+
+// Append-only log of length-prefixed, checksummed records behind a short versioned header.
+// Records are addressed by their position in the whole history of the log: the header keeps the
+// position of the first record in the file, so dropping a prefix does not renumber the rest.
+class WriteAheadLog {
+private:
+    std::string path_;
+    int descriptor_ = -1;
+    WalOptions options_;
+    uint64_t base_ = 0;
+    size_t size_ = 0;
+    std::string buffer_;
+    size_t pending_ = 0;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::thread flusher_;
+    bool stop_ = false;
+
+    // Atomically replaces the file with a header for `base` followed by `records`.
+    void Create(uint64_t base, std::string_view records);
+
+    void Reopen();
+
+    void WriteLocked();
+
+    void SyncLocked();
+
+    void Flusher();
+
+public:
+    // Opens the log at `path`; a missing log starts at position `base`.
+    WriteAheadLog(const std::string& path, WalOptions options, uint64_t base = 0);
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    ~WriteAheadLog();
+
+    // Calls `apply` for every intact record at or after position `from` and cuts off the rest of
+    // the file: a torn or corrupted tail is where a crash interrupted a write.
+    void Replay(uint64_t from, const std::function<void(std::string_view)>& apply);
+
+    // Leaves the log as it was when the record can not be written.
+    void Append(std::string_view record);
+
+    void Sync();
+
+    // Position right after the last appended record.
+    [[nodiscard]] uint64_t Position();
+
+    // Drops the records before `position`, which must be a record boundary.
+    void Truncate(uint64_t position);
+};
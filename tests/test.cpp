@@ -1,5 +1,23 @@
 #include <gtest/gtest.h>
 #include "lib/db.h"
+#include "lib/Parser.h"
+#include "lib/filter.h"
+#include "lib/formatter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <tuple>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/resource.h>
+#endif
 
 TEST(DataBase, CreateTableTest) {
     DataBase DataBase("Test");
@@ -59,7 +77,7 @@ TEST(DataBase, UpdateTest) {
     DataBase.Insert(sql_request1);
     sql_request1 = "UPDATE orders SET order_id = 228 WHERE supplier_id = 0;";
     DataBase.UpdateRequest(sql_request1);
-    ASSERT_EQ(DataBase.GetTables()["orders"].GetElement()[0]["order_id"].GetValue<int>(), 228);
+    ASSERT_EQ(DataBase.GetTables()["orders"].GetElement()[1]["order_id"].GetValue<int>(), 228);
 }
 
 TEST(DataBase, DeleteTest) {
@@ -76,3 +94,1331 @@ TEST(DataBase, DeleteTest) {
     ASSERT_EQ(DataBase.GetTables()["orders"].GetElement()[0]["order_id"].GetValue<int>(), 126);
 }
 
+TEST(Parser, SelectWithJoinAndWhereTest) {
+    Statement statement = Parser("SELECT suppliers.supplier_name, orders.order_date FROM suppliers LEFT JOIN orders "
+                                 "ON suppliers.supplier_id = orders.supplier_id WHERE order_date = \"05.05.2015\" "
+                                 "OR (order_id > 1 AND order_id <= -2);").Parse();
+    auto& select = std::get<SelectStatement>(statement);
+    ASSERT_EQ(select.columns.size(), 2);
+    ASSERT_EQ(select.columns[0].table, "suppliers");
+    ASSERT_EQ(select.columns[1].column, "order_date");
+    ASSERT_EQ(select.join->type, JoinType::LEFT);
+    ASSERT_EQ(select.join->table, "orders");
+    ASSERT_EQ(select.where->kind, Condition::Kind::OR);
+    ASSERT_EQ(select.where->children[0].right.literal.value.GetValue<std::string>(), "05.05.2015");
+    ASSERT_EQ(select.where->children[1].kind, Condition::Kind::AND);
+    ASSERT_EQ(select.where->children[1].children[1].sign, CompareOperator::LESS_EQUAL);
+    ASSERT_EQ(select.where->children[1].children[1].right.literal.value.GetValue<int>(), -2);
+}
+
+TEST(Parser, SyntaxErrorTest) {
+    ASSERT_THROW(Parser("SELECT * FROM;").Parse(), std::runtime_error);
+    ASSERT_THROW(Parser("INSERT INTO orders VALUES (1, \"x);").Parse(), std::runtime_error);
+    ASSERT_THROW(Parser("CREATE TABLE orders (order_id TEXT);").Parse(), std::runtime_error);
+}
+
+TEST(DataBase, SelectWithJoinTest) {
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE suppliers (supplier_id INT PRIMARY KEY NOT NULL, supplier_name VARCHAR(20));");
+    DataBase.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, supplier_id INT NOT NULL, order_date VARCHAR(20));");
+    DataBase.Insert("INSERT INTO suppliers VALUES (0, \"IBM\");");
+    DataBase.Insert("INSERT INTO suppliers VALUES (1, \"HP\");");
+    DataBase.Insert("INSERT INTO orders VALUES (125, 0, \"05.05.2015\");");
+
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT suppliers.supplier_name, orders.order_date FROM suppliers LEFT JOIN orders "
+                           "ON suppliers.supplier_id = orders.supplier_id;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "IBM 05.05.2015 \nHP NULL \n");
+}
+
+TEST(DataBase, SelectWithWhereTest) {
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, supplier_id INT NOT NULL, order_date VARCHAR(20));");
+    DataBase.Insert("INSERT INTO orders VALUES (125, 0, \"05.05.2015\");");
+    DataBase.Insert("INSERT INTO orders VALUES (126, 1, \"08.02.2016\");");
+    DataBase.Insert("INSERT INTO orders VALUES (127, 4, \"06.01.2017\");");
+
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT order_id FROM orders WHERE (supplier_id = 0 OR supplier_id > 3) AND 1 < 2;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "125 \n127 \n");
+
+    ASSERT_THROW(DataBase.SelectRequest("SELECT * FROM orders WHERE order_id = \"126\";"), std::logic_error);
+    ASSERT_THROW(DataBase.SelectRequest("SELECT * FROM orders WHERE price = 1;"), std::logic_error);
+}
+
+TEST(DataBase, PreparedStatementTest) {
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, supplier_id INT NOT NULL, order_date VARCHAR(20), price DOUBLE);");
+
+    PreparedStatement insert = DataBase.Prepare("INSERT INTO orders VALUES (?, ?, ?, ?);");
+    ASSERT_EQ(insert.ParameterCount(), 4);
+    for (int i = 0; i < 3; ++i) {
+        insert.Bind(0, 125 + i);
+        insert.Bind(1, i);
+        insert.Bind(2, "05.05.2015");
+        insert.Bind(3, 10 * i);
+        insert.Execute();
+    }
+    ASSERT_EQ(DataBase.GetTables()["orders"].GetElement().size(), 3);
+    ASSERT_EQ(DataBase.GetTables()["orders"].GetElement()[2]["price"].GetValue<double>(), 20.0);
+    ASSERT_THROW(insert.Bind(0, "126"), std::logic_error);
+    ASSERT_THROW(insert.Bind(4, 1), std::logic_error);
+
+    PreparedStatement update = DataBase.Prepare("UPDATE orders SET order_date = ? WHERE order_id = ?;");
+    update.Bind(0, "08.02.2016");
+    update.Bind(1, 126);
+    update.Execute();
+    ASSERT_EQ(DataBase.GetTables()["orders"].GetElement()[2]["order_date"].GetValue<std::string>(), "08.02.2016");
+
+    PreparedStatement select = DataBase.Prepare("SELECT order_id FROM orders WHERE supplier_id > ?;");
+    ASSERT_THROW(select.Execute(), std::logic_error);
+    select.Bind(0, 0);
+    testing::internal::CaptureStdout();
+    select.Execute().Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "127 \n126 \n");
+}
+
+TEST(DataBase, PreparedStatementInvalidationTest) {
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, price INT);");
+    PreparedStatement insert = DataBase.Prepare("INSERT INTO orders VALUES (?, ?);");
+    insert.Bind(0, 1);
+    insert.Bind(1, 100);
+    insert.Execute();
+
+    DataBase.DropTable("DROP TABLE orders;");
+    ASSERT_THROW(insert.Execute(), std::logic_error);
+
+    DataBase.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, price DOUBLE);");
+    insert.Execute();
+    ASSERT_EQ(DataBase.GetTables()["orders"].GetElement().size(), 1);
+    ASSERT_EQ(DataBase.GetTables()["orders"].GetElement()[0]["price"].GetValue<double>(), 100.0);
+}
+
+TEST(DataBase, SchemaOrdinalTest) {
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, supplier_id INT NOT NULL, order_date VARCHAR(20));");
+    DataBase.Insert("INSERT INTO orders (order_date, supplier_id, order_id) VALUES (\"05.05.2015\", 0, 125);");
+
+    Table& table = DataBase.GetTables()["orders"];
+    ASSERT_EQ(table.GetSchema().Size(), 3);
+    ASSERT_EQ(table.GetSchema().Ordinal("order_date"), 2);
+    ASSERT_EQ(table.GetSchema().Type(1), TYPE::INT);
+    ASSERT_EQ(&table.GetElement()[0].GetSchema(), &table.GetSchema());
+    ASSERT_EQ(table.GetElement()[0][0].GetValue<int>(), 125);
+    ASSERT_EQ(table.GetElement()[0]["order_date"].GetValue<std::string>(), "05.05.2015");
+    ASSERT_THROW(table.GetElement()[0]["price"], std::logic_error);
+    ASSERT_THROW(DataBase.CreateTable("CREATE TABLE items (id INT, id DOUBLE);"), std::logic_error);
+}
+
+TEST(DataBase, ColumnarStorageTest) {
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, paid BOOL, order_date VARCHAR(20), price FLOAT);");
+    for (int i = 0; i < 100; ++i) {
+        DataBase.Insert("INSERT INTO orders VALUES (" + std::to_string(i) + ", " + (i % 3 == 0 ? "true" : "false") +
+                        ", \"" + std::to_string(i) + "\", " + (i % 2 == 0 ? "1.5" : "NULL") + ");");
+    }
+    DataBase.UpdateRequest("UPDATE orders SET order_date = \"updated\" WHERE order_id < 10;");
+    DataBase.DeleteRequest("DELETE FROM orders WHERE paid = false;");
+    DataBase.CollectGarbage();
+
+    Table& table = DataBase.GetTables()["orders"];
+    ASSERT_EQ(table.Size(), 34);
+    ASSERT_EQ(table.GetColumn(0).Value<int>(33), 9);
+    ASSERT_EQ(table.GetColumn(2).Value<std::string_view>(33), "updated");
+    ASSERT_EQ(table.GetColumn(2).Value<std::string_view>(0), "12");
+    ASSERT_TRUE(table.GetColumn(1).Value<bool>(33));
+    ASSERT_TRUE(table.GetColumn(3).IsNull(1));
+    ASSERT_EQ(table.GetElement()[2]["price"].GetValue<float>(), 1.5f);
+
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT order_id, order_date FROM orders WHERE price > 1 AND order_id > 80;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "84 84 \n90 90 \n96 96 \n");
+}
+
+TEST(DataBase, PrimaryKeyIndexTest) {
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, supplier_id INT NOT NULL, order_date VARCHAR(20));");
+    for (int i = 0; i < 1000; ++i) {
+        DataBase.Insert("INSERT INTO orders VALUES (" + std::to_string(i) + ", " + std::to_string(i % 10) + ", \"05.05.2015\");");
+    }
+    ASSERT_THROW(DataBase.Insert("INSERT INTO orders VALUES (10, 0, \"05.05.2015\");"), std::logic_error);
+    ASSERT_THROW(DataBase.UpdateRequest("UPDATE orders SET order_date = \"x\", order_id = 11 WHERE order_id = 12;"), std::logic_error);
+    ASSERT_THROW(DataBase.UpdateRequest("UPDATE orders SET order_id = 2000 WHERE supplier_id = 1;"), std::logic_error);
+    ASSERT_EQ(DataBase.GetTables()["orders"].GetElement()[12]["order_date"].GetValue<std::string>(), "05.05.2015");
+
+    DataBase.DeleteRequest("DELETE FROM orders WHERE order_id < 500;");
+    DataBase.UpdateRequest("UPDATE orders SET order_id = 5000 WHERE order_id = 700;");
+    DataBase.CollectGarbage();
+    ASSERT_EQ(DataBase.GetTables()["orders"].Find(Parameter(5000)), 499);
+    ASSERT_FALSE(DataBase.GetTables()["orders"].Find(Parameter(700)).has_value());
+
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT * FROM orders WHERE order_id = 5000 AND supplier_id = 0;").Print();
+    DataBase.SelectRequest("SELECT order_id FROM orders WHERE supplier_id = 1 AND order_id = 701;").Print();
+    DataBase.SelectRequest("SELECT order_id FROM orders WHERE order_id = 100;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "5000 0 05.05.2015 \n701 \n");
+}
+
+TEST(DataBase, OrderedIndexTest) {
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, supplier_id INT, price DOUBLE);");
+    PreparedStatement insert = DataBase.Prepare("INSERT INTO orders VALUES (?, ?, ?);");
+    for (int i = 0; i < 5000; ++i) {
+        insert.Bind(0, i);
+        insert.Bind(1, (i * 7919) % 1000);
+        insert.Bind(2, i % 10 == 0 ? Parameter() : Parameter(i * 0.5));
+        insert.Execute();
+    }
+    DataBase.CreateIndex("CREATE INDEX orders_supplier ON orders(supplier_id);");
+    DataBase.CreateIndex("CREATE INDEX orders_price ON orders (price);");
+    ASSERT_THROW(DataBase.CreateIndex("CREATE INDEX orders_price ON orders (supplier_id);"), std::logic_error);
+    ASSERT_EQ(DataBase.GetTables()["orders"].FindIndex(1)->Size(), 5000);
+    ASSERT_EQ(DataBase.GetTables()["orders"].FindIndex(2)->Size(), 4500);
+
+    DataBase.UpdateRequest("UPDATE orders SET supplier_id = 15 WHERE order_id < 100 AND supplier_id < 500;");
+    DataBase.DeleteRequest("DELETE FROM orders WHERE supplier_id >= 990;");
+    DataBase.Insert("INSERT INTO orders VALUES (9000, 12, 1.0);");
+
+    std::string expected;
+    for (auto& i: DataBase.GetTables()["orders"].GetElement()) {
+        int supplier = i["supplier_id"].GetValue<int>();
+        if (supplier > 10 && supplier <= 20 && i["order_id"].GetValue<int>() != 4000) {
+            expected += std::to_string(i["order_id"].GetValue<int>()) + " \n";
+        }
+    }
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT order_id FROM orders WHERE 10 < supplier_id AND supplier_id <= 20 AND order_id != 4000;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), expected);
+
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT order_id FROM orders WHERE price >= 2499 AND price < 2500;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "4998 \n4999 \n");
+
+    DataBase.DropIndex("DROP INDEX orders_price;");
+    ASSERT_EQ(DataBase.GetTables()["orders"].FindIndex(2), nullptr);
+    ASSERT_THROW(DataBase.DropIndex("DROP INDEX orders_price;"), std::logic_error);
+}
+
+TEST(DataBase, HashJoinTest) {
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE suppliers (supplier_id INT PRIMARY KEY NOT NULL, supplier_name VARCHAR(20));");
+    DataBase.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, supplier_id INT);");
+    DataBase.Insert("INSERT INTO suppliers VALUES (0, \"IBM\");");
+    DataBase.Insert("INSERT INTO suppliers VALUES (1, \"HP\");");
+    DataBase.Insert("INSERT INTO suppliers VALUES (2, \"Dell\");");
+    DataBase.Insert("INSERT INTO orders VALUES (125, 0);");
+    DataBase.Insert("INSERT INTO orders VALUES (126, 0);");
+    DataBase.Insert("INSERT INTO orders VALUES (127, 5);");
+    DataBase.Insert("INSERT INTO orders VALUES (128, NULL);");
+
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT supplier_name, order_id FROM suppliers INNER JOIN orders ON suppliers.supplier_id = orders.supplier_id;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "IBM 125 \nIBM 126 \n");
+
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT supplier_name, order_id FROM suppliers LEFT JOIN orders ON orders.supplier_id = suppliers.supplier_id;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "IBM 125 \nIBM 126 \nHP NULL \nDell NULL \n");
+
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT supplier_name, order_id FROM suppliers RIGHT JOIN orders ON suppliers.supplier_id = orders.supplier_id;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "IBM 125 \nIBM 126 \nNULL 127 \nNULL 128 \n");
+
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT order_id, supplier_name FROM orders LEFT JOIN suppliers ON orders.supplier_id = suppliers.supplier_id "
+                           "WHERE order_id > 125;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "126 IBM \n127 NULL \n128 NULL \n");
+}
+
+TEST(DataBase, MergeJoinTest) {
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE a (x INT);");
+    DataBase.CreateTable("CREATE TABLE b (y INT);");
+    for (auto value: {"3", "1", "NULL", "5"}) {
+        DataBase.Insert(std::string("INSERT INTO a VALUES (") + value + ");");
+    }
+    for (auto value: {"2", "4", "4", "NULL"}) {
+        DataBase.Insert(std::string("INSERT INTO b VALUES (") + value + ");");
+    }
+
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT x, y FROM a LEFT JOIN b ON a.x < b.y;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "1 2 \n1 4 \n1 4 \n3 4 \n3 4 \n5 NULL \nNULL NULL \n");
+
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT x, y FROM a RIGHT JOIN b ON b.y > a.x;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "1 2 \n1 4 \n3 4 \n1 4 \n3 4 \nNULL NULL \n");
+
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT x, y FROM a INNER JOIN b ON a.x >= b.y;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "3 2 \n5 2 \n5 4 \n5 4 \n");
+
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT x, y FROM a JOIN b ON a.x <= b.y WHERE y = 2;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "1 2 \n");
+}
+
+TEST(DataBase, ResultSetTest) {
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE suppliers (supplier_id INT PRIMARY KEY NOT NULL, supplier_name VARCHAR(20));");
+    DataBase.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, supplier_id INT NOT NULL, price DOUBLE);");
+    DataBase.Insert("INSERT INTO suppliers VALUES (0, \"IBM\");");
+    DataBase.Insert("INSERT INTO suppliers VALUES (1, \"HP\");");
+    DataBase.Insert("INSERT INTO orders VALUES (125, 0, 10.5);");
+    DataBase.Insert("INSERT INTO orders VALUES (126, 0, NULL);");
+
+    ResultSet result = DataBase.SelectRequest("SELECT price, order_id FROM orders WHERE supplier_id = 0;");
+    ASSERT_EQ(result.GetColumns().size(), 2);
+    ASSERT_EQ(result.GetColumns()[0].name, "order_id");
+    ASSERT_EQ(result.GetColumns()[1].type, TYPE::DOUBLE);
+    ASSERT_TRUE(result.Next());
+    ASSERT_EQ(result.Get<int>(0), 125);
+    ASSERT_EQ(result.Get<double>(1), 10.5);
+    ASSERT_TRUE(result.Next());
+    ASSERT_TRUE(result.IsNull(1));
+    ASSERT_EQ(result.GetParameter(1).Type(), TYPE::NONE);
+    ASSERT_FALSE(result.Next());
+    ASSERT_FALSE(result.Next());
+
+    ResultSet join = DataBase.SelectRequest("SELECT supplier_name, order_id FROM suppliers LEFT JOIN orders "
+                                            "ON suppliers.supplier_id = orders.supplier_id;");
+    std::vector<std::string> names;
+    while (join.Next()) {
+        names.emplace_back(join.Get<std::string_view>(0));
+        if (join.IsNull(1)) {
+            names.back() += " NULL";
+        }
+    }
+    ASSERT_EQ(names, std::vector<std::string>({"IBM", "IBM", "HP NULL"}));
+
+    PreparedStatement select = DataBase.Prepare("SELECT order_id FROM orders WHERE order_id > ?;");
+    select.Bind(0, 125);
+    ResultSet first = select.Execute();
+    select.Bind(0, 0);
+    ResultSet second = select.Execute();
+    size_t first_count = 0;
+    size_t second_count = 0;
+    while (first.Next()) {
+        ++first_count;
+    }
+    while (second.Next()) {
+        ++second_count;
+    }
+    ASSERT_EQ(first_count, 1);
+    ASSERT_EQ(second_count, 2);
+}
+
+TEST(DataBase, FormatterTest) {
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE items (id INT PRIMARY KEY NOT NULL, name VARCHAR(20), price DOUBLE, sale BOOL);");
+    PreparedStatement insert = DataBase.Prepare("INSERT INTO items VALUES (1, ?, 10.25, TRUE);");
+    insert.Bind(0, "a,\"b");
+    insert.Execute();
+    DataBase.Insert("INSERT INTO items VALUES (2, NULL, 0.1, FALSE);");
+
+    std::ostringstream text;
+    ResultSet text_result = DataBase.SelectRequest("SELECT * FROM items;");
+    Write(text_result, text);
+    ASSERT_EQ(text.str(), "1 a,\"b 10.25 1 \n2 NULL 0.1 0 \n");
+
+    std::ostringstream csv;
+    ResultSet csv_result = DataBase.SelectRequest("SELECT * FROM items;");
+    Write(csv_result, csv, Format::CSV);
+    ASSERT_EQ(csv.str(), "id,name,price,sale\n1,\"a,\"\"b\",10.25,true\n2,,0.1,false\n");
+
+    std::ostringstream binary;
+    ResultSet binary_result = DataBase.SelectRequest("SELECT id, name FROM items;");
+    Write(binary_result, binary, Format::BINARY);
+    std::string expected;
+    auto append = [&expected](const auto& value) {
+        expected.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    append(uint32_t{2});
+    expected += static_cast<char>(TYPE::INT);
+    append(uint32_t{2});
+    expected += "id";
+    expected += static_cast<char>(TYPE::STRING);
+    append(uint32_t{4});
+    expected += "name";
+    expected += std::string("\1\0", 2);
+    append(1);
+    append(uint32_t{4});
+    expected += "a,\"b";
+    expected += std::string("\1\2", 2);
+    append(2);
+    expected += '\0';
+    ASSERT_EQ(binary.str(), expected);
+}
+
+TEST(DataBase, MultiRowInsertTest) {
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, supplier_id INT NOT NULL, price DOUBLE);");
+    DataBase.CreateIndex("CREATE INDEX orders_supplier ON orders(supplier_id);");
+    DataBase.Insert("INSERT INTO orders VALUES (1, 10, 1.5), (2, 20, NULL), (3, 10, 2);");
+    DataBase.Insert("INSERT INTO orders (supplier_id, order_id) VALUES (30, 4), (30, 5);");
+    ASSERT_EQ(DataBase.GetTables()["orders"].Size(), 5);
+
+    ASSERT_THROW(DataBase.Insert("INSERT INTO orders VALUES (6, 10, 1.0), (6, 20, 2.0);"), std::logic_error);
+    ASSERT_THROW(DataBase.Insert("INSERT INTO orders VALUES (7, 10, 1.0), (1, 20, 2.0);"), std::logic_error);
+    ASSERT_THROW(DataBase.Insert("INSERT INTO orders VALUES (8, 10, 1.0), (9, NULL, 2.0);"), std::logic_error);
+    ASSERT_THROW(DataBase.Insert("INSERT INTO orders VALUES (8, 10, 1.0), (9, 20);"), std::logic_error);
+    ASSERT_EQ(DataBase.GetTables()["orders"].Size(), 5);
+
+    PreparedStatement insert = DataBase.Prepare("INSERT INTO orders VALUES (?, ?, 0.5), (?, 40, ?);");
+    insert.Bind(0, 7);
+    insert.Bind(1, 40);
+    insert.Bind(2, 8);
+    insert.Bind(3, 3);
+    insert.Execute();
+
+    std::vector<std::vector<Parameter>> rows;
+    for (int i = 100; i < 200; ++i) {
+        rows.push_back({Parameter(i), Parameter(i % 3 == 0 ? 10 : 50), Parameter(i)});
+    }
+    DataBase.BulkInsert("orders", rows);
+    ASSERT_THROW(DataBase.BulkInsert("orders", {{Parameter(1), Parameter(10), Parameter()}}), std::logic_error);
+    ASSERT_THROW(DataBase.BulkInsert("orders", {{Parameter(300), Parameter(), Parameter()}}), std::logic_error);
+    ASSERT_THROW(DataBase.BulkInsert("orders", {{Parameter(300), Parameter(10)}}), std::logic_error);
+    ASSERT_EQ(DataBase.GetTables()["orders"].Size(), 107);
+
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT * FROM orders WHERE supplier_id = 40 OR order_id = 102;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "7 40 0.5 \n8 40 3 \n102 10 102 \n");
+
+    size_t count = 0;
+    ResultSet result = DataBase.SelectRequest("SELECT order_id FROM orders WHERE supplier_id = 10;");
+    while (result.Next()) {
+        ++count;
+    }
+    ASSERT_EQ(count, 35);
+}
+
+TEST(DataBase, CopyTest) {
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, comment VARCHAR(20), price DOUBLE, "
+                         "paid BOOL, weight FLOAT);");
+    DataBase.CreateIndex("CREATE INDEX orders_price ON orders(price);");
+    std::string input = testing::TempDir() + "copy_input.csv";
+    std::string output = testing::TempDir() + "copy_output.csv";
+    std::ofstream(input, std::ios::binary) << "price,order_id,comment,paid\r\n"
+                                              "1.5,1,plain,true\r\n"
+                                              "2,2,\"a,\"\"b\"\"\",0\n"
+                                              ",3,,1\n"
+                                              "\n"
+                                              "0.1,4,\"\",FALSE";
+    DataBase.Copy("COPY orders FROM '" + input + "';");
+    ASSERT_EQ(DataBase.GetTables()["orders"].Size(), 4);
+
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT * FROM orders;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(),
+              "1 plain 1.5 1 NULL \n2 a,\"b\" 2 0 NULL \n3 NULL NULL 1 NULL \n4  0.1 0 NULL \n");
+
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT order_id FROM orders WHERE price < 1.6;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "1 \n4 \n");
+
+    std::ofstream(input, std::ios::binary) << "order_id,price\n5,1\n6,x\n";
+    ASSERT_THROW(DataBase.Copy("COPY orders FROM '" + input + "';"), std::logic_error);
+    std::ofstream(input, std::ios::binary) << "order_id,price\n5,1\n1,2\n";
+    ASSERT_THROW(DataBase.Copy("COPY orders FROM '" + input + "';"), std::logic_error);
+    std::ofstream(input, std::ios::binary) << "order_id,price\n5,1\n,2\n";
+    ASSERT_THROW(DataBase.Copy("COPY orders FROM '" + input + "';"), std::logic_error);
+    std::ofstream(input, std::ios::binary) << "price\n1\n";
+    ASSERT_THROW(DataBase.Copy("COPY orders FROM '" + input + "';"), std::logic_error);
+    ASSERT_THROW(DataBase.Copy("COPY orders FROM '" + testing::TempDir() + "missing.csv';"), std::runtime_error);
+    ASSERT_EQ(DataBase.GetTables()["orders"].Size(), 4);
+
+    DataBase.Copy("COPY orders TO '" + output + "';");
+    DataBase.CreateTable("CREATE TABLE copy (order_id INT PRIMARY KEY NOT NULL, comment VARCHAR(20), price DOUBLE, "
+                         "paid BOOL, weight FLOAT);");
+    DataBase.Copy("COPY copy FROM '" + output + "';");
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT * FROM copy;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(),
+              "1 plain 1.5 1 NULL \n2 a,\"b\" 2 0 NULL \n3 NULL NULL 1 NULL \n4  0.1 0 NULL \n");
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+}
+
+TEST(DataBase, SnapshotTest) {
+    std::string path = testing::TempDir() + "snapshot.db";
+    {
+        DataBase DataBase("Test");
+        DataBase.CreateTable("CREATE TABLE suppliers (supplier_id INT PRIMARY KEY NOT NULL, supplier_name VARCHAR(20));");
+        DataBase.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, supplier_id INT, price DOUBLE, "
+                             "weight FLOAT, paid BOOL, comment VARCHAR(20));");
+        DataBase.CreateIndex("CREATE INDEX orders_price ON orders(price);");
+        DataBase.Insert("INSERT INTO suppliers VALUES (0, \"IBM\"), (1, \"\");");
+        for (int i = 0; i < 100; ++i) {
+            DataBase.BulkInsert("orders", {{Parameter(i), i % 7 == 0 ? Parameter() : Parameter(i % 2),
+                                            Parameter(i * 1.5), Parameter(0.25f), Parameter(i % 3 == 0),
+                                            i % 5 == 0 ? Parameter() : Parameter("order " + std::to_string(i))}});
+        }
+        DataBase.Save(path);
+    }
+
+    DataBase DataBase;
+    DataBase.CreateTable("CREATE TABLE stale (id INT);");
+    DataBase.Load(path);
+    ASSERT_EQ(DataBase.Size(), 2);
+    ASSERT_EQ(DataBase.GetTables()["orders"].Size(), 100);
+    TableSnapshot loaded = DataBase.GetTables()["orders"].Read();
+    const Column& comments = loaded.GetColumn(5);
+    ASSERT_EQ(comments.Entries(), 81);
+    ASSERT_EQ(comments.Find("order 98"), comments.Code(98));
+
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT * FROM orders WHERE price >= 147 OR order_id = 5;").Print();
+    DataBase.SelectRequest("SELECT * FROM suppliers;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "5 1 7.5 0.25 0 NULL \n98 NULL 147 0.25 0 order 98 \n"
+                                                      "99 1 148.5 0.25 1 order 99 \n0 IBM \n1  \n");
+    ASSERT_THROW(DataBase.Insert("INSERT INTO orders (order_id) VALUES (10);"), std::logic_error);
+    ASSERT_THROW(DataBase.CreateIndex("CREATE INDEX orders_price ON orders(price);"), std::logic_error);
+    DataBase.Insert("INSERT INTO orders (order_id, price, comment) VALUES (100, 200, \"order 98\");");
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT order_id FROM orders WHERE price > 148;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "99 \n100 \n");
+    TableSnapshot inserted = DataBase.GetTables()["orders"].Read();
+    const Column& appended = inserted.GetColumn(5);
+    ASSERT_EQ(appended.Entries(), 81);
+    ASSERT_EQ(appended.Code(100), appended.Code(98));
+
+    std::ofstream(path, std::ios::binary) << "SQLSNAP";
+    ASSERT_THROW(DataBase.Load(path), std::runtime_error);
+    ASSERT_EQ(DataBase.GetTables()["orders"].Size(), 101);
+    std::remove(path.c_str());
+}
+
+TEST(DataBase, WriteAheadLogTest) {
+    std::string path = testing::TempDir() + "wal.log";
+    std::string input = testing::TempDir() + "wal_input.csv";
+    std::remove(path.c_str());
+    std::string expected = "1 IBM 10 \n3 Dell 40 \n4 HP 50 \n5 NULL 60 \n";
+    {
+        DataBase DataBase("Test");
+        DataBase.OpenLog(path);
+        DataBase.CreateTable("CREATE TABLE suppliers (supplier_id INT PRIMARY KEY NOT NULL, supplier_name VARCHAR(20), "
+                             "rating DOUBLE);");
+        DataBase.CreateTable("CREATE TABLE stale (id INT);");
+        DataBase.DropTable("DROP TABLE stale;");
+        DataBase.Insert("INSERT INTO suppliers VALUES (0, \"Acme\", 1), (1, \"IBM\", 2);");
+        ASSERT_THROW(DataBase.Insert("INSERT INTO suppliers VALUES (1, \"Copy\", 3);"), std::logic_error);
+        PreparedStatement insert = DataBase.Prepare("INSERT INTO suppliers VALUES (?, ?, ?);");
+        insert.Bind(0, 2);
+        insert.Bind(1, "Sun");
+        insert.Bind(2, 3);
+        insert.Execute();
+        DataBase.BulkInsert("suppliers", {{Parameter(3), Parameter(std::string("Dell")), Parameter(4.0)}});
+        std::ofstream(input, std::ios::binary) << "supplier_id,supplier_name,rating\n4,HP,5\n5,,6\n";
+        DataBase.Copy("COPY suppliers FROM '" + input + "';");
+        DataBase.DeleteRequest("DELETE FROM suppliers WHERE supplier_id = 0;");
+        PreparedStatement remove = DataBase.Prepare("DELETE FROM suppliers WHERE supplier_name = ?;");
+        remove.Bind(0, "Sun");
+        remove.Execute();
+        DataBase.UpdateRequest("UPDATE suppliers SET rating = 1 WHERE supplier_id > 100;");
+        DataBase.UpdateRequest("UPDATE suppliers SET rating = 10 WHERE supplier_id = 1;");
+        PreparedStatement update = DataBase.Prepare("UPDATE suppliers SET rating = ? WHERE supplier_id >= 3;");
+        update.Bind(0, 20);
+        update.Execute();
+        DataBase.UpdateRequest("UPDATE suppliers SET rating = 40 WHERE supplier_id = 3;");
+        DataBase.UpdateRequest("UPDATE suppliers SET rating = 50 WHERE supplier_id = 4;");
+        DataBase.UpdateRequest("UPDATE suppliers SET rating = 60 WHERE supplier_id = 5;");
+        testing::internal::CaptureStdout();
+        DataBase.SelectRequest("SELECT * FROM suppliers;").Print();
+        ASSERT_EQ(testing::internal::GetCapturedStdout(), expected);
+    }
+    std::remove(input.c_str());
+    std::ofstream(path, std::ios::binary | std::ios::app) << std::string("\x10\0\0\0torn", 8);
+
+    DataBase DataBase("Test");
+    DataBase.OpenLog(path, {SyncPolicy::RECORDS, 2});
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT * FROM suppliers;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), expected);
+
+    DataBase.Insert("INSERT INTO suppliers VALUES (6, \"Sun\", 70);");
+    DataBase.CloseLog();
+    class DataBase replayed("Test");
+    replayed.OpenLog(path, {SyncPolicy::INTERVAL, 0, std::chrono::milliseconds(1)});
+    testing::internal::CaptureStdout();
+    replayed.SelectRequest("SELECT * FROM suppliers;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), expected + "6 Sun 70 \n");
+    replayed.CloseLog();
+    std::remove(path.c_str());
+
+    std::string snapshot = testing::TempDir() + "wal_snapshot.db";
+    replayed.Save(snapshot);
+    {
+        class DataBase loaded;
+        loaded.OpenLog(path);
+        loaded.Load(snapshot);
+        loaded.Insert("INSERT INTO suppliers VALUES (7, \"Intel\", 80);");
+    }
+    std::remove(snapshot.c_str());
+    class DataBase restored;
+    restored.OpenLog(path);
+    testing::internal::CaptureStdout();
+    restored.SelectRequest("SELECT * FROM suppliers;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), expected + "6 Sun 70 \n7 Intel 80 \n");
+    ASSERT_THROW(restored.Insert("INSERT INTO suppliers VALUES (7, \"Copy\", 1);"), std::logic_error);
+    restored.CloseLog();
+    std::remove(path.c_str());
+}
+
+TEST(DataBase, WriteAheadLogFailureTest) {
+#ifdef _WIN32
+    GTEST_SKIP();
+#else
+    std::string path = testing::TempDir() + "wal_failure.log";
+    std::remove(path.c_str());
+    auto print = [](class DataBase& data_base) {
+        testing::internal::CaptureStdout();
+        data_base.SelectRequest("SELECT * FROM suppliers;").Print();
+        return testing::internal::GetCapturedStdout();
+    };
+    DataBase DataBase("Test");
+    DataBase.OpenLog(path);
+    DataBase.CreateTable("CREATE TABLE suppliers (supplier_id INT PRIMARY KEY NOT NULL, supplier_name VARCHAR(20));");
+    DataBase.CreateIndex("CREATE INDEX suppliers_name ON suppliers(supplier_name);");
+    DataBase.Insert("INSERT INTO suppliers VALUES (1, \"IBM\"), (2, \"HP\");");
+    std::string expected = print(DataBase);
+
+    // Writes past the file size limit fail, the ones that cross it only partly.
+    std::signal(SIGXFSZ, SIG_IGN);
+    rlimit original{};
+    ASSERT_EQ(getrlimit(RLIMIT_FSIZE, &original), 0);
+    auto fail = [&](size_t slack, const std::function<void()>& request) {
+        rlimit limit = original;
+        limit.rlim_cur = std::filesystem::file_size(path) + slack;
+        ASSERT_EQ(setrlimit(RLIMIT_FSIZE, &limit), 0);
+        EXPECT_THROW(request(), std::runtime_error);
+        ASSERT_EQ(setrlimit(RLIMIT_FSIZE, &original), 0);
+    };
+    fail(0, [&]() {
+        DataBase.Insert("INSERT INTO suppliers VALUES (3, \"Sun\");");
+    });
+    fail(4, [&]() {
+        DataBase.UpdateRequest("UPDATE suppliers SET supplier_name = \"Dell\" WHERE supplier_id = 1;");
+    });
+    fail(0, [&]() {
+        DataBase.DeleteRequest("DELETE FROM suppliers WHERE supplier_id = 2;");
+    });
+    fail(0, [&]() {
+        DataBase.BulkInsert("suppliers", {{Parameter(3), Parameter(std::string("Sun"))}});
+    });
+    fail(0, [&]() {
+        PreparedStatement insert = DataBase.Prepare("INSERT INTO suppliers VALUES (?, \"Sun\");");
+        insert.Bind(0, 3);
+        insert.Execute();
+    });
+    fail(0, [&]() {
+        DataBase.CreateTable("CREATE TABLE stale (id INT);");
+    });
+    fail(0, [&]() {
+        DataBase.CreateIndex("CREATE INDEX suppliers_id ON suppliers(supplier_id);");
+    });
+    fail(0, [&]() {
+        DataBase.DropIndex("DROP INDEX suppliers_name;");
+    });
+    fail(0, [&]() {
+        DataBase.DropTable("DROP TABLE suppliers;");
+    });
+    ASSERT_EQ(print(DataBase), expected);
+    ASSERT_EQ(DataBase.Size(), 1);
+    ASSERT_THROW(DataBase.Insert("INSERT INTO suppliers VALUES (1, \"Copy\");"), std::logic_error);
+
+    DataBase.CreateIndex("CREATE INDEX suppliers_id ON suppliers(supplier_id);");
+    DataBase.UpdateRequest("UPDATE suppliers SET supplier_name = \"Dell\" WHERE supplier_id = 1;");
+    DataBase.Insert("INSERT INTO suppliers VALUES (3, \"Sun\");");
+    expected = print(DataBase);
+    ASSERT_EQ(expected, "2 HP \n1 Dell \n3 Sun \n");
+    DataBase.CloseLog();
+
+    class DataBase replayed("Test");
+    replayed.OpenLog(path);
+    ASSERT_EQ(print(replayed), expected);
+    ASSERT_EQ(replayed.Size(), 1);
+    testing::internal::CaptureStdout();
+    replayed.SelectRequest("SELECT supplier_id FROM suppliers WHERE supplier_name = \"Dell\";").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "1 \n");
+    replayed.CloseLog();
+    std::remove(path.c_str());
+#endif
+}
+
+TEST(DataBase, CheckpointTest) {
+    std::filesystem::path directory = std::filesystem::path(testing::TempDir()) / "checkpoint";
+    std::filesystem::remove_all(directory);
+    auto files = [&directory]() {
+        std::set<std::string> result;
+        for (const auto& i: std::filesystem::directory_iterator(directory)) {
+            result.insert(i.path().filename().string());
+        }
+        return result;
+    };
+    std::string expected = "0 IBM \n1 HP \n2 Dell \n125 0 \n126 1 \n127 2 \n";
+    {
+        DataBase DataBase("Test");
+        DataBase.Open(directory.string());
+        DataBase.CreateTable("CREATE TABLE suppliers (supplier_id INT PRIMARY KEY NOT NULL, supplier_name VARCHAR(20));");
+        DataBase.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, supplier_id INT);");
+        DataBase.CreateTable("CREATE TABLE stale (id INT);");
+        DataBase.Insert("INSERT INTO suppliers VALUES (0, \"IBM\"), (1, \"HP\");");
+        DataBase.Insert("INSERT INTO orders VALUES (125, 0), (126, 1);");
+        auto log_size = std::filesystem::file_size(directory / "wal.log");
+        DataBase.Checkpoint();
+        DataBase.Insert("INSERT INTO suppliers VALUES (2, \"Dell\");");
+        DataBase.WaitForCheckpoint();
+        ASSERT_LT(std::filesystem::file_size(directory / "wal.log"), log_size);
+        ASSERT_EQ(files(), std::set<std::string>({"MANIFEST", "wal.log", "suppliers.1.tbl", "orders.1.tbl", "stale.1.tbl"}));
+
+        DataBase.DropTable("DROP TABLE stale;");
+        DataBase.Checkpoint();
+        DataBase.WaitForCheckpoint();
+        ASSERT_EQ(files(), std::set<std::string>({"MANIFEST", "wal.log", "suppliers.2.tbl", "orders.1.tbl"}));
+        DataBase.Insert("INSERT INTO orders VALUES (127, 2);");
+    }
+
+    DataBase DataBase("Test");
+    DataBase.Open(directory.string());
+    ASSERT_EQ(DataBase.Size(), 2);
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT * FROM suppliers;").Print();
+    DataBase.SelectRequest("SELECT * FROM orders;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), expected);
+    ASSERT_THROW(DataBase.Insert("INSERT INTO orders VALUES (127, 0);"), std::logic_error);
+
+    DataBase.Checkpoint();
+    DataBase.WaitForCheckpoint();
+    ASSERT_EQ(files(), std::set<std::string>({"MANIFEST", "wal.log", "suppliers.2.tbl", "orders.3.tbl"}));
+    DataBase.CloseLog();
+    class DataBase reopened;
+    reopened.Open(directory.string());
+    testing::internal::CaptureStdout();
+    reopened.SelectRequest("SELECT * FROM suppliers;").Print();
+    reopened.SelectRequest("SELECT * FROM orders;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), expected);
+    reopened.CloseLog();
+    std::filesystem::remove_all(directory);
+}
+
+TEST(DataBase, ConcurrencyTest) {
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE suppliers (supplier_id INT PRIMARY KEY NOT NULL, supplier_name VARCHAR(20));");
+    DataBase.Insert("INSERT INTO suppliers VALUES (0, \"IBM\"), (1, \"HP\"), (2, \"Microsoft\");");
+    const int kThreads = 4;
+    const int kRows = 200;
+    std::vector<std::thread> threads;
+    std::atomic<int> found = 0;
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&DataBase, &found, i]() {
+            std::string table = "orders" + std::to_string(i);
+            DataBase.CreateTable("CREATE TABLE " + table + " (order_id INT PRIMARY KEY NOT NULL, supplier_id INT);");
+            PreparedStatement insert = DataBase.Prepare("INSERT INTO " + table + " VALUES (?, ?);");
+            PreparedStatement select = DataBase.Prepare("SELECT supplier_name FROM suppliers WHERE supplier_id = ?;");
+            for (int j = 0; j < kRows; ++j) {
+                insert.Bind(0, j);
+                insert.Bind(1, j % 3);
+                insert.Execute();
+                select.Bind(0, j % 3);
+                ResultSet result = select.Execute();
+                while (result.Next()) {
+                    ++found;
+                }
+            }
+        });
+    }
+    for (auto& i: threads) {
+        i.join();
+    }
+    ASSERT_EQ(found, kThreads * kRows);
+    ASSERT_EQ(DataBase.Size(), kThreads + 1);
+    for (int i = 0; i < kThreads; ++i) {
+        ResultSet result = DataBase.SelectRequest("SELECT * FROM orders" + std::to_string(i) + ";");
+        int rows = 0;
+        while (result.Next()) {
+            ++rows;
+        }
+        ASSERT_EQ(rows, kRows);
+    }
+}
+
+TEST(DataBase, MvccTest) {
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE suppliers (supplier_id INT PRIMARY KEY NOT NULL, supplier_name VARCHAR(20));");
+    DataBase.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, supplier_id INT, comment VARCHAR(20));");
+    DataBase.CreateIndex("CREATE INDEX orders_supplier ON orders(supplier_id);");
+    DataBase.Insert("INSERT INTO suppliers VALUES (0, \"IBM\"), (1, \"HP\");");
+    for (int i = 0; i < 100; ++i) {
+        DataBase.Insert("INSERT INTO orders VALUES (" + std::to_string(i) + ", " + std::to_string(i % 2) + ", \"old\");");
+    }
+
+    ResultSet scan = DataBase.SelectRequest("SELECT order_id, comment FROM orders;");
+    ResultSet join = DataBase.SelectRequest("SELECT order_id, supplier_name FROM orders JOIN suppliers "
+                                            "ON orders.supplier_id = suppliers.supplier_id;");
+    ResultSet probe = DataBase.SelectRequest("SELECT order_id FROM orders WHERE supplier_id = 1;");
+    std::thread writer([&DataBase]() {
+        for (int i = 100; i < 1000; ++i) {
+            DataBase.Insert("INSERT INTO orders VALUES (" + std::to_string(i) + ", 1, \"new\");");
+        }
+        DataBase.UpdateRequest("UPDATE orders SET comment = \"updated\" WHERE order_id < 50;");
+        DataBase.DeleteRequest("DELETE FROM orders WHERE supplier_id = 0;");
+        DataBase.DeleteRequest("DELETE FROM suppliers WHERE supplier_id = 1;");
+        DataBase.CollectGarbage();
+    });
+    writer.join();
+
+    int rows = 0;
+    while (scan.Next()) {
+        ASSERT_EQ(scan.Get<int>(0), rows++);
+        ASSERT_EQ(scan.Get<std::string_view>(1), "old");
+    }
+    ASSERT_EQ(rows, 100);
+    rows = 0;
+    while (join.Next()) {
+        ++rows;
+    }
+    ASSERT_EQ(rows, 100);
+    rows = 0;
+    while (probe.Next()) {
+        ++rows;
+    }
+    ASSERT_EQ(rows, 50);
+
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT order_id, comment FROM orders WHERE order_id < 4 OR order_id = 999;").Print();
+    DataBase.SelectRequest("SELECT * FROM suppliers;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "999 new \n1 updated \n3 updated \n0 IBM \n");
+    ASSERT_EQ(DataBase.GetTables()["orders"].Size(), 950);
+    ASSERT_EQ(DataBase.GetTables()["orders"].Garbage(), 0);
+}
+
+TEST(DataBase, ParallelScanTest) {
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, supplier_id INT, price DOUBLE);");
+    const int kRows = 300000;
+    std::vector<std::vector<Parameter>> rows;
+    for (int i = 0; i < kRows; ++i) {
+        rows.push_back({Parameter(i), Parameter(i % 7), Parameter(i % 100 * 0.5)});
+    }
+    DataBase.BulkInsert("orders", std::move(rows));
+
+    auto select = [&DataBase]() {
+        std::vector<int> ids;
+        ResultSet result = DataBase.SelectRequest("SELECT order_id FROM orders WHERE supplier_id = 3 AND price < 10.0;");
+        while (result.Next()) {
+            ids.push_back(result.Get<int>(0));
+        }
+        return ids;
+    };
+    DataBase.SetParallelism(1);
+    std::vector<int> serial = select();
+    DataBase.SetParallelism(4);
+    ASSERT_EQ(DataBase.Parallelism(), 4);
+    ASSERT_EQ(select(), serial);
+    ASSERT_TRUE(std::is_sorted(serial.begin(), serial.end()));
+    ASSERT_EQ(serial.size(), 8571);
+
+    DataBase.UpdateRequest("UPDATE orders SET price = 100.0 WHERE supplier_id = 3;");
+    DataBase.DeleteRequest("DELETE FROM orders WHERE supplier_id < 2;");
+    ASSERT_TRUE(select().empty());
+    ResultSet result = DataBase.SelectRequest("SELECT order_id FROM orders WHERE price > 99.0;");
+    int count = 0;
+    while (result.Next()) {
+        ASSERT_EQ(result.Get<int>(0) % 7, 3);
+        ++count;
+    }
+    ASSERT_EQ(count, 42857);
+    ASSERT_THROW(DataBase.SetParallelism(0), std::logic_error);
+}
+
+TEST(DataBase, FilterKernelTest) {
+    const size_t kRows = 1000;
+    std::vector<int> ints(kRows);
+    std::vector<int> other_ints(kRows);
+    std::vector<double> doubles(kRows);
+    std::vector<double> other_doubles(kRows);
+    for (size_t i = 0; i < kRows; ++i) {
+        ints[i] = static_cast<int>(i % 17) - 8;
+        other_ints[i] = static_cast<int>(i % 5) - 2;
+        doubles[i] = i % 11 == 0 ? std::nan("") : (static_cast<double>(i % 13) - 6) / 2;
+        other_doubles[i] = static_cast<double>(i % 3) - 1;
+    }
+    std::vector<float> floats(doubles.begin(), doubles.end());
+    std::vector<float> other_floats(other_doubles.begin(), other_doubles.end());
+    std::vector<CompareOperator> signs = {CompareOperator::EQUAL, CompareOperator::NOT_EQUAL, CompareOperator::LESS,
+                                          CompareOperator::GREATER, CompareOperator::LESS_EQUAL,
+                                          CompareOperator::GREATER_EQUAL};
+
+    auto check = [&](auto&& kernel, auto&& expected) {
+        std::vector<uint64_t> bits((kRows + 63) / 64, ~uint64_t(0));
+        kernel(bits.data());
+        for (size_t i = 0; i < bits.size() * 64; ++i) {
+            ASSERT_EQ((bits[i / 64] >> (i % 64)) & 1, i < kRows && expected(i)) << i;
+        }
+    };
+    InstructionSet best = BestInstructionSet();
+    for (auto set: {InstructionSet::SCALAR, InstructionSet::SSE2, InstructionSet::AVX2}) {
+        UseInstructionSet(set);
+        ASSERT_EQ(CurrentInstructionSet(), std::min(set, best));
+        for (auto sign: signs) {
+            check([&](uint64_t* bits) { CompareToConstant(ints.data(), kRows, sign, 3, bits); },
+                  [&](size_t i) { return Compare(Parameter(ints[i]), sign, Parameter(3)); });
+            check([&](uint64_t* bits) { CompareColumns(ints.data(), other_ints.data(), kRows, sign, bits); },
+                  [&](size_t i) { return Compare(Parameter(ints[i]), sign, Parameter(other_ints[i])); });
+            check([&](uint64_t* bits) { CompareToConstant(floats.data(), kRows, sign, 0.5f, bits); },
+                  [&](size_t i) { return Compare(Parameter(floats[i]), sign, Parameter(0.5f)); });
+            check([&](uint64_t* bits) { CompareColumns(floats.data(), other_floats.data(), kRows, sign, bits); },
+                  [&](size_t i) { return Compare(Parameter(floats[i]), sign, Parameter(other_floats[i])); });
+            check([&](uint64_t* bits) { CompareToConstant(doubles.data(), kRows, sign, -1.0, bits); },
+                  [&](size_t i) { return Compare(Parameter(doubles[i]), sign, Parameter(-1.0)); });
+            check([&](uint64_t* bits) { CompareColumns(doubles.data(), other_doubles.data(), kRows, sign, bits); },
+                  [&](size_t i) { return Compare(Parameter(doubles[i]), sign, Parameter(other_doubles[i])); });
+        }
+    }
+    UseInstructionSet(best);
+
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE items (id INT, price DOUBLE, weight FLOAT, sale BOOL, name VARCHAR(10), stock INT);");
+    std::vector<std::vector<Parameter>> rows;
+    for (int i = 0; i < 1000; ++i) {
+        Parameter price = i % 10 == 0 ? Parameter() : Parameter(i % 50 * 1.5);
+        rows.push_back({Parameter(i), price, Parameter(float(i % 7)), Parameter(i % 3 == 0),
+                        Parameter(std::string(i % 2 ? "a" : "b")), Parameter(i % 40)});
+    }
+    DataBase.BulkInsert("items", std::move(rows));
+    auto count = [&DataBase](const std::string& where) {
+        ResultSet result = DataBase.SelectRequest("SELECT id FROM items WHERE " + where + ";");
+        int rows = 0;
+        while (result.Next()) {
+            ++rows;
+        }
+        return rows;
+    };
+    for (auto set: {InstructionSet::SCALAR, best}) {
+        UseInstructionSet(set);
+        ASSERT_EQ(count("price < 15.0"), 180);
+        ASSERT_EQ(count("price <> 15.0"), 900);
+        ASSERT_EQ(count("sale = TRUE AND id >= 500"), 167);
+        ASSERT_EQ(count("sale = FALSE OR weight > 5.0"), 714);
+        ASSERT_EQ(count("stock >= id"), 40);
+        ASSERT_EQ(count("name = \"a\" AND (price > 70.0 OR id = 0)"), 40);
+        ASSERT_EQ(count("price = NULL OR id > 2000"), 0);
+    }
+    UseInstructionSet(best);
+}
+
+TEST(DataBase, DictionaryTest) {
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, status VARCHAR(10));");
+    DataBase.CreateTable("CREATE TABLE statuses (name VARCHAR(10), rank INT);");
+    std::vector<std::string> statuses = {"new", "paid", "shipped", "done", ""};
+    std::vector<std::vector<Parameter>> rows;
+    for (int i = 0; i < 10000; ++i) {
+        rows.push_back({Parameter(i), i % 6 == 5 ? Parameter() : Parameter(statuses[i % 6])});
+    }
+    DataBase.BulkInsert("orders", std::move(rows));
+    DataBase.Insert("INSERT INTO statuses VALUES (\"done\", 3), (\"lost\", 4), (\"new\", 0), (\"paid\", 1);");
+
+    Table& orders = DataBase.GetTables()["orders"];
+    TableSnapshot snapshot = orders.Read();
+    const Column& status = snapshot.GetColumn(1);
+    ASSERT_EQ(status.Entries(), 5);
+    ASSERT_EQ(status.Value<std::string_view>(2), "shipped");
+    ASSERT_EQ(status.Code(2), status.Code(8));
+    ASSERT_EQ(status.Find("lost"), Column::kNoCode);
+
+    auto count = [&DataBase](const std::string& request) {
+        ResultSet result = DataBase.SelectRequest(request);
+        int rows = 0;
+        while (result.Next()) {
+            ++rows;
+        }
+        return rows;
+    };
+    ASSERT_EQ(count("SELECT order_id FROM orders WHERE status = \"paid\";"), 1667);
+    ASSERT_EQ(count("SELECT order_id FROM orders WHERE status <> \"paid\";"), 6667);
+    ASSERT_EQ(count("SELECT order_id FROM orders WHERE status = \"lost\";"), 0);
+    ASSERT_EQ(count("SELECT order_id FROM orders WHERE status <> \"lost\";"), 8334);
+    ASSERT_EQ(count("SELECT order_id FROM orders WHERE status IN (\"new\", \"done\", \"lost\");"), 3334);
+    ASSERT_EQ(count("SELECT order_id FROM orders WHERE status = \"\" AND order_id < 100;"), 16);
+    ASSERT_EQ(count("SELECT order_id, rank FROM orders JOIN statuses ON orders.status = statuses.name;"), 5001);
+    ASSERT_EQ(count("SELECT order_id, rank FROM statuses LEFT JOIN orders ON statuses.name = orders.status;"), 5002);
+
+    PreparedStatement select = DataBase.Prepare("SELECT order_id FROM orders WHERE status = ?;");
+    for (const auto& i: {std::pair<std::string, int>{"shipped", 1667}, {"paid", 1667}, {"lost", 0}}) {
+        select.Bind(0, i.first);
+        ResultSet result = select.Execute();
+        int rows = 0;
+        while (result.Next()) {
+            ++rows;
+        }
+        ASSERT_EQ(rows, i.second);
+    }
+
+    DataBase.UpdateRequest("UPDATE orders SET status = \"lost\" WHERE status = \"new\";");
+    DataBase.DeleteRequest("DELETE FROM orders WHERE status IN (\"paid\", \"done\");");
+    DataBase.CollectGarbage();
+    ASSERT_EQ(count("SELECT order_id FROM orders WHERE status = \"lost\";"), 1667);
+    ASSERT_EQ(count("SELECT order_id FROM orders;"), 10000 - 2 * 1667);
+    ASSERT_EQ(orders.Read().GetColumn(1).Entries(), 3);
+}
+
+TEST(DataBase, NullTest) {
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE items (id INT PRIMARY KEY NOT NULL, price DOUBLE, name VARCHAR(10));");
+    DataBase.CreateTable("CREATE TABLE owners (item_id INT, owner VARCHAR(10));");
+    std::vector<std::vector<Parameter>> rows;
+    std::vector<std::vector<Parameter>> owners;
+    for (int i = 0; i < 1000; ++i) {
+        rows.push_back({Parameter(i), i % 10 == 0 ? Parameter() : Parameter(i * 0.5),
+                        i % 7 == 0 ? Parameter() : Parameter(std::string(i % 2 ? "odd" : "even"))});
+        if (i % 2 == 0) {
+            owners.push_back({Parameter(i), Parameter(std::string("owner"))});
+        }
+    }
+    DataBase.BulkInsert("items", std::move(rows));
+    DataBase.BulkInsert("owners", std::move(owners));
+    auto count = [&DataBase](const std::string& request) {
+        ResultSet result = DataBase.SelectRequest(request);
+        int rows = 0;
+        while (result.Next()) {
+            ++rows;
+        }
+        return rows;
+    };
+    ASSERT_EQ(count("SELECT id FROM items WHERE price IS NULL;"), 100);
+    ASSERT_EQ(count("SELECT id FROM items WHERE price IS NOT NULL;"), 900);
+    ASSERT_EQ(count("SELECT id FROM items WHERE price IS NULL AND name IS NULL;"), 15);
+    ASSERT_EQ(count("SELECT id FROM items WHERE price is null OR name is null;"), 228);
+    ASSERT_EQ(count("SELECT id FROM items WHERE price IS NOT NULL AND id < 100;"), 90);
+    ASSERT_EQ(count("SELECT id FROM items WHERE name IS NOT NULL AND name <> \"odd\";"), 428);
+    ASSERT_EQ(count("SELECT id FROM items WHERE id IS NULL OR price = NULL;"), 0);
+    ASSERT_EQ(count("SELECT id FROM items WHERE NULL IS NULL;"), 1000);
+    ASSERT_EQ(count("SELECT id FROM items WHERE 5 IS NULL;"), 0);
+    ASSERT_EQ(count("SELECT id FROM items WHERE id = 10 AND price IS NULL;"), 1);
+    ASSERT_EQ(count("SELECT items.id FROM items LEFT JOIN owners ON items.id = owners.item_id "
+                    "WHERE owners.item_id IS NULL;"), 500);
+    ASSERT_THROW(count("SELECT id FROM items WHERE id IS 5;"), std::runtime_error);
+
+    DataBase.UpdateRequest("UPDATE items SET price = 1.0 WHERE price IS NULL;");
+    DataBase.UpdateRequest("UPDATE items SET name = NULL WHERE id < 10;");
+    ASSERT_EQ(count("SELECT id FROM items WHERE price IS NULL;"), 0);
+    ASSERT_EQ(count("SELECT id FROM items WHERE name IS NULL;"), 151);
+    DataBase.DeleteRequest("DELETE FROM items WHERE name IS NULL;");
+    ASSERT_EQ(count("SELECT id FROM items WHERE name IS NOT NULL;"), 849);
+}
+
+TEST(DataBase, CompactionTest) {
+    BTree<int, size_t, 4> tree;
+    std::vector<BTree<int, size_t, 4>::Entry> entries;
+    for (size_t i = 0; i < 1000; ++i) {
+        entries.emplace_back(static_cast<int>(i % 10), i);
+    }
+    tree.Build(std::move(entries));
+    // Every third row is dropped and the rest move down.
+    tree.Remap([](size_t& row) {
+        bool is_kept = row % 3 != 0;
+        row -= (row + 2) / 3;
+        return is_kept;
+    });
+    ASSERT_EQ(tree.Size(), 666);
+    tree.Insert(4, 1000);
+    ASSERT_TRUE(tree.Erase(4, 2));
+    int key = 4;
+    std::vector<size_t> rows;
+    tree.Scan(&key, true, &key, true, [&rows](size_t row) {
+        rows.push_back(row);
+    });
+    std::vector<size_t> expected;
+    for (size_t i = 4; i < 1000; i += 10) {
+        if (i % 3 != 0 && i != 4) {
+            expected.push_back(i - (i + 2) / 3);
+        }
+    }
+    expected.push_back(1000);
+    ASSERT_EQ(rows, expected);
+
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE orders (order_id INT PRIMARY KEY NOT NULL, supplier_id INT, price DOUBLE);");
+    DataBase.CreateIndex("CREATE INDEX orders_price ON orders (price);");
+    std::vector<std::vector<Parameter>> batch;
+    for (int i = 0; i < 20000; ++i) {
+        batch.push_back({Parameter(i), Parameter(i % 10), Parameter(i % 100 * 0.5)});
+    }
+    DataBase.BulkInsert("orders", std::move(batch));
+    DataBase.DeleteRequest("DELETE FROM orders WHERE supplier_id < 3;");
+    DataBase.CollectGarbage();
+    Table& orders = DataBase.GetTables()["orders"];
+    ASSERT_EQ(orders.Size(), 14000);
+    ASSERT_EQ(orders.Garbage(), 0);
+
+    auto count = [&DataBase](const std::string& where) {
+        ResultSet result = DataBase.SelectRequest("SELECT order_id FROM orders WHERE " + where + ";");
+        int rows = 0;
+        while (result.Next()) {
+            ++rows;
+        }
+        return rows;
+    };
+    ASSERT_EQ(count("price = 22.5"), 200);
+    ASSERT_EQ(count("price >= 49.0"), 400);
+    ASSERT_EQ(count("price < 1.5"), 0);
+    ASSERT_EQ(count("order_id = 13"), 1);
+    ASSERT_EQ(count("order_id = 12"), 0);
+    DataBase.Insert("INSERT INTO orders VALUES (12, 2, 1.0);");
+    ASSERT_THROW(DataBase.Insert("INSERT INTO orders VALUES (13, 3, 1.0);"), std::logic_error);
+    DataBase.UpdateRequest("UPDATE orders SET price = 0.5 WHERE order_id = 15;");
+    ASSERT_EQ(count("price = 0.5"), 1);
+    ASSERT_EQ(count("price < 1.5"), 2);
+    ASSERT_EQ(count("order_id = 12 AND price = 1.0"), 1);
+
+    DataBase.CreateTable("CREATE TABLE suppliers (supplier_id INT PRIMARY KEY NOT NULL, supplier_name VARCHAR(20));");
+    DataBase.CreateIndex("CREATE INDEX suppliers_name ON suppliers (supplier_name);");
+    DataBase.Insert("INSERT INTO suppliers VALUES (1, \"IBM\"), (2, \"HP\"), (3, \"Sun\");");
+    DataBase.UpdateRequest("UPDATE suppliers SET supplier_name = \"Dell\" WHERE supplier_id = 1;");
+    DataBase.CollectGarbage();
+    testing::internal::CaptureStdout();
+    for (const char* name: {"Dell", "HP", "IBM", "Sun"}) {
+        DataBase.SelectRequest(std::string("SELECT supplier_id FROM suppliers WHERE supplier_name = \"") + name +
+                               "\";").Print();
+    }
+    ASSERT_EQ(testing::internal::GetCapturedStdout(), "1 \n2 \n3 \n");
+}
+
+TEST(DataBase, AggregateTest) {
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE sales (id INT PRIMARY KEY NOT NULL, region VARCHAR(10), amount INT, "
+                         "price DOUBLE, paid BOOL);");
+    DataBase.CreateTable("CREATE TABLE regions (name VARCHAR(10), manager VARCHAR(10));");
+    std::vector<std::string> regions = {"north", "south", "east", "west", "center"};
+    std::vector<std::vector<Parameter>> rows;
+    for (int i = 0; i < 200000; ++i) {
+        rows.push_back({Parameter(i), Parameter(regions[i % 5]), Parameter(i % 100),
+                        i % 10 == 0 ? Parameter() : Parameter(i % 37 * 0.5), Parameter(i % 3 == 0)});
+    }
+    DataBase.BulkInsert("sales", std::move(rows));
+    DataBase.Insert("INSERT INTO regions VALUES (\"north\", \"A\"), (\"south\", \"A\"), (\"east\", \"B\"), "
+                    "(\"west\", \"B\");");
+
+    for (size_t parallelism: {1, 4}) {
+        DataBase.SetParallelism(parallelism);
+        ResultSet total = DataBase.SelectRequest("SELECT COUNT(*), count(price), SUM(amount), MIN(price), MAX(price), "
+                                                 "AVG(amount), MIN(region) FROM sales;");
+        ASSERT_EQ(total.GetColumns()[0].name, "COUNT(*)");
+        ASSERT_EQ(total.GetColumns()[2].name, "SUM(amount)");
+        ASSERT_EQ(total.GetColumns()[2].type, TYPE::INT);
+        ASSERT_EQ(total.GetColumns()[5].type, TYPE::DOUBLE);
+        ASSERT_TRUE(total.Next());
+        ASSERT_EQ(total.Get<int>(0), 200000);
+        ASSERT_EQ(total.Get<int>(1), 180000);
+        ASSERT_EQ(total.Get<int>(2), 9900000);
+        ASSERT_EQ(total.Get<double>(3), 0.0);
+        ASSERT_EQ(total.Get<double>(4), 18.0);
+        ASSERT_EQ(total.Get<double>(5), 49.5);
+        ASSERT_EQ(total.Get<std::string_view>(6), "center");
+        ASSERT_FALSE(total.Next());
+
+        ResultSet groups = DataBase.SelectRequest("SELECT region, COUNT(*), SUM(amount), MAX(id) FROM sales "
+                                                  "GROUP BY region;");
+        std::vector<std::tuple<std::string, int, int, int>> expected = {
+                {"north", 40000, 1900000, 199995}, {"south", 40000, 1940000, 199996}, {"east", 40000, 1980000, 199997},
+                {"west", 40000, 2020000, 199998}, {"center", 40000, 2060000, 199999}};
+        for (const auto& i: expected) {
+            ASSERT_TRUE(groups.Next());
+            ASSERT_EQ(groups.Get<std::string_view>(0), std::get<0>(i));
+            ASSERT_EQ(groups.Get<int>(1), std::get<1>(i));
+            ASSERT_EQ(groups.Get<int>(2), std::get<2>(i));
+            ASSERT_EQ(groups.Get<int>(3), std::get<3>(i));
+        }
+        ASSERT_FALSE(groups.Next());
+
+        ResultSet paid = DataBase.SelectRequest("SELECT SUM(amount), region, COUNT(*) FROM sales WHERE paid = TRUE "
+                                                "GROUP BY paid, region;");
+        std::vector<std::tuple<std::string, int, int>> expected_paid = {
+                {"north", 13334, 633365}, {"west", 13334, 673367}, {"south", 13333, 646668},
+                {"center", 13333, 686667}, {"east", 13333, 659966}};
+        for (const auto& i: expected_paid) {
+            ASSERT_TRUE(paid.Next());
+            ASSERT_EQ(paid.Get<std::string_view>(1), std::get<0>(i));
+            ASSERT_EQ(paid.Get<int>(2), std::get<1>(i));
+            ASSERT_EQ(paid.Get<int>(0), std::get<2>(i));
+        }
+        ASSERT_FALSE(paid.Next());
+
+        ResultSet managers = DataBase.SelectRequest("SELECT manager, COUNT(*), SUM(amount), MIN(id), MAX(id) FROM sales "
+                                                    "JOIN regions ON sales.region = regions.name GROUP BY manager;");
+        for (const auto& i: {std::tuple<std::string, int, int, int, int>{"A", 80000, 3840000, 0, 199996},
+                             {"B", 80000, 4000000, 2, 199998}}) {
+            ASSERT_TRUE(managers.Next());
+            ASSERT_EQ(managers.Get<std::string_view>(0), std::get<0>(i));
+            ASSERT_EQ(managers.Get<int>(1), std::get<1>(i));
+            ASSERT_EQ(managers.Get<int>(2), std::get<2>(i));
+            ASSERT_EQ(managers.Get<int>(3), std::get<3>(i));
+            ASSERT_EQ(managers.Get<int>(4), std::get<4>(i));
+        }
+        ASSERT_FALSE(managers.Next());
+    }
+
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT region, COUNT(*) FROM sales WHERE id < 7 GROUP BY region;").Print();
+    DataBase.SelectRequest("SELECT price, COUNT(*), AVG(price) FROM sales WHERE id < 12 AND price IS NULL OR id = 1 "
+                           "GROUP BY price;").Print();
+    DataBase.SelectRequest("SELECT COUNT(*), SUM(amount), MAX(region) FROM sales WHERE id < 0;").Print();
+    DataBase.SelectRequest("SELECT region, COUNT(*) FROM sales WHERE id < 0 GROUP BY region;").Print();
+    DataBase.SelectRequest("SELECT manager, COUNT(*), SUM(amount) FROM sales JOIN regions "
+                           "ON sales.region = regions.name GROUP BY manager;").Print();
+    DataBase.SelectRequest("SELECT regions.manager, COUNT(*) FROM sales LEFT JOIN regions "
+                           "ON sales.region = regions.name WHERE amount < 10 GROUP BY regions.manager;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(),
+              "north 2 \nsouth 2 \neast 1 \nwest 1 \ncenter 1 \n"
+              "NULL 2 NULL \n0.5 1 0.5 \n"
+              "0 NULL NULL \n"
+              "A 80000 3840000 \nB 80000 4000000 \n"
+              "A 8000 \nB 8000 \nNULL 4000 \n");
+
+    PreparedStatement count = DataBase.Prepare("SELECT COUNT(*) FROM sales WHERE amount >= ?;");
+    count.Bind(0, 90);
+    ResultSet result = count.Execute();
+    ASSERT_TRUE(result.Next());
+    ASSERT_EQ(result.Get<int>(0), 20000);
+
+    ASSERT_THROW(DataBase.SelectRequest("SELECT region, COUNT(*) FROM sales;"), std::logic_error);
+    ASSERT_THROW(DataBase.SelectRequest("SELECT id, COUNT(*) FROM sales GROUP BY region;"), std::logic_error);
+    ASSERT_THROW(DataBase.SelectRequest("SELECT SUM(region) FROM sales;"), std::logic_error);
+    ASSERT_THROW(DataBase.SelectRequest("SELECT SUM(*) FROM sales;"), std::runtime_error);
+    ASSERT_THROW(DataBase.SelectRequest("SELECT MEDIAN(amount) FROM sales;"), std::runtime_error);
+}
+
+TEST(DataBase, OrderTest) {
+    DataBase DataBase("Test");
+    DataBase.CreateTable("CREATE TABLE items (id INT PRIMARY KEY NOT NULL, name VARCHAR(10), score DOUBLE, grp INT);");
+    DataBase.CreateTable("CREATE TABLE groups (grp INT, label VARCHAR(10));");
+    struct Item {
+        int id;
+        std::string name;
+        std::optional<double> score;
+        int grp;
+    };
+    std::vector<Item> items;
+    std::vector<std::vector<Parameter>> rows;
+    for (int i = 0; i < 200000; ++i) {
+        Item item{i, "n" + std::to_string(i * 31 % 997), std::nullopt, i % 10};
+        if (i % 50 != 0) {
+            item.score = (i * 7919 % 1000) * 0.5 - 100;
+        }
+        rows.push_back({Parameter(item.id), Parameter(item.name), item.score ? Parameter(*item.score) : Parameter(),
+                        Parameter(item.grp)});
+        items.push_back(std::move(item));
+    }
+    DataBase.BulkInsert("items", std::move(rows));
+    DataBase.Insert("INSERT INTO groups VALUES (1, \"one\"), (2, \"two\"), (3, \"three\");");
+
+    // NULL scores are greater than every score; equal keys keep the id order.
+    auto by_score = [](const Item& first, const Item& second) {
+        if (first.score != second.score) {
+            return !second.score.has_value() || (first.score.has_value() && *first.score < *second.score);
+        }
+        return first.id < second.id;
+    };
+    auto ids = [](ResultSet result) {
+        std::vector<int> ids;
+        while (result.Next()) {
+            ids.push_back(result.Get<int>(0));
+        }
+        return ids;
+    };
+
+    std::vector<Item> sorted = items;
+    std::sort(sorted.begin(), sorted.end(), by_score);
+    std::vector<int> ascending;
+    for (const auto& i: sorted) {
+        ascending.push_back(i.id);
+    }
+    std::vector<int> descending;
+    std::sort(sorted.begin(), sorted.end(), [&](const Item& first, const Item& second) {
+        if (first.score == second.score) {
+            return first.id < second.id;
+        }
+        return by_score(second, first);
+    });
+    for (const auto& i: sorted) {
+        descending.push_back(i.id);
+    }
+
+    std::vector<int> by_name;
+    for (const auto& i: items) {
+        if (i.grp == 3) {
+            by_name.push_back(i.id);
+        }
+    }
+    std::sort(by_name.begin(), by_name.end(), [&](int first, int second) {
+        const Item& left = items[first];
+        const Item& right = items[second];
+        if (left.name != right.name) {
+            return left.name < right.name;
+        }
+        if (left.score != right.score) {
+            return by_score(right, left);
+        }
+        return first < second;
+    });
+
+    for (size_t parallelism: {1, 4}) {
+        DataBase.SetParallelism(parallelism);
+        ASSERT_EQ(ids(DataBase.SelectRequest("SELECT id FROM items ORDER BY score;")), ascending);
+        ASSERT_EQ(ids(DataBase.SelectRequest("SELECT id FROM items ORDER BY score DESC LIMIT 20 OFFSET 5;")),
+                  std::vector<int>(descending.begin() + 5, descending.begin() + 25));
+        ASSERT_EQ(ids(DataBase.SelectRequest("SELECT id FROM items WHERE grp = 3 ORDER BY name ASC, score DESC;")),
+                  by_name);
+        ASSERT_EQ(ids(DataBase.SelectRequest("SELECT id FROM items WHERE grp = 3 ORDER BY name, score DESC "
+                                             "LIMIT 1000;")),
+                  std::vector<int>(by_name.begin(), by_name.begin() + 1000));
+    }
+
+    DataBase.CreateIndex("CREATE INDEX items_score ON items (score);");
+    ASSERT_EQ(ids(DataBase.SelectRequest("SELECT id FROM items ORDER BY score;")), ascending);
+    ASSERT_EQ(ids(DataBase.SelectRequest("SELECT id FROM items ORDER BY score LIMIT 10 OFFSET 3;")),
+              std::vector<int>(ascending.begin() + 3, ascending.begin() + 13));
+    ASSERT_EQ(ids(DataBase.SelectRequest("SELECT id FROM items ORDER BY score OFFSET 199990;")),
+              std::vector<int>(ascending.begin() + 199990, ascending.end()));
+    std::vector<int> high;
+    for (int i: ascending) {
+        if (items[i].score.has_value() && *items[i].score > 350 && items[i].grp == 1) {
+            high.push_back(i);
+        }
+    }
+    ASSERT_EQ(ids(DataBase.SelectRequest("SELECT id FROM items WHERE score > 350 AND grp = 1 ORDER BY score "
+                                         "LIMIT 7;")),
+              std::vector<int>(high.begin(), high.begin() + 7));
+    DataBase.DeleteRequest("DELETE FROM items WHERE id = " + std::to_string(ascending[0]) + ";");
+    ASSERT_EQ(ids(DataBase.SelectRequest("SELECT id FROM items ORDER BY score LIMIT 2;")),
+              std::vector<int>(ascending.begin() + 1, ascending.begin() + 3));
+
+    ASSERT_EQ(ids(DataBase.SelectRequest("SELECT id FROM items WHERE grp = 7 LIMIT 3 OFFSET 2;")),
+              std::vector<int>({27, 37, 47}));
+    ASSERT_TRUE(ids(DataBase.SelectRequest("SELECT id FROM items LIMIT 0;")).empty());
+
+    testing::internal::CaptureStdout();
+    DataBase.SelectRequest("SELECT grp, COUNT(*), MAX(id) FROM items WHERE id < 25 GROUP BY grp "
+                           "ORDER BY COUNT(*), MAX(id) DESC LIMIT 4;").Print();
+    DataBase.SelectRequest("SELECT label, id FROM items JOIN groups ON items.grp = groups.grp WHERE id < 30 "
+                           "ORDER BY label DESC, id DESC LIMIT 4 OFFSET 1;").Print();
+    ASSERT_EQ(testing::internal::GetCapturedStdout(),
+              "9 2 19 \n8 2 18 \n7 2 17 \n6 2 16 \n"
+              "two 12 \ntwo 2 \nthree 23 \nthree 13 \n");
+
+    PreparedStatement top = DataBase.Prepare("SELECT id FROM items WHERE grp = ? ORDER BY id DESC LIMIT ?;");
+    top.Bind(0, 2);
+    top.Bind(1, 3);
+    ASSERT_EQ(ids(top.Execute()), std::vector<int>({199992, 199982, 199972}));
+    top.Bind(1, -1);
+    ASSERT_THROW(top.Execute(), std::logic_error);
+
+    ASSERT_THROW(DataBase.SelectRequest("SELECT id FROM items LIMIT \"ten\";"), std::logic_error);
+    ASSERT_THROW(DataBase.SelectRequest("SELECT id FROM items ORDER BY missing;"), std::logic_error);
+    ASSERT_THROW(DataBase.SelectRequest("SELECT grp, COUNT(*) FROM items GROUP BY grp ORDER BY SUM(id);"),
+                 std::logic_error);
+    ASSERT_THROW(DataBase.SelectRequest("SELECT id FROM items ORDER BY *;"), std::runtime_error);
+}